@@ -0,0 +1,260 @@
+/*
+ * Checks NimBLEAdvFieldIndex against the payload walk NimBLEAdvertisedDevice::findAdvField used to do, over random
+ * and malformed payloads, then times the lookups a scan callback makes for each advertising report both ways.
+ *
+ *   ./build/adv_field_index_bench [fuzz iterations]
+ *
+ * Exits with 1 on the first lookup that differs.
+ */
+#include <chrono>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "NimBLEAdvFieldIndex.h"
+
+// an advertisement and its scan response, or one extended report
+#define LEGACY_PAYLOAD_MAX_LEN 62
+#define EXT_PAYLOAD_MAX_LEN 255
+
+#define ADV_TYPE_FLAGS 0x01
+#define ADV_TYPE_INCOMP_UUIDS16 0x02
+#define ADV_TYPE_COMP_UUIDS16 0x03
+#define ADV_TYPE_INCOMP_UUIDS32 0x04
+#define ADV_TYPE_COMP_UUIDS32 0x05
+#define ADV_TYPE_INCOMP_UUIDS128 0x06
+#define ADV_TYPE_COMP_UUIDS128 0x07
+#define ADV_TYPE_INCOMP_NAME 0x08
+#define ADV_TYPE_COMP_NAME 0x09
+#define ADV_TYPE_TX_PWR_LVL 0x0a
+#define ADV_TYPE_SVC_DATA_UUID16 0x16
+#define ADV_TYPE_PUBLIC_TGT_ADDR 0x17
+#define ADV_TYPE_RANDOM_TGT_ADDR 0x18
+#define ADV_TYPE_APPEARANCE 0x19
+#define ADV_TYPE_MFG_DATA 0xff
+
+/* findAdvField before the index, verbatim apart from taking the payload as arguments */
+static uint8_t walk_find(const uint8_t* payload, size_t payload_length, uint8_t type, uint8_t index = 0,
+                         size_t* data_loc = nullptr) {
+    const uint8_t* field = nullptr;
+    size_t length = payload_length;
+    size_t data = 0;
+    uint8_t count = 0;
+
+    if (length < 3) {
+        return count;
+    }
+
+    while (length > 2) {
+        field = &payload[data];
+
+        if (field[0] >= length) {
+            return count;
+        }
+
+        if (field[1] == type) {
+            switch (type) {
+                case ADV_TYPE_INCOMP_UUIDS16:
+                case ADV_TYPE_COMP_UUIDS16:
+                    count += field[0] / 2;
+                    break;
+
+                case ADV_TYPE_INCOMP_UUIDS32:
+                case ADV_TYPE_COMP_UUIDS32:
+                    count += field[0] / 4;
+                    break;
+
+                case ADV_TYPE_INCOMP_UUIDS128:
+                case ADV_TYPE_COMP_UUIDS128:
+                    count += field[0] / 16;
+                    break;
+
+                case ADV_TYPE_PUBLIC_TGT_ADDR:
+                case ADV_TYPE_RANDOM_TGT_ADDR:
+                    count += field[0] / 6;
+                    break;
+
+                default:
+                    count++;
+                    break;
+            }
+
+            if (data_loc != nullptr) {
+                if (index == 0 || count >= index) {
+                    break;
+                }
+            }
+        }
+
+        length -= 1 + field[0];
+        data += 1 + field[0];
+    }
+
+    if (data_loc != nullptr && field != nullptr) {
+        *data_loc = data;
+    }
+
+    return count;
+}
+
+static const uint8_t common_types[] = {
+    ADV_TYPE_FLAGS,         ADV_TYPE_INCOMP_UUIDS16,  ADV_TYPE_COMP_UUIDS16,    ADV_TYPE_INCOMP_UUIDS32,
+    ADV_TYPE_COMP_UUIDS32,  ADV_TYPE_INCOMP_UUIDS128, ADV_TYPE_COMP_UUIDS128,   ADV_TYPE_COMP_NAME,
+    ADV_TYPE_TX_PWR_LVL,    ADV_TYPE_SVC_DATA_UUID16, ADV_TYPE_PUBLIC_TGT_ADDR, ADV_TYPE_RANDOM_TGT_ADDR,
+    ADV_TYPE_APPEARANCE,    ADV_TYPE_MFG_DATA,
+};
+
+/* Well formed AD structures of common types, sometimes cut short or with a corrupted length byte */
+static size_t make_payload(std::mt19937& rng, uint8_t* payload, size_t max_length) {
+    size_t length = 0;
+
+    if (rng() % 8 == 0) {
+        length = rng() % (max_length + 1);
+        for (size_t i = 0; i < length; i++) {
+            payload[i] = rng();
+        }
+        return length;
+    }
+
+    while (length < max_length) {
+        size_t field_length = 1 + rng() % 20;
+        if (rng() % 16 == 0) {
+            field_length = 0;
+        }
+        if (length + 1 + field_length > max_length) {
+            field_length = max_length - length - 1;
+        }
+
+        payload[length] = field_length;
+        if (field_length > 0) {
+            payload[length + 1] = common_types[rng() % sizeof(common_types)];
+            for (size_t i = 2; i <= field_length; i++) {
+                payload[length + i] = rng();
+            }
+        }
+        length += 1 + field_length;
+
+        if (rng() % 4 == 0) {
+            break;
+        }
+    }
+
+    if (length > 0 && rng() % 8 == 0) {
+        length = rng() % length;
+    }
+    if (length > 0 && rng() % 8 == 0) {
+        payload[rng() % length] = rng();
+    }
+    return length;
+}
+
+template <size_t N>
+static void fuzz(std::mt19937& rng, unsigned iterations) {
+    uint8_t payload[N];
+    NimBLEAdvFieldIndex<N> index;
+
+    for (unsigned it = 0; it < iterations; it++) {
+        size_t length = make_payload(rng, payload, N);
+        index.build(payload, length);
+
+        for (unsigned type = 0; type < 256; type++) {
+            if (walk_find(payload, length, type) != index.find(payload, type)) {
+                fprintf(stderr, "count of type 0x%02x differs, payload of %zu bytes\n", type, length);
+                exit(1);
+            }
+
+            for (uint8_t i = 0; i < 8; i++) {
+                size_t walk_loc = SIZE_MAX, index_loc = SIZE_MAX;
+                uint8_t walk_count = walk_find(payload, length, type, i, &walk_loc);
+                uint8_t index_count = index.find(payload, type, i, &index_loc);
+                if (walk_count != index_count || walk_loc != index_loc) {
+                    fprintf(stderr, "type 0x%02x index %u: walk %u at %zu, index %u at %zu, payload of %zu bytes\n",
+                            type, i, walk_count, walk_loc, index_count, index_loc, length);
+                    exit(1);
+                }
+            }
+        }
+    }
+}
+
+/* Every report brings a new payload, keep the compiler from hoisting lookups out of the loop */
+static inline void clobber(void* p) { asm volatile("" : : "r"(p) : "memory"); }
+
+/* The finds a scan callback filtering on name, services and manufacturer data costs per report */
+template <typename Find>
+static unsigned lookups_per_report(Find find) {
+    unsigned sum = 0;
+    size_t loc;
+
+    // haveServiceUUID(), getServiceUUIDCount()
+    for (uint8_t type = ADV_TYPE_INCOMP_UUIDS16; type <= ADV_TYPE_COMP_UUIDS128; type++) {
+        sum += find(type, 0, nullptr);
+    }
+    // isAdvertisingService() over each of the advertised UUIDs, through getServiceUUID(i)
+    for (uint8_t i = 1; i <= 3; i++) {
+        for (uint8_t type = ADV_TYPE_INCOMP_UUIDS16; type <= ADV_TYPE_COMP_UUIDS128; type++) {
+            sum += find(type, i, &loc);
+        }
+    }
+    // haveName(), getName()
+    sum += find(ADV_TYPE_COMP_NAME, 0, nullptr) + find(ADV_TYPE_INCOMP_NAME, 0, nullptr);
+    sum += find(ADV_TYPE_COMP_NAME, 0, &loc);
+    // haveManufacturerData(), getManufacturerData()
+    sum += find(ADV_TYPE_MFG_DATA, 0, nullptr) + find(ADV_TYPE_MFG_DATA, 0, &loc);
+    // getTXPower()
+    sum += find(ADV_TYPE_TX_PWR_LVL, 0, &loc);
+
+    return sum;
+}
+
+int main(int argc, char** argv) {
+    unsigned iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+
+    std::mt19937 rng(1);
+    fuzz<LEGACY_PAYLOAD_MAX_LEN>(rng, iterations);
+    fuzz<EXT_PAYLOAD_MAX_LEN>(rng, iterations / 4);
+    printf("%u random payloads: index matches the payload walk\n", iterations + iterations / 4);
+
+    // flags, a 16-bit and a 128-bit service list, a name, manufacturer data and the scan response's TX power
+    static uint8_t advertisement[LEGACY_PAYLOAD_MAX_LEN] = {
+        0x02, ADV_TYPE_FLAGS, 0x06,
+        0x03, ADV_TYPE_COMP_UUIDS16, 0x0f, 0x18,
+        0x11, ADV_TYPE_COMP_UUIDS128, 0x00, 0xc7, 0xc4, 0x4e, 0xe3, 0x6c, 0x51, 0xa7,
+        0x33, 0x4b, 0xe8, 0xed, 0x5a, 0x0e, 0xb8, 0x03,
+        0x05, ADV_TYPE_COMP_NAME, 'P', 'i', 'a', 'n',
+        0x05, ADV_TYPE_MFG_DATA, 0x4c, 0x00, 0x02, 0x15,
+        0x02, ADV_TYPE_TX_PWR_LVL, 0x04,
+    };
+    const size_t length = 42;
+    const unsigned reports = 1000000;
+
+    volatile unsigned sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned r = 0; r < reports; r++) {
+        clobber(advertisement);
+        sink += lookups_per_report([&](uint8_t type, uint8_t i, size_t* loc) {
+            return walk_find(advertisement, length, type, i, loc);
+        });
+    }
+    double walk_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    NimBLEAdvFieldIndex<LEGACY_PAYLOAD_MAX_LEN> index;
+    start = std::chrono::steady_clock::now();
+    for (unsigned r = 0; r < reports; r++) {
+        // the index is rebuilt for every report, as setPayload() does
+        clobber(advertisement);
+        index.build(advertisement, length);
+        sink += lookups_per_report([&](uint8_t type, uint8_t i, size_t* loc) {
+            return index.find(advertisement, type, i, loc);
+        });
+    }
+    double index_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    printf("getters per report: walk %.1f ns, index %.1f ns including the build\n", walk_ns / reports,
+           index_ns / reports);
+
+    return 0;
+}
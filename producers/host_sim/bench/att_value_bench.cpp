@@ -0,0 +1,190 @@
+/*
+ * Checks the heap allocations NimBLEAttValue makes for values around its inline length, then counts allocations and
+ * times the read, notify and getValue() paths of a remote characteristic.
+ *
+ *   ./build/att_value_bench
+ *   ./build/att_value_bench_heap    (the same with CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH 0, every value on the heap)
+ *
+ * Exits with 1 on the first check that fails.
+ */
+// everything NimBLEAttValue.h pulls in comes before the allocation macros below
+#include <assert.h>
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+// what the stack's headers provide to the files that include NimBLEAttValue.h
+#define BLE_ATT_ATTR_MAX_LEN 512
+static inline uint32_t ble_npl_hw_enter_critical() { return 0; }
+static inline void ble_npl_hw_exit_critical(uint32_t ctx) {}
+
+static unsigned s_allocs = 0;
+static long s_live = 0;
+
+static void* counted_malloc(size_t size) {
+    s_allocs++;
+    s_live++;
+    return malloc(size);
+}
+
+static void* counted_calloc(size_t n, size_t size) {
+    s_allocs++;
+    s_live++;
+    return calloc(n, size);
+}
+
+static void* counted_realloc(void* p, size_t size) {
+    s_allocs++;
+    s_live += p == NULL;
+    return realloc(p, size);
+}
+
+static void counted_free(void* p) {
+    s_live -= p != NULL;
+    free(p);
+}
+
+// count the allocations the header makes, and only those
+#define malloc counted_malloc
+#define calloc counted_calloc
+#define realloc counted_realloc
+#define free counted_free
+#include "NimBLEAttValue.h"
+#undef malloc
+#undef calloc
+#undef realloc
+#undef free
+
+#define INLINE_LENGTH CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH
+#define INIT_LENGTH CONFIG_NIMBLE_CPP_ATT_VALUE_INIT_LENGTH
+
+static void check(bool ok, const char* what, size_t length) {
+    if (!ok) {
+        fprintf(stderr, "%s, value of %zu bytes\n", what, length);
+        exit(1);
+    }
+}
+
+static bool holds(const NimBLEAttValue& value, const uint8_t* data, size_t length) {
+    return value.size() == length && memcmp(value.data(), data, length) == 0 && value.data()[length] == '\0';
+}
+
+static void check_allocations() {
+    uint8_t data[BLE_ATT_ATTR_MAX_LEN];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = 1 + i % 255;
+    }
+    const size_t empty_capacity = INIT_LENGTH > INLINE_LENGTH ? INIT_LENGTH : INLINE_LENGTH;
+
+    for (size_t length = 0; length <= BLE_ATT_ATTR_MAX_LEN; length++) {
+        {
+            s_allocs = 0;
+            NimBLEAttValue value;
+            check(s_allocs == (INIT_LENGTH > INLINE_LENGTH), "empty value allocated", length);
+
+            s_allocs = 0;
+            value.setValue(data, length);
+            check(holds(value, data, length), "setValue() stored something else", length);
+            check(s_allocs == (length > empty_capacity), "setValue() allocated", length);
+
+            s_allocs = 0;
+            NimBLEAttValue copy(value);
+            check(holds(copy, data, length), "copy differs", length);
+            check(s_allocs == (length > INLINE_LENGTH), "copy allocated", length);
+
+            s_allocs = 0;
+            NimBLEAttValue moved(std::move(copy));
+            check(holds(moved, data, length), "moved value differs", length);
+            check(s_allocs == 0, "move allocated", length);
+            check(copy.size() == 0 && copy.c_str()[0] == '\0', "moved-from value isn't empty", length);
+
+            copy.setValue(data, length);
+            check(holds(copy, data, length), "moved-from value unusable", length);
+
+            s_allocs = 0;
+            moved = std::move(value);
+            check(holds(moved, data, length), "move assigned value differs", length);
+            check(s_allocs == 0, "move assignment allocated", length);
+
+            const NimBLEAttValue& self = moved;
+            moved = self;
+            check(holds(moved, data, length), "self assignment changed the value", length);
+
+            // growing past the inline buffer keeps what was there
+            NimBLEAttValue appended((uint16_t)0);
+            appended.append(data, length / 2).append(data + length / 2, length - length / 2);
+            check(holds(appended, data, length), "append() lost data", length);
+        }
+        check(s_live == 0, "allocations leaked", length);
+    }
+}
+
+/* readValue() fills a fresh value from the response, stores it and returns it */
+static NimBLEAttValue read_value(NimBLEAttValue& stored, const uint8_t* response, uint16_t length) {
+    NimBLEAttValue value;
+    value.append(response, length);
+    stored = value;
+    return value;
+}
+
+/* Every call brings new data, keep the compiler from hoisting work out of the loop */
+static inline void clobber(void* p) { asm volatile("" : : "r"(p) : "memory"); }
+
+template <typename Op>
+static void measure(const char* name, size_t length, Op op) {
+    const unsigned calls = 1000000;
+
+    s_allocs = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < calls; i++) {
+        op();
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+
+    printf("%-24s %6zu %14.2f %10.1f\n", name, length, (double)s_allocs / calls, ns);
+}
+
+int main() {
+    check_allocations();
+    printf("inline length %d: allocations and contents as expected for values of 0 to %d bytes\n", INLINE_LENGTH,
+           BLE_ATT_ATTR_MAX_LEN);
+    printf("sizeof(NimBLEAttValue) %zu bytes\n\n", sizeof(NimBLEAttValue));
+
+    printf("%-24s %6s %14s %10s\n", "path", "bytes", "allocs/call", "ns/call");
+
+    uint8_t response[BLE_ATT_ATTR_MAX_LEN] = {0x64, 0x00, 0x1f, 0x02};
+    volatile size_t sink = 0;
+
+    // a battery level, a BLE-MIDI packet, and a value that takes a long read
+    for (uint16_t length : {4, 20, 100}) {
+        NimBLEAttValue stored;
+        measure("readValue()", length, [&] {
+            clobber(response);
+            NimBLEAttValue value = read_value(stored, response, length);
+            sink += value.size();
+        });
+        measure("notification", length, [&] {
+            clobber(response);
+            stored.setValue(response, length);
+            sink += stored.size();
+        });
+        measure("getValue()", length, [&] {
+            NimBLEAttValue value = stored;
+            clobber(&value);
+            sink += value.size();
+        });
+    }
+
+    // a characteristic, with its value, discovered and deleted
+    measure("construct and destroy", 0, [&] {
+        NimBLEAttValue value;
+        clobber(&value);
+    });
+
+    return 0;
+}
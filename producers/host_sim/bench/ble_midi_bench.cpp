@@ -0,0 +1,206 @@
+/*
+ * Decodes BLE-MIDI packets in the shapes keyboards send them with ble_midi_parser and checks the messages against
+ * what each packet holds, fuzzes the parser with random and mutated packets, then prints the time per packet.
+ *
+ *   ./build/ble_midi_bench [fuzz packets]
+ *
+ * Fuzzed packets end right at a page the process may not read, so a read past a packet crashes the bench instead
+ * of going unnoticed. A packet of n bytes may decode to at most n - 1 messages, all with valid fields. Exits with 1
+ * if a check fails.
+ */
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+#include "ble_midi.h"
+
+typedef struct {
+    const char* name;
+    std::vector<uint8_t> bytes;
+    std::vector<ble_midi_event_t> expected;
+} packet_t;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        fprintf(stderr, "%s\n", what);
+        exit(1);
+    }
+}
+
+static ble_midi_event_t midi(uint16_t timestamp_ms, ble_midi_event_type_t type, uint8_t status, uint8_t data1 = 0,
+                             uint8_t data2 = 0) {
+    return {timestamp_ms, type, status, (uint8_t)(status < 0xF0 ? status & 0x0F : 0), data1, data2};
+}
+
+static const std::vector<packet_t> packets = {
+    {"note on", {0x80, 0x81, 0x90, 60, 100}, {midi(1, BLE_MIDI_NOTE_ON, 0x90, 60, 100)}},
+    {"chord in running status, with and without a timestamp",
+     {0x85, 0xA0, 0x90, 60, 100, 64, 90, 0xA1, 67, 80},
+     {midi(672, BLE_MIDI_NOTE_ON, 0x90, 60, 100), midi(672, BLE_MIDI_NOTE_ON, 0x90, 64, 90),
+      midi(673, BLE_MIDI_NOTE_ON, 0x90, 67, 80)}},
+    {"timestamp rolling over the 13 bits within a packet",
+     {0xBF, 0xFF, 0x80, 60, 0, 0x81, 0x91, 62, 64},
+     {midi(0x1FFF, BLE_MIDI_NOTE_OFF, 0x80, 60, 0), midi(1, BLE_MIDI_NOTE_ON, 0x91, 62, 64)}},
+    {"sustain pedal, then a note on of velocity 0",
+     {0x80, 0x82, 0xB0, 64, 127, 0x83, 0x90, 60, 0},
+     {midi(2, BLE_MIDI_SUSTAIN, 0xB0, 64, 127), midi(3, BLE_MIDI_NOTE_OFF, 0x90, 60, 0)}},
+    {"control change in running status after a real-time message",
+     {0x80, 0x82, 0xB2, 7, 100, 0x83, 0xFE, 0x84, 7, 90},
+     {midi(2, BLE_MIDI_CONTROL_CHANGE, 0xB2, 7, 100), midi(3, BLE_MIDI_OTHER, 0xFE),
+      midi(4, BLE_MIDI_CONTROL_CHANGE, 0xB2, 7, 90)}},
+    {"active sensing", {0x80, 0x80, 0xFE}, {midi(0, BLE_MIDI_OTHER, 0xFE)}},
+    {"program change", {0x80, 0x81, 0xC3, 5}, {midi(1, BLE_MIDI_OTHER, 0xC3, 5)}},
+    {"system exclusive with a clock interleaved, continued in the next packet",
+     {0x80, 0x80, 0xF0, 0x7E, 0x7F, 0x81, 0xF8, 0x06, 0x09},
+     {midi(1, BLE_MIDI_OTHER, 0xF8)}},
+    {"system exclusive continued and ended, then a note",
+     {0x80, 0x01, 0x02, 0x85, 0xF7, 0x86, 0x90, 64, 80},
+     {midi(6, BLE_MIDI_NOTE_ON, 0x90, 64, 80)}},
+    {"system exclusive cut short by a note",
+     {0x80, 0x80, 0xF0, 0x01, 0x02, 0x81, 0x90, 60, 64},
+     {midi(1, BLE_MIDI_NOTE_ON, 0x90, 60, 64)}},
+    {"system common ends running status", {0x80, 0x81, 0xF3, 5, 0x10}, {midi(1, BLE_MIDI_OTHER, 0xF3, 5)}},
+    {"note cut short", {0x80, 0x81, 0x90, 60}, {}},
+    {"running status with no status before it", {0x80, 60, 100}, {}},
+    {"no header", {0x10, 0x81, 0x90, 60, 100}, {}},
+    {"empty", {}, {}},
+};
+
+static bool same_event(const ble_midi_event_t& a, const ble_midi_event_t& b) {
+    return a.timestamp_ms == b.timestamp_ms && a.type == b.type && a.status == b.status && a.channel == b.channel &&
+           a.data1 == b.data1 && a.data2 == b.data2;
+}
+
+static void check_packets() {
+    for (const packet_t& packet : packets) {
+        ble_midi_parser parser(packet.bytes.data(), packet.bytes.size());
+        ble_midi_event_t event;
+        size_t i = 0;
+        while (parser.next(&event)) {
+            if (i >= packet.expected.size() || !same_event(event, packet.expected[i])) {
+                fprintf(stderr, "%s: message %zu decoded wrong\n", packet.name, i);
+                exit(1);
+            }
+            i++;
+        }
+        if (i != packet.expected.size()) {
+            fprintf(stderr, "%s: %zu of %zu messages decoded\n", packet.name, i, packet.expected.size());
+            exit(1);
+        }
+        if (i > 0) {
+            check(parser.first_timestamp_ms() <= BLE_MIDI_TIMESTAMP_MASK, "first timestamp out of range");
+        }
+    }
+    check(ble_midi_elapsed_ms(0x1FFF, 1) == 2, "elapsed time across the rollover wrong");
+}
+
+/* Room for the longest fuzzed packet right before a page that can't be read */
+class guarded_buffer {
+   public:
+    explicit guarded_buffer(size_t room) {
+        m_page = sysconf(_SC_PAGESIZE);
+        m_room = (room + m_page - 1) / m_page * m_page;
+        m_base = (uint8_t*)mmap(NULL, m_room + m_page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        check(m_base != MAP_FAILED && mprotect(m_base + m_room, m_page, PROT_NONE) == 0, "no guard page");
+    }
+
+    ~guarded_buffer() { munmap(m_base, m_room + m_page); }
+
+    /** @brief Copy a packet in so that it ends at the guard page */
+    const uint8_t* place(const uint8_t* data, size_t len) {
+        uint8_t* p = m_base + m_room - len;
+        std::copy(data, data + len, p);
+        return p;
+    }
+
+   private:
+    size_t m_page;
+    size_t m_room;
+    uint8_t* m_base;
+};
+
+static void fuzz(unsigned iterations) {
+    std::mt19937 rng(5);
+    guarded_buffer guarded(256);
+    uint8_t packet[128];
+    size_t most_events = 0;
+
+    for (unsigned it = 0; it < iterations; it++) {
+        size_t len;
+        if (it % 2) {
+            // random bytes, half of them with the high bit set and the first one mostly a header
+            len = rng() % 64;
+            for (size_t i = 0; i < len; i++) {
+                packet[i] = (uint8_t)(rng() % 2 ? rng() | 0x80 : rng() & 0x7F);
+            }
+            if (len > 0 && rng() % 4) {
+                packet[0] = (uint8_t)(0x80 | (rng() & 0x3F));
+            }
+        } else {
+            // a real packet with bytes flipped, dropped or appended
+            const packet_t& base = packets[rng() % packets.size()];
+            len = base.bytes.size();
+            std::copy(base.bytes.begin(), base.bytes.end(), packet);
+            for (unsigned mutations = 1 + rng() % 3; mutations > 0; mutations--) {
+                switch (rng() % 3) {
+                    case 0:
+                        if (len > 0) {
+                            packet[rng() % len] ^= (uint8_t)(1 << (rng() % 8));
+                        }
+                        break;
+                    case 1:
+                        len = len > 0 ? rng() % len : 0;
+                        break;
+                    default:
+                        if (len < sizeof(packet)) {
+                            packet[len++] = (uint8_t)rng();
+                        }
+                        break;
+                }
+            }
+        }
+
+        ble_midi_parser parser(guarded.place(packet, len), len);
+        ble_midi_event_t event;
+        size_t events = 0;
+        while (parser.next(&event)) {
+            events++;
+            check(events < len, "more messages than bytes after the header");
+            check(event.timestamp_ms <= BLE_MIDI_TIMESTAMP_MASK && event.channel < 16 && event.data1 < 0x80 &&
+                      event.data2 < 0x80 && (event.status & 0x80),
+                  "message with fields out of range");
+        }
+        most_events = events > most_events ? events : most_events;
+    }
+    printf("fuzzed %u packets, at most %zu messages in one\n", iterations, most_events);
+}
+
+int main(int argc, char** argv) {
+    unsigned iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+
+    check_packets();
+    fuzz(iterations);
+
+    // decoding the well-formed packets over and over
+    const unsigned rounds = 200000;
+    size_t messages = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned r = 0; r < rounds; r++) {
+        for (const packet_t& packet : packets) {
+            ble_midi_parser parser(packet.bytes.data(), packet.bytes.size());
+            ble_midi_event_t event;
+            while (parser.next(&event)) {
+                messages++;
+            }
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("%.1f ns per packet, %.1f M messages/s\n", ns / rounds / packets.size(), messages / ns * 1e3);
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * Looks up clients by connection handle, by peer address and for a disconnected one, the way NimBLEDevice used to
+ * in a std::list of clients and the way it does now in a NimBLEClientTable, and prints the time per lookup for as
+ * many clients as 3, 9 and 32 connections allow.
+ *
+ *   ./build/client_table_bench [lookups]
+ *
+ * Before timing, the clients connect, disconnect, change address and are deleted and created at random, and every
+ * lookup is checked against the list. Exits with 1 if the two disagree.
+ */
+#include <chrono>
+#include <list>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "NimBLEClientTable.h"
+
+#define CONN_HANDLE_NONE 0xffff
+
+typedef struct {
+    uint16_t conn_id;
+    uint64_t address;
+    int slot;
+} client_t;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        fprintf(stderr, "%s\n", what);
+        exit(1);
+    }
+}
+
+/* NimBLEDevice::getClientByID before the table */
+static client_t* list_by_id(const std::list<client_t*>& clients, uint16_t conn_id) {
+    for (auto it = clients.cbegin(); it != clients.cend(); ++it) {
+        if ((*it)->conn_id == conn_id) {
+            return *it;
+        }
+    }
+    return nullptr;
+}
+
+/* NimBLEDevice::getClientByPeerAddress before the table */
+static client_t* list_by_address(const std::list<client_t*>& clients, uint64_t address) {
+    for (auto it = clients.cbegin(); it != clients.cend(); ++it) {
+        if ((*it)->address == address) {
+            return *it;
+        }
+    }
+    return nullptr;
+}
+
+/* NimBLEDevice::getDisconnectedClient before the table */
+static client_t* list_disconnected(const std::list<client_t*>& clients) {
+    for (auto it = clients.cbegin(); it != clients.cend(); ++it) {
+        if ((*it)->conn_id == CONN_HANDLE_NONE) {
+            return *it;
+        }
+    }
+    return nullptr;
+}
+
+template <typename Lookup>
+static double measure(unsigned lookups, Lookup lookup) {
+    auto start = std::chrono::steady_clock::now();
+    uintptr_t sink = 0;
+    for (unsigned i = 0; i < lookups; i++) {
+        sink += (uintptr_t)lookup(i);
+    }
+    asm volatile("" : : "r"(sink));
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / lookups;
+}
+
+template <size_t N>
+static void run(unsigned lookups) {
+    std::mt19937 rng(N);
+    std::list<client_t*> list;
+    NimBLEClientTable<client_t, N> table;
+    client_t clients[N];
+    uint16_t next_handle = 0;
+
+    for (client_t& client : clients) {
+        client = {CONN_HANDLE_NONE, 0, -1};
+    }
+
+    auto random_address = [&]() {
+        // a few vendors' addresses, so some clients share one
+        return (0xc0ffee000000ULL | (rng() % 4) << 16) + rng() % (N + 1);
+    };
+
+    // clients come and go; handles are reused the way a controller does, but only one client holds each
+    for (unsigned step = 0; step < 20000; step++) {
+        client_t& client = clients[rng() % N];
+        unsigned action = rng() % 4;
+        if (client.slot < 0) {
+            client.address = random_address();
+            client.slot = table.add(&client, client.address);
+            check(client.slot >= 0, "table full below its capacity");
+            list.push_back(&client);
+        } else if (action == 0) {
+            table.remove(client.slot);
+            list.remove(&client);
+            client = {CONN_HANDLE_NONE, 0, -1};
+        } else if (action == 1 && client.conn_id == CONN_HANDLE_NONE) {
+            client.address = random_address();
+            table.setAddress(client.slot, client.address);
+        } else if (client.conn_id == CONN_HANDLE_NONE) {
+            next_handle = (next_handle + 1) % (2 * N);
+            if (list_by_id(list, next_handle) == nullptr) {
+                client.conn_id = next_handle;
+                table.setConnHandle(client.slot, client.conn_id);
+            }
+        } else {
+            client.conn_id = CONN_HANDLE_NONE;
+            table.clearConnHandle(client.slot);
+        }
+
+        check(table.size() == list.size(), "sizes differ");
+        for (uint16_t handle = 0; handle < 2 * N; handle++) {
+            check(table.findByConnHandle(handle) == list_by_id(list, handle), "found a different client by handle");
+        }
+        for (const client_t& other : clients) {
+            client_t* found = table.findByAddress(other.address);
+            check((found == nullptr) == (list_by_address(list, other.address) == nullptr) &&
+                      (found == nullptr || found->address == other.address),
+                  "found a client with a different address");
+        }
+        client_t* disconnected = table.findDisconnected();
+        check((disconnected == nullptr) == (list_disconnected(list) == nullptr) &&
+                  (disconnected == nullptr || disconnected->conn_id == CONN_HANDLE_NONE),
+              "found a connected client as disconnected");
+    }
+
+    // then all of them connected, the worst case for the list
+    list.clear();
+    table = NimBLEClientTable<client_t, N>();
+    for (size_t i = 0; i < N; i++) {
+        clients[i] = {(uint16_t)i, random_address(), -1};
+        clients[i].slot = table.add(&clients[i], clients[i].address);
+        table.setConnHandle(clients[i].slot, clients[i].conn_id);
+        list.push_back(&clients[i]);
+    }
+    check(table.findDisconnected() == nullptr && table.add(&clients[0], 0) < 0, "a full table took another client");
+
+    double list_id = measure(lookups, [&](unsigned i) { return list_by_id(list, i % N); });
+    double table_id = measure(lookups, [&](unsigned i) { return table.findByConnHandle(i % N); });
+    double list_address = measure(lookups, [&](unsigned i) { return list_by_address(list, clients[i % N].address); });
+    double table_address = measure(lookups, [&](unsigned i) { return table.findByAddress(clients[i % N].address); });
+    double list_free = measure(lookups, [&](unsigned) { return list_disconnected(list); });
+    double table_free = measure(lookups, [&](unsigned) { return table.findDisconnected(); });
+
+    printf("%-8zu %10.1f %10.1f %12.1f %12.1f %12.1f %12.1f\n", N, list_id, table_id, list_address, table_address,
+           list_free, table_free);
+}
+
+int main(int argc, char** argv) {
+    unsigned lookups = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000000;
+
+    printf("ns per lookup\n");
+    printf("%-8s %10s %10s %12s %12s %12s %12s\n", "clients", "list id", "table id", "list addr", "table addr",
+           "list free", "table free");
+    run<3>(lookups);
+    run<9>(lookups);
+    run<32>(lookups);
+    return 0;
+}
@@ -0,0 +1,209 @@
+/*
+ * Round-trips every kind of producer event through event_encode, event_decode and event_from_frame, checks the
+ * frames that have to be refused, then prints the time to encode and to decode an event.
+ *
+ *   ./build/event_codec_bench [events]
+ *
+ * Refused are buffers too short to encode into, which have to be left untouched past their length, frames cut short
+ * anywhere, frames of another version, and frames whose length field disagrees with their payload. Exits with 1 if
+ * a check fails.
+ */
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "event_codec.h"
+
+#define CANARY 0xa5
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        fprintf(stderr, "%s\n", what);
+        exit(1);
+    }
+}
+
+static producer_event_t key_event(int64_t timestamp_us, uint8_t key, uint8_t state, uint8_t velocity) {
+    producer_event_t event = {};
+    event.timestamp_us = timestamp_us;
+    event.kind = EVENT_KEY;
+    event.key = {key, state, velocity};
+    return event;
+}
+
+static producer_event_t control_event(int64_t timestamp_us, uint8_t controller, uint8_t value) {
+    producer_event_t event = {};
+    event.timestamp_us = timestamp_us;
+    event.kind = EVENT_CONTROL;
+    event.control = {controller, value};
+    return event;
+}
+
+static producer_event_t text_event(int64_t timestamp_us, const char* body, size_t length) {
+    producer_event_t event = {};
+    event.timestamp_us = timestamp_us;
+    event.kind = EVENT_TEXT;
+    memcpy(event.body, body, length);
+    return event;
+}
+
+static bool same_event(const producer_event_t& a, const producer_event_t& b) {
+    if (a.kind != b.kind || a.timestamp_us != b.timestamp_us) {
+        return false;
+    }
+    switch (a.kind) {
+        case EVENT_KEY:
+            return a.key.key == b.key.key && a.key.state == b.key.state && a.key.velocity == b.key.velocity;
+        case EVENT_CONTROL:
+            return a.control.controller == b.control.controller && a.control.value == b.control.value;
+        default:
+            return strcmp(a.body, b.body) == 0;
+    }
+}
+
+/* Encode into exactly enough room, and into every shorter buffer, which has to be refused without a write past it */
+static size_t check_encode(const producer_event_t& event, uint32_t seq, uint8_t* frame) {
+    uint8_t buf[EVENT_FRAME_MAX_LENGTH + 8];
+    memset(buf, CANARY, sizeof(buf));
+    size_t length = event_encode(&event, seq, buf, EVENT_FRAME_MAX_LENGTH);
+    check(length >= EVENT_FRAME_HEADER_SIZE, "encoding refused with room for the frame");
+    for (size_t i = length; i < sizeof(buf); i++) {
+        check(buf[i] == CANARY, "encoding wrote past the frame");
+    }
+
+    for (size_t room = 0; room < length; room++) {
+        memset(buf, CANARY, sizeof(buf));
+        check(event_encode(&event, seq, buf, room) == 0, "encoded into a buffer too short for the frame");
+        for (size_t i = room; i < sizeof(buf); i++) {
+            check(buf[i] == CANARY, "a refused encoding wrote past the buffer");
+        }
+    }
+
+    memset(buf, CANARY, sizeof(buf));
+    check(event_encode(&event, seq, buf, length) == length, "encoding refused with exactly enough room");
+    memcpy(frame, buf, length);
+    return length;
+}
+
+/* Every prefix of a frame is refused, the whole frame decodes to the event and the sequence number it was given */
+static void check_round_trip(const producer_event_t& event, uint32_t seq, const producer_event_t& expected) {
+    uint8_t frame[EVENT_FRAME_MAX_LENGTH];
+    size_t length = check_encode(event, seq, frame);
+
+    event_frame_t decoded;
+    for (size_t cut = 0; cut < length; cut++) {
+        // copied so that a read past the prefix is a read past an allocation, for the sanitizers
+        std::vector<uint8_t> prefix(frame, frame + cut);
+        check(!event_decode(prefix.data(), cut, &decoded), "decoded a frame cut short");
+    }
+
+    std::vector<uint8_t> whole(frame, frame + length);
+    check(event_decode(whole.data(), length, &decoded), "whole frame refused");
+    check(decoded.version == EVENT_CODEC_VERSION && decoded.seq == seq &&
+              decoded.length == length - EVENT_FRAME_HEADER_SIZE,
+          "header read back wrong");
+
+    producer_event_t out = {};
+    check(event_from_frame(&decoded, &out) && same_event(out, expected), "event read back differs");
+}
+
+static void check_kinds() {
+    check_round_trip(key_event(1, 60, KEY_DOWN, 100), 0, key_event(1, 60, KEY_DOWN, 100));
+    check_round_trip(key_event(-5, 127, KEY_UP, 0), 0xffffffff, key_event(-5, 127, KEY_UP, 0));
+    check_round_trip(control_event(INT64_MAX, 64, 127), 7, control_event(INT64_MAX, 64, 127));
+    check_round_trip(text_event(3, "", 0), 1, text_event(3, "", 0));
+    check_round_trip(text_event(4, "pressed", 7), 2, text_event(4, "pressed", 7));
+
+    // a body that fills the buffer has no terminator; it is sent whole but read back one short to fit one
+    char full[EVENT_BODY_LENGTH];
+    memset(full, 'x', sizeof(full));
+    check_round_trip(text_event(5, full, sizeof(full)), 3, text_event(5, full, sizeof(full) - 1));
+
+    // a kind the codec doesn't know goes out as text
+    producer_event_t unknown = text_event(6, "other", 5);
+    unknown.kind = (event_kind_t)0x7f;
+    check_round_trip(unknown, 4, text_event(6, "other", 5));
+}
+
+static void check_malformed() {
+    uint8_t frame[EVENT_FRAME_MAX_LENGTH];
+    producer_event_t key = key_event(10, 60, KEY_DOWN, 80);
+    size_t length = event_encode(&key, 1, frame, sizeof(frame));
+    event_frame_t decoded;
+    producer_event_t out;
+
+    // another version
+    for (int version : {0, EVENT_CODEC_VERSION + 1, 0xff}) {
+        frame[0] = (uint8_t)version;
+        check(!event_decode(frame, length, &decoded), "decoded a frame of another version");
+    }
+    frame[0] = EVENT_CODEC_VERSION;
+
+    // a length field longer than the payload received
+    event_codec_put_le(frame + 2, 4, 2);
+    check(!event_decode(frame, length, &decoded), "decoded a frame longer than the buffer");
+    event_codec_put_le(frame + 2, 0xffff, 2);
+    check(!event_decode(frame, length, &decoded), "decoded a frame longer than the buffer");
+
+    // a length field shorter than the payload type needs
+    for (uint16_t short_length : {0, 1, 2}) {
+        event_codec_put_le(frame + 2, short_length, 2);
+        check(event_decode(frame, length, &decoded), "refused a frame with room to spare");
+        check(!event_from_frame(&decoded, &out), "read a key from a payload too short for one");
+    }
+    frame[1] = EVENT_PAYLOAD_CONTROL;
+    event_codec_put_le(frame + 2, 1, 2);
+    check(event_decode(frame, length, &decoded) && !event_from_frame(&decoded, &out),
+          "read a control change from a payload too short for one");
+
+    // payload types that aren't a single event are decoded but not turned into one
+    for (uint8_t type : {(uint8_t)EVENT_PAYLOAD_KEY_BATCH, (uint8_t)0x7f}) {
+        frame[1] = type;
+        event_codec_put_le(frame + 2, 3, 2);
+        check(event_decode(frame, length, &decoded) && !event_from_frame(&decoded, &out),
+              "turned a frame of another type into an event");
+    }
+}
+
+int main(int argc, char** argv) {
+    unsigned events = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000000;
+
+    check_kinds();
+    check_malformed();
+
+    // the mix a piano sends: mostly keys, some pedal, the odd text event
+    producer_event_t mix[16];
+    for (size_t i = 0; i < 16; i++) {
+        mix[i] = i == 15   ? text_event(i, "connected to the piano", 22)
+                 : i % 5 == 4 ? control_event(i, 64, i % 2 ? 127 : 0)
+                              : key_event(i, 21 + i, i % 2, 90);
+    }
+
+    static uint8_t frames[16][EVENT_FRAME_MAX_LENGTH];
+    size_t lengths[16];
+    uint32_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < events; i++) {
+        lengths[i % 16] = event_encode(&mix[i % 16], i, frames[i % 16], EVENT_FRAME_MAX_LENGTH);
+        sink += lengths[i % 16];
+    }
+    double encode_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < events; i++) {
+        event_frame_t frame;
+        producer_event_t event;
+        if (event_decode(frames[i % 16], lengths[i % 16], &frame) && event_from_frame(&frame, &event)) {
+            sink += event.kind;
+        }
+    }
+    double decode_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    asm volatile("" : : "r"(sink));
+
+    printf("encode %.1f ns, decode %.1f ns per event\n", encode_ns / events, decode_ns / events);
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Checks event_ring on one thread through wraparound, a full ring and its counters, then with a producer and a
+ * consumer thread, and prints the events per second a producer_event_ring_t passes between two threads.
+ *
+ *   ./build/event_ring_bench [events]
+ *
+ * In the two thread check the producer never waits, so some pushes are dropped; every event that got in has to come
+ * out once, in order, and the drop counter has to match the pushes that failed. Exits with 1 if not. A side that
+ * finds the ring full or empty yields, so the threads also make progress on a single core.
+ */
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#include "event_ring.h"
+#include "producer_event.h"
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        fprintf(stderr, "%s\n", what);
+        exit(1);
+    }
+}
+
+/* Fill, overflow and drain a small ring many times over, so its indices wrap around the storage */
+static void check_single_thread() {
+    event_ring<uint32_t, 8> ring;
+    uint32_t next_in = 0, next_out = 0, drops = 0;
+    size_t high_water = 0;
+
+    for (unsigned round = 0; round < 1000; round++) {
+        // a different fill each round, so the head and tail meet at every offset
+        unsigned fill = 1 + round % 10;
+        for (unsigned i = 0; i < fill; i++) {
+            if (ring.push(next_in)) {
+                next_in++;
+                high_water = ring.depth() > high_water ? ring.depth() : high_water;
+            } else {
+                drops++;
+                check(ring.depth() == ring.capacity(), "push refused below capacity");
+            }
+        }
+        check(ring.drops() == drops, "drop counter doesn't match the refused pushes");
+        check(ring.high_water() == high_water, "wrong high-water mark");
+
+        unsigned drain = round % 3 == 0 ? 8 : 1 + round % 5;
+        uint32_t item;
+        for (unsigned i = 0; i < drain && ring.pop(&item); i++) {
+            check(item == next_out++, "items out of order");
+        }
+    }
+
+    uint32_t item;
+    while (ring.pop(&item)) {
+        check(item == next_out++, "items out of order");
+    }
+    check(next_out == next_in && ring.depth() == 0, "items lost");
+    check(!ring.pop(&item), "popped from an empty ring");
+}
+
+/* A producer that drops when full and a consumer that checks what arrives */
+static void check_two_threads(uint32_t events) {
+    event_ring<uint32_t, 64> ring;
+    uint32_t accepted = 0, refused = 0, marker_refused = 0;
+    uint64_t accepted_sum = 0;
+
+    std::thread producer([&] {
+        for (uint32_t i = 1; i <= events; i++) {
+            if (ring.push(i)) {
+                accepted++;
+                accepted_sum += i;
+            } else {
+                refused++;
+            }
+            // let the consumer in now and then, on a single core it would otherwise only run once the ring is full
+            if (i % 48 == 0) {
+                std::this_thread::yield();
+            }
+        }
+        // the end marker has to get through
+        while (!ring.push(0)) {
+            marker_refused++;
+            std::this_thread::yield();
+        }
+    });
+
+    uint32_t received = 0, last = 0;
+    uint64_t received_sum = 0;
+    uint32_t item;
+    while (true) {
+        if (!ring.pop(&item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (item == 0) {
+            break;
+        }
+        check(item > last, "items out of order or repeated");
+        last = item;
+        received++;
+        received_sum += item;
+    }
+    producer.join();
+
+    check(received == accepted && received_sum == accepted_sum, "pushed items lost or changed");
+    check(ring.drops() == refused + marker_refused, "drop counter doesn't match the refused pushes");
+    check(ring.high_water() <= ring.capacity(), "high-water mark above capacity");
+    printf("two threads: %u events, %u dropped, high-water %zu of %zu\n", events, refused, ring.high_water(),
+           ring.capacity());
+}
+
+/* Events per second through the ring the producers use, with the producer waiting instead of dropping */
+static void measure_throughput(uint32_t events) {
+    static producer_event_ring_t ring;
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer([&] {
+        producer_event_t event = {};
+        event.kind = EVENT_KEY;
+        strcpy(event.event_id, "key");
+        for (uint32_t i = 0; i < events; i++) {
+            event.timestamp_us = i;
+            while (!ring.push(event)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    producer_event_t event;
+    for (uint32_t i = 0; i < events; i++) {
+        while (!ring.pop(&event)) {
+            std::this_thread::yield();
+        }
+        check(event.timestamp_us == i, "events out of order");
+    }
+    producer.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("throughput: %.2f M events/s of %zu bytes, high-water %zu of %zu\n", events / seconds / 1e6,
+           sizeof(producer_event_t), ring.high_water(), ring.capacity());
+}
+
+int main(int argc, char** argv) {
+    uint32_t events = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+
+    check_single_thread();
+    check_two_threads(events);
+    measure_throughput(events);
+    return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * Stores events in the simulated "evlog" partition through flash_log until the log has wrapped around, remounts it as
+ * after a reboot, replays what is left, and prints the records per second and bytes per second of both.
+ *
+ *   ./build/flash_log_bench [times around the log]
+ *
+ * After wrapping, the log holds the newest events and the older ones are counted as dropped. The remounted log has
+ * to find exactly those, and replay them in the order they were stored, each as it went in, with its stage stamps
+ * if it was stored by the same boot and without them otherwise. Replayed records have to stay replayed across another
+ * remount. The partition behaves like NOR flash, see src/flash.cpp, and its size is
+ * HOST_SIM_EVLOG_SIZE. Exits with 1 if a check fails.
+ */
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "event_log.h"
+#include "flash_log.h"
+#include "flash_log_partition.h"
+
+#define BOOT_ID 0x5eed0007
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        fprintf(stderr, "%s\n", what);
+        exit(1);
+    }
+}
+
+/* What a piano stores while the broker is away: mostly keys, some pedal, the odd text event */
+static producer_event_t make_event(uint32_t i) {
+    producer_event_t event = {};
+    event.timestamp_us = 1000000 + (int64_t)i * 2500;
+    event.stamps = {event.timestamp_us - 40, event.timestamp_us - 15};
+    if (i % 13 == 12) {
+        event.kind = EVENT_TEXT;
+        strcpy(event.event_id, "status");
+        snprintf(event.body, EVENT_BODY_LENGTH, "stored while offline, event %u", (unsigned)i);
+    } else if (i % 5 == 4) {
+        event.kind = EVENT_CONTROL;
+        strcpy(event.event_id, "sustain");
+        event.control = {64, (uint8_t)(i % 2 ? 127 : 0)};
+    } else {
+        event.kind = EVENT_KEY;
+        strcpy(event.event_id, "key");
+        event.key = {(uint8_t)(21 + i % 88), (uint8_t)(i % 2 ? KEY_UP : KEY_DOWN), (uint8_t)(i % 128)};
+    }
+    return event;
+}
+
+static bool same_event(const producer_event_t& a, const producer_event_t& b) {
+    if (a.kind != b.kind || a.timestamp_us != b.timestamp_us || strcmp(a.event_id, b.event_id) != 0 ||
+        a.stamps.received_us != b.stamps.received_us || a.stamps.decoded_us != b.stamps.decoded_us) {
+        return false;
+    }
+    switch (a.kind) {
+        case EVENT_KEY:
+            return a.key.key == b.key.key && a.key.state == b.key.state && a.key.velocity == b.key.velocity;
+        case EVENT_CONTROL:
+            return a.control.controller == b.control.controller && a.control.value == b.control.value;
+        default:
+            return strcmp(a.body, b.body) == 0;
+    }
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    double laps = argc > 1 ? strtod(argv[1], NULL) : 3;
+
+    flash_log_io_t io;
+    check(flash_log_partition_io("evlog", &io) == ESP_OK, "no evlog partition");
+
+    // append until the log has gone around the partition `laps` times
+    flash_log writer;
+    check(writer.mount(io) == FLASH_LOG_OK && writer.empty(), "fresh partition not formatted empty");
+
+    uint8_t record[EVENT_LOG_RECORD_MAX_LENGTH];
+    uint32_t appended = 0;
+    size_t appended_bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (appended_bytes < laps * io.size) {
+        producer_event_t event = make_event(appended);
+        size_t len = event_log_encode(&event, BOOT_ID, record, sizeof(record));
+        check(len > 0 && writer.append(record, len) == FLASH_LOG_OK, "append failed");
+        appended++;
+        appended_bytes += len;
+    }
+    double append_s = seconds_since(start);
+
+    const flash_log_stats_t& stats = writer.stats();
+    check(stats.appended == appended, "appends miscounted");
+    check(stats.dropped > 0, "log never wrapped");
+    check(writer.pending() + stats.dropped == appended, "records lost without being counted as dropped");
+
+    // a reboot: a new log on the same flash has to find the same records
+    flash_log reader;
+    check(reader.mount(io) == FLASH_LOG_OK, "remount failed");
+    check(reader.pending() == writer.pending(), "remount found a different number of records");
+
+    // a later boot's clock started over, the stamps can't be compared with it
+    size_t len;
+    producer_event_t other_boot;
+    check(reader.peek(record, sizeof(record), &len) == FLASH_LOG_OK &&
+              event_log_decode(record, len, BOOT_ID + 1, &other_boot),
+          "stored event doesn't decode");
+    check(other_boot.stamps.received_us == 0 && other_boot.stamps.decoded_us == 0, "stamps kept across boots");
+
+    uint32_t next = appended - reader.pending();
+    uint32_t replayed = 0;
+    size_t replayed_bytes = 0;
+    start = std::chrono::steady_clock::now();
+    while (reader.peek(record, sizeof(record), &len) == FLASH_LOG_OK) {
+        producer_event_t event;
+        check(event_log_decode(record, len, BOOT_ID, &event), "stored event doesn't decode");
+        if (!same_event(event, make_event(next))) {
+            fprintf(stderr, "replayed record %u isn't event %u\n", (unsigned)replayed, (unsigned)next);
+            exit(1);
+        }
+        check(reader.consume() == FLASH_LOG_OK, "consume failed");
+        next++;
+        replayed++;
+        replayed_bytes += len;
+    }
+    double replay_s = seconds_since(start);
+
+    check(next == appended, "replay stopped before the newest event");
+    check(reader.empty() && reader.stats().corrupt == 0, "corrupt records or records left");
+
+    // the replayed marks are in flash too
+    flash_log after;
+    check(after.mount(io) == FLASH_LOG_OK && after.empty(), "replayed records came back after a remount");
+
+    printf("%zu KB log, %u events appended, %u dropped to wrap %.1f times, %u replayed\n", io.size / 1024,
+           (unsigned)appended, (unsigned)stats.dropped, laps, (unsigned)replayed);
+    printf("append %.0f records/s, %.1f MB/s\n", appended / append_s, appended_bytes / append_s / 1e6);
+    printf("replay %.0f records/s, %.1f MB/s\n", replayed / replay_s, replayed_bytes / replay_s / 1e6);
+    return 0;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// just enough of an ESP-IDF sdkconfig for the NimBLE headers the benches build
+#define CONFIG_BT_ENABLED 1
+#define CONFIG_NIMBLE_CPP_LOG_LEVEL 0
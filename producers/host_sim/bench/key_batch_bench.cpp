@@ -0,0 +1,176 @@
+/*
+ * Runs streams of key events through key_batch the way the piano's publisher does, on a simulated clock, and prints
+ * the MQTT messages per second and the latency batching adds, unbatched and for several KEY_BATCH_WINDOW_MS values.
+ *
+ *   ./build/key_batch_bench [seconds of events]
+ *
+ * A batch goes out when its window elapses, when it is full, or when the next event doesn't fit it. Every batch is
+ * read back with key_batch_read and compared with the events that went into it, and the 0xFFFF microsecond limit
+ * on a record's offset is checked at its edge. Exits with 1 on a mismatch.
+ */
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "key_batch.h"
+
+#define KEY_BATCH_MAX_RECORDS 32
+
+typedef key_batch<KEY_BATCH_MAX_RECORDS> piano_batch_t;
+
+typedef struct {
+    int64_t time_us;
+    key_event_t key;
+} event_t;
+
+typedef struct {
+    size_t messages;
+    double latency_sum_us;
+    int64_t latency_max_us;
+} result_t;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        fprintf(stderr, "%s\n", what);
+        exit(1);
+    }
+}
+
+/* Key presses at a mean rate, half of them in chords of 3 within a millisecond, each released later */
+static std::vector<event_t> make_events(double seconds, double rate) {
+    std::mt19937 rng((unsigned)rate);
+    std::exponential_distribution<double> gap(rate / 2 / 1e6);
+    std::vector<event_t> events;
+
+    double t = 0;
+    while (t < seconds * 1e6) {
+        size_t notes = rng() % 2 ? 3 : 1;
+        for (size_t i = 0; i < notes; i++) {
+            key_event_t key = {(uint8_t)(21 + rng() % 88), KEY_DOWN, (uint8_t)(1 + rng() % 127)};
+            int64_t down_us = (int64_t)t + i * 300;
+            events.push_back({down_us, key});
+            key.state = KEY_UP;
+            key.velocity = 0;
+            events.push_back({down_us + 50000 + (int64_t)(rng() % 400000), key});
+        }
+        t += gap(rng) * notes;
+    }
+    std::stable_sort(events.begin(), events.end(),
+                     [](const event_t& a, const event_t& b) { return a.time_us < b.time_us; });
+    return events;
+}
+
+static result_t run(const std::vector<event_t>& events, int64_t window_us) {
+    result_t result = {};
+    if (window_us == 0) {
+        // batching off: one message per event, sent as soon as it is taken off the ring
+        result.messages = events.size();
+        return result;
+    }
+
+    piano_batch_t batch(window_us);
+    uint8_t body[piano_batch_t::MAX_BODY_LENGTH];
+    size_t first = 0;  // index of the first event in the batch
+
+    auto publish = [&](int64_t now_us) {
+        size_t count = batch.count();
+        size_t len = batch.encode(body);
+        result.messages++;
+
+        check(key_batch_count(len) == count, "batch length doesn't match its records");
+        for (size_t i = 0; i < count; i++) {
+            const event_t& sent = events[first + i];
+            int64_t timestamp_us;
+            key_event_t key;
+            check(key_batch_read(body, len, i, &timestamp_us, &key), "record missing from the batch");
+            check(timestamp_us == sent.time_us && key.key == sent.key.key && key.state == sent.key.state &&
+                      key.velocity == sent.key.velocity,
+                  "record read back differs from the event");
+
+            result.latency_sum_us += now_us - sent.time_us;
+            result.latency_max_us = std::max(result.latency_max_us, now_us - sent.time_us);
+        }
+        int64_t timestamp_us;
+        key_event_t key;
+        check(!key_batch_read(body, len, count, &timestamp_us, &key), "read a record past the end");
+        first += count;
+    };
+
+    for (size_t i = 0; i < events.size(); i++) {
+        const event_t& event = events[i];
+        if (batch.due(event.time_us)) {
+            publish(batch.deadline_us());
+        }
+        if (!batch.add(event.time_us, event.key)) {
+            publish(event.time_us);
+            check(batch.add(event.time_us, event.key), "an empty batch refused an event");
+        }
+        if (batch.full()) {
+            publish(event.time_us);
+        }
+    }
+    if (!batch.empty()) {
+        publish(batch.deadline_us());
+    }
+    check(first == events.size(), "events lost");
+    return result;
+}
+
+/* Offsets up to 0xFFFF microseconds fit a record, one more starts a new batch, and a longer window is clamped */
+static void check_delta_cap() {
+    piano_batch_t batch(1000000);
+    uint8_t body[piano_batch_t::MAX_BODY_LENGTH];
+    key_event_t key = {60, KEY_DOWN, 100};
+    const int64_t base_us = 0x123456789LL;
+
+    check(batch.add(base_us, key) && batch.add(base_us + KEY_BATCH_MAX_DELTA_US, key), "offset 0xFFFF refused");
+    check(!batch.add(base_us + KEY_BATCH_MAX_DELTA_US + 1, key), "offset 0x10000 accepted");
+    check(!batch.add(base_us - 1, key), "event before the first record accepted");
+    check(batch.deadline_us() == base_us + KEY_BATCH_MAX_DELTA_US, "window not clamped to the largest offset");
+
+    size_t len = batch.encode(body);
+    int64_t timestamp_us;
+    key_event_t read;
+    check(key_batch_read(body, len, 1, &timestamp_us, &read) && timestamp_us == base_us + KEY_BATCH_MAX_DELTA_US,
+          "offset 0xFFFF read back wrong");
+    check(!key_batch_read(body, len - 1, 1, &timestamp_us, &read), "read a cut short record");
+    check(key_batch_count(KEY_BATCH_HEADER_SIZE - 1) == 0, "counted records in a cut short header");
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? strtod(argv[1], NULL) : 60;
+
+    check_delta_cap();
+
+    printf("%-10s %10s %12s %14s %12s %12s\n", "events/s", "window ms", "messages/s", "events/message", "mean +ms",
+           "max +ms");
+
+    // playing, a fast passage, and a glissando
+    for (double rate : {20.0, 100.0, 500.0}) {
+        std::vector<event_t> events = make_events(seconds, rate);
+        double span_s = (events.back().time_us - events.front().time_us) / 1e6;
+        for (int window_ms : {0, 5, 10, 20, 50}) {
+            result_t result = run(events, window_ms * 1000);
+            printf("%-10.0f %10d %12.1f %14.2f %12.2f %12.2f\n", events.size() / span_s, window_ms,
+                   result.messages / span_s, (double)events.size() / result.messages,
+                   result.latency_sum_us / 1000 / events.size(), result.latency_max_us / 1000.0);
+            check(result.latency_max_us <= window_ms * 1000, "an event was held back longer than the window");
+        }
+    }
+
+    // the cost of batching itself, per event
+    std::vector<event_t> events = make_events(seconds, 500);
+    auto start = std::chrono::steady_clock::now();
+    const int repeats = 20;
+    for (int i = 0; i < repeats; i++) {
+        run(events, 10000);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("add, encode and read back: %.1f ns per event\n", ns / repeats / events.size());
+
+    return 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * Records synthetic latencies into latency_histogram and checks every drained summary against the exact percentiles
+ * of what was recorded, then prints the time a record and a drain take.
+ *
+ *   ./build/latency_histogram_bench [values]
+ *
+ * A reported percentile is the top of the bucket the exact one falls into, clamped to the maximum, so it is never
+ * below the exact value, never above the maximum, and off by at most one bucket's width. The buckets have to tile
+ * the uint32 range, values out of it are clamped, and nothing recorded while another thread drains may be lost.
+ * Exits with 1 if a check fails.
+ */
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+#include "latency_histogram.h"
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        fprintf(stderr, "%s\n", what);
+        exit(1);
+    }
+}
+
+/* Bucket `i` holds the values from one past the top of bucket i - 1 up to its own top */
+static void check_buckets() {
+    check(latency_histogram::bucket_of(0) == 0, "0 not in the first bucket");
+    for (size_t i = 0; i + 1 < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        uint32_t top = latency_histogram::bucket_top(i);
+        check(latency_histogram::bucket_of(top) == i, "a bucket's top is in another bucket");
+        check(latency_histogram::bucket_of(top + 1) == i + 1, "values between two buckets");
+    }
+    check(latency_histogram::bucket_top(LATENCY_HISTOGRAM_BUCKETS - 1) == UINT32_MAX, "the last bucket ends short");
+    check(latency_histogram::bucket_of(UINT32_MAX) == LATENCY_HISTOGRAM_BUCKETS - 1, "UINT32_MAX out of range");
+}
+
+static uint32_t exact_percentile(const std::vector<uint32_t>& sorted, uint32_t pct) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t rank = (sorted.size() * pct + 99) / 100;
+    return sorted[rank - 1];
+}
+
+static void check_percentile(uint32_t reported, const std::vector<uint32_t>& sorted, uint32_t pct) {
+    uint32_t exact = exact_percentile(sorted, pct);
+    uint32_t max = sorted.empty() ? 0 : sorted.back();
+    uint32_t expected = std::min(latency_histogram::bucket_top(latency_histogram::bucket_of(exact)), max);
+
+    check(reported <= max, "percentile above the maximum");
+    check(reported >= exact, "percentile below the exact one");
+    check(reported == expected, "percentile not the top of the exact one's bucket");
+    check(reported - exact <= exact / LATENCY_HISTOGRAM_HALF, "percentile further off than a bucket's width");
+}
+
+/* Record `values`, drain, and compare with the exact figures */
+static void check_summary(latency_histogram* histogram, std::vector<int64_t> values, const char* name) {
+    std::vector<uint32_t> sorted;
+    for (int64_t v : values) {
+        histogram->record(v);
+        sorted.push_back(v < 0 ? 0 : v > UINT32_MAX ? UINT32_MAX : (uint32_t)v);
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    latency_summary_t summary;
+    histogram->drain(&summary);
+    if (summary.count != sorted.size() || summary.max_us != (sorted.empty() ? 0 : sorted.back())) {
+        fprintf(stderr, "%s: count or maximum wrong\n", name);
+        exit(1);
+    }
+    check_percentile(summary.p50_us, sorted, 50);
+    check_percentile(summary.p90_us, sorted, 90);
+    check_percentile(summary.p99_us, sorted, 99);
+
+    // the drain started a new window
+    histogram->drain(&summary);
+    check(summary.count == 0 && summary.max_us == 0 && summary.p99_us == 0, "values left over after a drain");
+}
+
+/*
+ * Stage latencies the way the piano records them, from synthetic stamps: a notification every few milliseconds,
+ * decoded tens of microseconds later, sent after the publisher wakes up, with the odd long stall
+ */
+static std::vector<int64_t> publish_latencies(size_t n, std::mt19937* rng) {
+    std::exponential_distribution<double> decode(1.0 / 25);
+    std::exponential_distribution<double> publish(1.0 / 400);
+    std::vector<int64_t> latencies;
+    int64_t received_us = 1000000;
+    for (size_t i = 0; i < n; i++) {
+        received_us += 1000 + (*rng)() % 5000;
+        int64_t decoded_us = received_us + 5 + (int64_t)decode(*rng);
+        int64_t published_us = decoded_us + (int64_t)publish(*rng) + ((*rng)() % 500 == 0 ? 150000 : 0);
+        latencies.push_back(published_us - received_us);
+    }
+    return latencies;
+}
+
+static void check_distributions() {
+    static latency_histogram histogram;
+    std::mt19937 rng(6);
+
+    check_summary(&histogram, {}, "nothing recorded");
+    // one value, whose bucket top lies above it: all the percentiles are the value itself
+    check_summary(&histogram, {1000}, "a single value");
+    check_summary(&histogram, {17, 17, 17, 1000001}, "one outlier");
+    check_summary(&histogram, {-40, 0, 3}, "negative latencies");
+    check_summary(&histogram, {(int64_t)UINT32_MAX + 1, INT64_MAX, 10}, "latencies past uint32");
+
+    for (size_t n : {1, 2, 3, 10, 99, 100, 101, 1000, 100000}) {
+        check_summary(&histogram, publish_latencies(n, &rng), "publish latencies");
+
+        std::vector<int64_t> uniform;
+        for (size_t i = 0; i < n; i++) {
+            uniform.push_back(rng() % 100000);
+        }
+        check_summary(&histogram, uniform, "uniform latencies");
+
+        // every value at the edge of a bucket
+        std::vector<int64_t> edges;
+        for (size_t i = 0; i < n; i++) {
+            uint32_t top = latency_histogram::bucket_top(rng() % LATENCY_HISTOGRAM_BUCKETS);
+            edges.push_back((int64_t)top + (rng() % 2 && top < UINT32_MAX ? 1 : 0));
+        }
+        check_summary(&histogram, edges, "bucket edges");
+    }
+}
+
+/* Tasks recording while another one drains: every value lands in exactly one window */
+static void check_concurrent_drain(uint32_t values) {
+    static latency_histogram histogram;
+    const int tasks = 3;
+    std::vector<std::thread> recorders;
+    for (int t = 0; t < tasks; t++) {
+        recorders.emplace_back([values, t] {
+            for (uint32_t i = 0; i < values; i++) {
+                histogram.record(t * 1000 + i % 1000);
+                if (i % 64 == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    uint64_t drained = 0;
+    uint32_t max = 0;
+    latency_summary_t summary;
+    for (int i = 0; i < 1000; i++) {
+        histogram.drain(&summary);
+        drained += summary.count;
+        max = std::max(max, summary.max_us);
+        check(summary.p99_us <= summary.max_us, "percentile above the maximum while recording");
+        std::this_thread::yield();
+    }
+    for (std::thread& recorder : recorders) {
+        recorder.join();
+    }
+    histogram.drain(&summary);
+    drained += summary.count;
+    max = std::max(max, summary.max_us);
+
+    check(drained == (uint64_t)values * tasks, "values lost or counted twice while draining");
+    check(max == (tasks - 1) * 1000 + 999, "maximum lost while draining");
+}
+
+int main(int argc, char** argv) {
+    uint32_t values = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+
+    check_buckets();
+    check_distributions();
+    check_concurrent_drain(values);
+
+    static latency_histogram histogram;
+    std::mt19937 rng(6);
+    std::vector<int64_t> latencies = publish_latencies(4096, &rng);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < values; i++) {
+        histogram.record(latencies[i % latencies.size()]);
+    }
+    double record_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    latency_summary_t summary;
+    const int drains = 10000;
+    for (int i = 0; i < drains; i++) {
+        histogram.drain(&summary);
+    }
+    double drain_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    printf("record %.1f ns, drain %.0f ns\n", record_ns / values, drain_ns / drains);
+    return 0;
+}
@@ -0,0 +1,195 @@
+/*
+ * Runs streams of small values through NimBLENotifyCoalescer the way NimBLECharacteristic::notifyCoalesced does,
+ * on a simulated clock, and prints the notifications sent per value, the radio time they take and the latency
+ * coalescing adds, for several MTUs and longest delays.
+ *
+ *   ./build/notify_coalesce_bench [seconds of events]
+ *
+ * Radio time is that of a notification on the 1M PHY with an empty acknowledgement: 10 bytes of link layer framing
+ * plus the L2CAP and ATT headers at 8 us a byte, and two inter frame spaces. Exits with 1 if the values unpacked from
+ * the frames differ from those sent, or if a frame held when the MTU shrinks isn't split between its records.
+ */
+#include <algorithm>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "NimBLENotifyCoalescer.h"
+
+typedef struct {
+    double time_us;
+    uint8_t value[5];  // a key_batch record: delta, key, state, velocity
+} event_t;
+
+typedef struct {
+    size_t notifications;
+    double air_us;
+    double latency_sum_us;
+    double latency_max_us;
+} result_t;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        fprintf(stderr, "%s\n", what);
+        exit(1);
+    }
+}
+
+/* Key events at a mean rate, half of them in chords of 3 that arrive within a millisecond */
+static std::vector<event_t> make_events(double seconds, double rate) {
+    std::mt19937 rng((unsigned)rate);
+    std::exponential_distribution<double> gap(rate / 1e6);
+    std::vector<event_t> events;
+
+    double t = 0;
+    while (t < seconds * 1e6) {
+        size_t notes = rng() % 2 ? 3 : 1;
+        for (size_t i = 0; i < notes; i++) {
+            event_t event;
+            event.time_us = t + i * 300;
+            for (uint8_t& byte : event.value) {
+                byte = (uint8_t)rng();
+            }
+            events.push_back(event);
+        }
+        t += gap(rng) * notes;
+    }
+    // a chord can overlap the next event
+    std::stable_sort(events.begin(), events.end(),
+                     [](const event_t& a, const event_t& b) { return a.time_us < b.time_us; });
+    return events;
+}
+
+static double air_us(size_t payload) {
+    return (payload + 3 + 4 + 10) * 8 + 150 + 80 + 150;
+}
+
+static result_t run(const std::vector<event_t>& events, uint16_t mtu, double max_delay_us) {
+    result_t result = {};
+    std::vector<uint8_t> frame(mtu - 3);
+    std::vector<uint8_t> unpacked;
+    std::vector<double> held;  // arrival times of the values in the frame
+
+    NimBLENotifyCoalescer coalescer;
+    coalescer.setCapacity(mtu - 3);
+    double deadline = -1;
+
+    auto send = [&](double now) {
+        size_t length = coalescer.take(frame.data());
+        result.notifications++;
+        result.air_us += air_us(length);
+        for (double arrival : held) {
+            result.latency_sum_us += now - arrival;
+            result.latency_max_us = now - arrival > result.latency_max_us ? now - arrival : result.latency_max_us;
+        }
+        held.clear();
+        deadline = -1;
+
+        size_t offset = 0;
+        const uint8_t* value;
+        size_t value_length;
+        while (NimBLENotifyCoalescer::next(frame.data(), length, &offset, &value, &value_length)) {
+            unpacked.insert(unpacked.end(), value, value + value_length);
+        }
+        check(offset == length, "frame has trailing bytes");
+    };
+
+    for (const event_t& event : events) {
+        if (max_delay_us == 0) {
+            // coalescing off: notify() per value
+            result.notifications++;
+            result.air_us += air_us(sizeof(event.value));
+            unpacked.insert(unpacked.end(), event.value, event.value + sizeof(event.value));
+            continue;
+        }
+
+        if (deadline >= 0 && event.time_us >= deadline) {
+            send(deadline);
+        }
+        if (!coalescer.fits(sizeof(event.value))) {
+            send(event.time_us);
+        }
+        coalescer.add(event.value, sizeof(event.value));
+        held.push_back(event.time_us);
+        if (coalescer.full()) {
+            send(event.time_us);
+        } else if (coalescer.records() == 1) {
+            deadline = event.time_us + max_delay_us;
+        }
+    }
+    if (!coalescer.empty()) {
+        send(deadline);
+    }
+
+    check(unpacked.size() == events.size() * sizeof(events[0].value), "values lost");
+    for (size_t i = 0; i < events.size(); i++) {
+        check(memcmp(&unpacked[i * sizeof(events[i].value)], events[i].value, sizeof(events[i].value)) == 0,
+              "values reordered or changed");
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? strtod(argv[1], NULL) : 60;
+
+    printf("%-10s %5s %9s %14s %14s %12s %12s\n", "events/s", "mtu", "delay ms", "notify/value", "radio ms/s",
+           "mean +ms", "max +ms");
+
+    // playing, a fast passage, and a burst the size of a glissando
+    for (double rate : {20.0, 100.0, 500.0}) {
+        std::vector<event_t> events = make_events(seconds, rate);
+        for (uint16_t mtu : {23, 247}) {
+            for (double delay_ms : {0.0, 5.0, 10.0, 20.0}) {
+                result_t result = run(events, mtu, delay_ms * 1000);
+                printf("%-10.0f %5u %9.0f %14.3f %14.2f %12.2f %12.2f\n", rate, mtu, delay_ms,
+                       (double)result.notifications / events.size(), result.air_us / 1000 / seconds,
+                       result.latency_sum_us / 1000 / events.size(), result.latency_max_us / 1000);
+                // the clock is in floating point microseconds, allow it a rounding error
+                check(result.latency_max_us <= delay_ms * 1000 + 0.001, "a value was held back longer than the delay");
+            }
+        }
+    }
+
+    // values that can never fit a frame are refused, not split
+    NimBLENotifyCoalescer coalescer;
+    coalescer.setCapacity(20);
+    uint8_t value[256] = {};
+    check(coalescer.accepts(19) && !coalescer.accepts(20), "accepts() disagrees with the capacity");
+    check(!coalescer.add(value, 20) && coalescer.empty(), "a value longer than a frame was added");
+    coalescer.setCapacity(300);
+    check(!coalescer.accepts(256) && !coalescer.add(value, 256), "a value longer than a record was added");
+
+    // a frame held when a subscriber with a smaller MTU arrives goes out in pieces of whole records
+    coalescer.setCapacity(20);
+    for (uint8_t i = 0; i < 4; i++) {
+        value[0] = i;
+        coalescer.add(value, 4);
+    }
+    uint8_t held[20];
+    size_t held_length = coalescer.take(held);
+    size_t pieces = 0;
+    for (size_t at = 0; at < held_length; pieces++) {
+        size_t piece = NimBLENotifyCoalescer::fit(held + at, held_length - at, 11);
+        check(piece == 10, "frame not split between records");
+        check(held[at] == 4 && held[at + 1] == pieces * 2 && held[at + 5] == 4 && held[at + 6] == pieces * 2 + 1,
+              "split frame lost or reordered records");
+        at += piece;
+    }
+    check(pieces == 2, "frame split into the wrong number of pieces");
+    check(NimBLENotifyCoalescer::fit(held, held_length, 4) == 0, "a record that doesn't fit was cut");
+    check(NimBLENotifyCoalescer::fit(held, held_length, 20) == held_length, "a frame that fits was split");
+
+    // a cut short frame stops at the last whole record
+    uint8_t frame[] = {2, 0xaa, 0xbb, 3, 0xcc};
+    size_t offset = 0;
+    const uint8_t* record;
+    size_t length;
+    check(NimBLENotifyCoalescer::next(frame, sizeof(frame), &offset, &record, &length) && length == 2,
+          "first record misread");
+    check(!NimBLENotifyCoalescer::next(frame, sizeof(frame), &offset, &record, &length), "cut short record read");
+
+    return 0;
+}
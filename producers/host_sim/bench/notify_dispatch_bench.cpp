@@ -0,0 +1,131 @@
+/*
+ * Routes notifications to the characteristics of a synthetic GATT database, once with the search over services and
+ * their characteristics NimBLEClient::handleGapEvent used to do and once with NimBLEHandleTable, and prints the
+ * time per notification.
+ *
+ *   ./build/notify_dispatch_bench [services] [characteristics per service]
+ *
+ * The services and characteristics here are stand-ins carrying only the handles the routing looks at.
+ */
+#include <chrono>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "NimBLEHandleTable.h"
+
+struct characteristic_t {
+    uint16_t handle;  // value handle
+    uint32_t notifications;
+};
+
+struct service_t {
+    uint16_t start_handle;
+    uint16_t end_handle;
+    std::vector<characteristic_t*> characteristics;
+};
+
+/* Lay services out the way a server does: a declaration, then declaration, value and CCCD per characteristic */
+static std::vector<service_t> make_database(size_t services, size_t per_service) {
+    std::vector<service_t> database(services);
+    uint16_t handle = 1;
+
+    for (service_t& service : database) {
+        service.start_handle = handle++;
+        for (size_t c = 0; c < per_service; c++) {
+            characteristic_t* characteristic = new characteristic_t();
+            characteristic->handle = handle + 1;
+            characteristic->notifications = 0;
+            service.characteristics.push_back(characteristic);
+            handle += 3;
+        }
+        service.end_handle = handle - 1;
+    }
+
+    return database;
+}
+
+static characteristic_t* walk_find(const std::vector<service_t>& database, uint16_t handle) {
+    for (const service_t& service : database) {
+        // Dont waste cycles searching services without this handle in its range
+        if (service.end_handle < handle) {
+            continue;
+        }
+
+        for (characteristic_t* characteristic : service.characteristics) {
+            if (characteristic->handle == handle) {
+                return characteristic;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+template <typename Find>
+static double route(const std::vector<uint16_t>& handles, Find find) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint16_t handle : handles) {
+        characteristic_t* characteristic = find(handle);
+        if (characteristic == nullptr) {
+            fprintf(stderr, "no characteristic for handle %u\n", handle);
+            exit(1);
+        }
+        characteristic->notifications++;
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / handles.size();
+}
+
+int main(int argc, char** argv) {
+    size_t services = argc > 1 ? strtoul(argv[1], NULL, 10) : 15;
+    size_t per_service = argc > 2 ? strtoul(argv[2], NULL, 10) : 4;
+    const size_t notifications = 2000000;
+
+    std::vector<service_t> database = make_database(services, per_service);
+    std::vector<characteristic_t*> all;
+    for (service_t& service : database) {
+        all.insert(all.end(), service.characteristics.begin(), service.characteristics.end());
+    }
+
+    NimBLEHandleTable<characteristic_t> table;
+    if (!table.reset(all.front()->handle, all.back()->handle, 65536)) {
+        fprintf(stderr, "table reset failed\n");
+        return 1;
+    }
+    for (characteristic_t* characteristic : all) {
+        table.set(characteristic->handle, characteristic);
+    }
+    if (table.find(0) != nullptr || table.find(all.back()->handle + 1) != nullptr) {
+        fprintf(stderr, "table found a handle outside its range\n");
+        return 1;
+    }
+
+    printf("%zu services, %zu characteristics, handles 1-%u\n", services, all.size(), database.back().end_handle);
+    printf("%-28s %14s %14s\n", "notifications to", "walk ns", "table ns");
+
+    std::mt19937 rng(1);
+    std::vector<uint16_t> uniform(notifications);
+    for (uint16_t& handle : uniform) {
+        handle = all[rng() % all.size()]->handle;
+    }
+    // a MIDI stream from the peer's last characteristic, the walk's worst case
+    std::vector<uint16_t> last(notifications, all.back()->handle);
+
+    const struct {
+        const char* name;
+        const std::vector<uint16_t>* handles;
+    } patterns[] = {{"every characteristic", &uniform}, {"the last characteristic", &last}};
+
+    for (auto& pattern : patterns) {
+        double walk_ns = route(*pattern.handles, [&](uint16_t handle) { return walk_find(database, handle); });
+        double table_ns = route(*pattern.handles, [&](uint16_t handle) { return table.find(handle); });
+        printf("%-28s %14.1f %14.1f\n", pattern.name, walk_ns, table_ns);
+    }
+
+    for (characteristic_t* characteristic : all) {
+        delete characteristic;
+    }
+    return 0;
+}
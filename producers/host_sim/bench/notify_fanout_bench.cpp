@@ -0,0 +1,187 @@
+/*
+ * Sends notifications to a growing number of simulated subscribers, once the way NimBLECharacteristic::notify used
+ * to, looking up each subscriber's MTU and connection in the stack, and once from the state NimBLESubscriberList
+ * keeps, and prints the time per notification.
+ *
+ *   ./build/notify_fanout_bench [notification length]
+ *
+ * The stack here is a stand-in: lookups take a lock and search the connections as the NimBLE host does, and a sent
+ * notification is a heap buffer copied from the value and freed. Exits with 1 if the two ways send differently.
+ */
+#include <chrono>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "NimBLESubscriberList.h"
+
+#define NIMBLE_SUB_NOTIFY 0x0001
+
+typedef struct {
+    uint16_t conn_handle;
+    uint16_t mtu;
+    bool encrypted;
+    uint8_t peer_addr[7];
+    uint8_t conn_params[24];  // the rest of ble_gap_conn_desc, copied out by a lookup
+} connection_t;
+
+static std::mutex s_host_lock;
+static std::vector<connection_t> s_connections;
+static uint64_t s_sent_bytes = 0;
+static uint64_t s_sent_handles = 0;
+
+static const connection_t* find_connection(uint16_t conn_handle) {
+    for (const connection_t& conn : s_connections) {
+        if (conn.conn_handle == conn_handle) {
+            return &conn;
+        }
+    }
+    return nullptr;
+}
+
+/* ble_att_mtu() */
+static uint16_t att_mtu(uint16_t conn_handle) {
+    std::lock_guard<std::mutex> lock(s_host_lock);
+    const connection_t* conn = find_connection(conn_handle);
+    return conn != nullptr ? conn->mtu : 0;
+}
+
+/* ble_gap_conn_find() */
+static int gap_conn_find(uint16_t conn_handle, connection_t* desc) {
+    std::lock_guard<std::mutex> lock(s_host_lock);
+    const connection_t* conn = find_connection(conn_handle);
+    if (conn == nullptr) {
+        return 1;
+    }
+    *desc = *conn;
+    return 0;
+}
+
+/* ble_hs_mbuf_from_flat() then ble_gattc_notify_custom(), which consumes the buffer */
+static int send_notification(uint16_t conn_handle, const uint8_t* value, size_t length) {
+    uint8_t* om = (uint8_t*)malloc(length + 8);
+    memcpy(om + 8, value, length);
+    asm volatile("" : : "r"(om) : "memory");
+
+    std::lock_guard<std::mutex> lock(s_host_lock);
+    s_sent_bytes += length;
+    s_sent_handles += conn_handle;
+    free(om);
+    return 0;
+}
+
+/* The subscriber loop of NimBLECharacteristic::notify before the state was kept */
+static size_t notify_lookup(const std::vector<std::pair<uint16_t, uint16_t>>& subscribed, const uint8_t* value,
+                            size_t length, bool reqSec) {
+    size_t sent = 0;
+    for (auto& it : subscribed) {
+        uint16_t _mtu = att_mtu(it.first) - 3;
+        if (_mtu == 0 || it.second == 0) {
+            continue;
+        }
+        if (reqSec) {
+            connection_t desc;
+            if (gap_conn_find(it.first, &desc) != 0 || !desc.encrypted) {
+                continue;
+            }
+        }
+        sent += send_notification(it.first, value, length) == 0;
+    }
+    return sent;
+}
+
+/* The subscriber loop of NimBLECharacteristic::notify now */
+static size_t notify_cached(const NimBLESubscriberList& subscribers, const uint8_t* value, size_t length,
+                            bool reqSec) {
+    size_t sent = 0;
+    for (const NimBLESubscriber& sub : subscribers) {
+        if ((reqSec && !sub.encrypted) || sub.mtu <= 3) {
+            continue;
+        }
+        sent += send_notification(sub.connHandle, value, length) == 0;
+    }
+    return sent;
+}
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        fprintf(stderr, "%s\n", what);
+        exit(1);
+    }
+}
+
+template <typename Notify>
+static double measure(unsigned calls, Notify notify) {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < calls; i++) {
+        notify();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+int main(int argc, char** argv) {
+    size_t length = argc > 1 ? strtoul(argv[1], NULL, 10) : 20;
+    const unsigned calls = 200000;
+    std::vector<uint8_t> value(length, 0x5a);
+
+    printf("%zu byte notifications\n", length);
+    printf("%-12s %-10s %14s %14s %14s\n", "subscribers", "security", "lookup ns", "cached ns", "cached / 1");
+
+    for (bool reqSec : {false, true}) {
+        double single = 0;
+        for (size_t subscribers : {1, 2, 4, 8}) {
+            s_connections.clear();
+            std::vector<std::pair<uint16_t, uint16_t>> subscribed;
+            NimBLESubscriberList list;
+
+            // the peers connect with the default MTU, negotiate a larger one, and all but the last encrypt
+            for (size_t i = 0; i < subscribers; i++) {
+                uint16_t conn_handle = (uint16_t)(i + 1);
+                connection_t conn = {};
+                conn.conn_handle = conn_handle;
+                conn.mtu = 23;
+                s_connections.push_back(conn);
+                subscribed.push_back({conn_handle, NIMBLE_SUB_NOTIFY});
+                list.set(conn_handle, NIMBLE_SUB_NOTIFY, conn.mtu, conn.encrypted);
+
+                s_connections.back().mtu = 247;
+                list.setMTU(conn_handle, 247);
+                if (i + 1 < subscribers || subscribers == 1) {
+                    s_connections.back().encrypted = true;
+                    list.setEncrypted(conn_handle, true);
+                }
+            }
+
+            // both send the same to the same subscribers
+            s_sent_bytes = s_sent_handles = 0;
+            size_t sent = notify_lookup(subscribed, value.data(), length, reqSec);
+            uint64_t bytes = s_sent_bytes, handles = s_sent_handles;
+            s_sent_bytes = s_sent_handles = 0;
+            check(notify_cached(list, value.data(), length, reqSec) == sent, "sent to a different number");
+            check(s_sent_bytes == bytes && s_sent_handles == handles, "sent to different subscribers");
+
+            double lookup_ns = measure(calls, [&] { notify_lookup(subscribed, value.data(), length, reqSec); });
+            double cached_ns = measure(calls, [&] { notify_cached(list, value.data(), length, reqSec); });
+            if (subscribers == 1) {
+                single = cached_ns;
+            }
+            printf("%-12zu %-10s %14.1f %14.1f %14.2f\n", subscribers, reqSec ? "encrypted" : "none", lookup_ns,
+                   cached_ns, cached_ns / single);
+        }
+    }
+
+    // a disconnect removes the subscriber, so a reused handle starts over
+    NimBLESubscriberList list;
+    list.set(1, NIMBLE_SUB_NOTIFY, 247, true);
+    list.remove(1);
+    check(list.size() == 0 && !list.setMTU(1, 100), "removed subscriber still there");
+    list.set(1, NIMBLE_SUB_NOTIFY, 23, false);
+    check(list.find(1)->mtu == 23 && !list.find(1)->encrypted, "reused handle kept old state");
+    list.set(1, 0, 23, false);
+    check(list.size() == 0, "unsubscribing kept the subscriber");
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * Replays advertising reports from a crowd of synthetic advertisers through the lookup step of
+ * NimBLEScan::handleGapEvent, once with the linear search over the results vector it used to do and once with
+ * NimBLEScanIndex, and prints the time per report.
+ *
+ *   ./build/scan_index_bench [reports per advertiser]
+ *
+ * The rest of the handler needs the NimBLE host, so the devices here are stand-ins carrying only what the lookup
+ * compares: the address bytes and the advertising set ID.
+ */
+#include <chrono>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "NimBLEScanIndex.h"
+
+class NimBLEAdvertisedDevice {
+   public:
+    uint8_t address[6];
+    uint8_t set_id;
+    uint32_t reports;
+};
+
+typedef struct {
+    uint8_t address[6];
+    uint8_t set_id;
+} report_t;
+
+static std::vector<report_t> make_reports(size_t advertisers, size_t per_advertiser) {
+    std::mt19937 rng(advertisers);
+
+    std::vector<report_t> crowd(advertisers);
+    for (size_t i = 0; i < advertisers; i++) {
+        // a few vendor prefixes with sequential device parts, like a real crowd
+        uint32_t vendor = rng() % 8;
+        crowd[i].address[5] = 0x24;
+        crowd[i].address[4] = 0x4b;
+        crowd[i].address[3] = (uint8_t)vendor;
+        crowd[i].address[2] = (uint8_t)(i >> 16);
+        crowd[i].address[1] = (uint8_t)(i >> 8);
+        crowd[i].address[0] = (uint8_t)i;
+        crowd[i].set_id = rng() % 4 == 0 ? rng() % 16 : 0;
+    }
+
+    // every advertiser turns up once in the first pass, then they repeat in random order
+    std::vector<report_t> reports(crowd);
+    for (size_t i = advertisers; i < advertisers * per_advertiser; i++) {
+        reports.push_back(crowd[rng() % advertisers]);
+    }
+
+    return reports;
+}
+
+static double run_linear(const std::vector<report_t>& reports, size_t* found) {
+    std::vector<NimBLEAdvertisedDevice*> results;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const report_t& report : reports) {
+        NimBLEAdvertisedDevice* device = nullptr;
+        for (auto& it : results) {
+            if (memcmp(it->address, report.address, 6) == 0 && it->set_id == report.set_id) {
+                device = it;
+                break;
+            }
+        }
+        if (device == nullptr) {
+            device = new NimBLEAdvertisedDevice();
+            memcpy(device->address, report.address, 6);
+            device->set_id = report.set_id;
+            device->reports = 0;
+            results.push_back(device);
+        }
+        device->reports++;
+    }
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    *found = results.size();
+    for (auto& it : results) {
+        delete it;
+    }
+    return elapsed / reports.size();
+}
+
+static double run_index(const std::vector<report_t>& reports, size_t* found) {
+    std::vector<NimBLEAdvertisedDevice*> results;
+    NimBLEScanIndex index;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const report_t& report : reports) {
+        uint64_t key = NimBLEScanIndex::makeKey(report.address, report.set_id);
+        NimBLEAdvertisedDevice* device = index.find(key);
+        if (device == nullptr) {
+            device = new NimBLEAdvertisedDevice();
+            memcpy(device->address, report.address, 6);
+            device->set_id = report.set_id;
+            device->reports = 0;
+            results.push_back(device);
+            index.insert(key, device);
+        }
+        device->reports++;
+    }
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    // erasing half of them must leave the rest reachable
+    for (size_t i = 0; i < results.size(); i += 2) {
+        index.erase(NimBLEScanIndex::makeKey(results[i]->address, results[i]->set_id));
+    }
+    for (size_t i = 0; i < results.size(); i++) {
+        NimBLEAdvertisedDevice* expected = i % 2 == 0 ? nullptr : results[i];
+        if (index.find(NimBLEScanIndex::makeKey(results[i]->address, results[i]->set_id)) != expected) {
+            fprintf(stderr, "index lost advertiser %zu after erase\n", i);
+            exit(1);
+        }
+    }
+
+    *found = results.size();
+    for (auto& it : results) {
+        delete it;
+    }
+    return elapsed / reports.size();
+}
+
+int main(int argc, char** argv) {
+    size_t per_advertiser = argc > 1 ? strtoul(argv[1], NULL, 10) : 20;
+    static const size_t crowds[] = {1000, 2000, 5000, 10000};
+
+    printf("%12s %12s %14s %14s %10s\n", "advertisers", "reports", "linear ns/rpt", "index ns/rpt", "speedup");
+    for (size_t advertisers : crowds) {
+        std::vector<report_t> reports = make_reports(advertisers, per_advertiser);
+
+        size_t linear_found, index_found;
+        double linear_ns = run_linear(reports, &linear_found);
+        double index_ns = run_index(reports, &index_found);
+        if (linear_found != index_found) {
+            fprintf(stderr, "linear found %zu advertisers, index found %zu\n", linear_found, index_found);
+            return 1;
+        }
+
+        printf("%12zu %12zu %14.1f %14.1f %9.0fx\n", advertisers, reports.size(), linear_ns, index_ns,
+               linear_ns / index_ns);
+    }
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * Checks the table NimBLEScan holds scannable advertisements in until their scan response has been checked against
+ * the scan filter, then replays a crowd of advertisers that never pass through it and prints the time per report.
+ *
+ *   ./build/scan_pending_bench [reports per advertiser]
+ *
+ * Advertisers are told apart by address, address type and set ID, an advertiser advertising again replaces what it
+ * left, and a full table makes room by dropping the entry held longest. A scan response finds the advertisement of
+ * its advertiser as long as fewer than CONFIG_NIMBLE_CPP_SCAN_PENDING_SIZE others advertised in between. Exits with 1
+ * if a check fails.
+ */
+#include <chrono>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "NimBLEScanPending.h"
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        fprintf(stderr, "%s\n", what);
+        exit(1);
+    }
+}
+
+static void check_table() {
+    NimBLEScanPending pending;
+    const uint8_t address[6] = {1, 2, 3, 4, 5, 6};
+    const uint8_t adv[] = {2, 0x01, 0x06, 3, 0x03, 0x0f, 0x18};
+
+    NimBLEScanPending::Entry* entry = pending.hold(address, 0, 0, 0, adv, sizeof(adv));
+    check(pending.find(address, 0, 0) == entry && entry->length == sizeof(adv) &&
+              memcmp(entry->data, adv, sizeof(adv)) == 0,
+          "held advertisement not found");
+    check(pending.find(address, 1, 0) == nullptr, "a random address found a public one's advertisement");
+    check(pending.find(address, 0, 1) == nullptr, "another set ID found the advertisement");
+
+    check(pending.hold(address, 0, 0, 2, adv, 3) == entry && pending.size() == 1 && entry->length == 3 &&
+              entry->advType == 2,
+          "advertising again didn't replace the entry");
+    pending.hold(address, 1, 0, 0, adv, sizeof(adv));
+    pending.hold(address, 0, 1, 0, adv, sizeof(adv));
+    check(pending.size() == 3, "address type or set ID not told apart");
+
+    uint8_t long_adv[64] = {};
+    check(pending.hold(address, 0, 2, 0, long_adv, sizeof(long_adv))->length == NIMBLE_CPP_LEGACY_ADV_DATA_LEN,
+          "kept more than a legacy advertisement");
+
+    pending.release(pending.find(address, 1, 0));
+    check(pending.find(address, 1, 0) == nullptr && pending.size() == 3, "released entry still found");
+    pending.clear();
+    check(pending.size() == 0 && pending.find(address, 0, 0) == nullptr, "entries left after clearing");
+
+    // one past the size, the first advertiser's entry is the one dropped, and refreshing it saves it
+    uint8_t other[6] = {};
+    for (int i = 0; i <= CONFIG_NIMBLE_CPP_SCAN_PENDING_SIZE; i++) {
+        other[0] = (uint8_t)i;
+        pending.hold(other, 0, 0, 0, adv, sizeof(adv));
+        if (i == CONFIG_NIMBLE_CPP_SCAN_PENDING_SIZE - 1) {
+            other[0] = 0;
+            pending.hold(other, 0, 0, 0, adv, sizeof(adv));
+        }
+    }
+    other[0] = 0;
+    check(pending.find(other, 0, 0) != nullptr, "dropped the entry held last");
+    other[0] = 1;
+    check(pending.find(other, 0, 0) == nullptr, "kept the entry held longest in a full table");
+    check(pending.size() == CONFIG_NIMBLE_CPP_SCAN_PENDING_SIZE, "full table not full");
+}
+
+int main(int argc, char** argv) {
+    size_t per_advertiser = argc > 1 ? strtoul(argv[1], NULL, 10) : 200;
+
+    check_table();
+
+    // a crowd of scannable advertisers that never pass, each answered by a scan response that doesn't either
+    const size_t advertisers = 200;
+    std::mt19937 rng(14);
+    std::vector<uint8_t> addresses(advertisers * 6);
+    for (uint8_t& b : addresses) {
+        b = (uint8_t)rng();
+    }
+    uint8_t adv[NIMBLE_CPP_LEGACY_ADV_DATA_LEN];
+    for (uint8_t& b : adv) {
+        b = (uint8_t)rng();
+    }
+
+    NimBLEScanPending pending;
+    size_t answered = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < per_advertiser; r++) {
+        for (size_t i = 0; i < advertisers; i++) {
+            const uint8_t* address = &addresses[(rng() % advertisers) * 6];
+            pending.hold(address, 1, 0, 0, adv, sizeof(adv));
+            NimBLEScanPending::Entry* entry = pending.find(address, 1, 0);
+            if (entry != nullptr) {
+                answered++;
+                pending.release(entry);
+            }
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    check(answered == per_advertiser * advertisers, "a scan response right after its advertisement missed it");
+
+    printf("%d entries of %zu bytes, %.1f ns per advertisement and its scan response\n",
+           CONFIG_NIMBLE_CPP_SCAN_PENDING_SIZE, sizeof(NimBLEScanPending::Entry), ns / answered);
+    return 0;
+}
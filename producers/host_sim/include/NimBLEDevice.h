@@ -0,0 +1,299 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+// the real one, it doesn't depend on the stack
+#include "src/NimBLELiteral.h"
+
+/*
+ * Stand-in for the slice of esp-nimble-cpp the piano uses. Scanning always finds one piano advertising PIANO_UUID,
+ * and once its BLE-MIDI characteristic is subscribed to, a thread plays notes into the notify callback the way the
+ * NimBLE host task would.
+ */
+
+#define BLEDevice NimBLEDevice
+#define BLEClient NimBLEClient
+#define BLERemoteService NimBLERemoteService
+#define BLERemoteCharacteristic NimBLERemoteCharacteristic
+#define BLEAdvertisedDevice NimBLEAdvertisedDevice
+#define BLEScan NimBLEScan
+#define BLEUUID NimBLEUUID
+#define BLEAddress NimBLEAddress
+#define BLEClientCallbacks NimBLEClientCallbacks
+#define BLEAdvertisedDeviceCallbacks NimBLEAdvertisedDeviceCallbacks
+
+struct ble_gap_conn_desc {
+    uint16_t conn_handle;
+};
+
+enum { BLE_UUID_TYPE_128 = 128 };
+
+enum { BLE_GAP_LE_PHY_1M = 1, BLE_GAP_LE_PHY_2M = 2 };
+
+struct ble_uuid_t {
+    uint8_t type;
+};
+
+struct ble_uuid128_t {
+    ble_uuid_t u;
+    uint8_t value[16];
+};
+
+class NimBLEClient;
+class NimBLERemoteCharacteristic;
+
+class NimBLEUUID {
+   public:
+    NimBLEUUID() {}
+    NimBLEUUID(const std::string& uuid);
+    NimBLEUUID(const char* uuid) : NimBLEUUID(std::string(uuid)) {}
+    NimBLEUUID(const ble_uuid128_t* uuid);
+
+    static constexpr ble_uuid128_t literal128(const char (&uuid)[37]) {
+        return ble_uuid128_t{{BLE_UUID_TYPE_128},
+                             {NimBLELiteral::uuidByte(uuid, 0), NimBLELiteral::uuidByte(uuid, 1),
+                              NimBLELiteral::uuidByte(uuid, 2), NimBLELiteral::uuidByte(uuid, 3),
+                              NimBLELiteral::uuidByte(uuid, 4), NimBLELiteral::uuidByte(uuid, 5),
+                              NimBLELiteral::uuidByte(uuid, 6), NimBLELiteral::uuidByte(uuid, 7),
+                              NimBLELiteral::uuidByte(uuid, 8), NimBLELiteral::uuidByte(uuid, 9),
+                              NimBLELiteral::uuidByte(uuid, 10), NimBLELiteral::uuidByte(uuid, 11),
+                              NimBLELiteral::uuidByte(uuid, 12), NimBLELiteral::uuidByte(uuid, 13),
+                              NimBLELiteral::uuidByte(uuid, 14), NimBLELiteral::uuidByte(uuid, 15)}};
+    }
+
+    bool operator==(const NimBLEUUID& rhs) const { return m_uuid == rhs.m_uuid; }
+    bool operator!=(const NimBLEUUID& rhs) const { return !(*this == rhs); }
+    std::string toString() const { return m_uuid; }
+
+   private:
+    std::string m_uuid;
+};
+
+class NimBLEAddress {
+   public:
+    NimBLEAddress(const std::string& address) : m_address(address) {}
+    std::string toString() const { return m_address; }
+
+   private:
+    std::string m_address;
+};
+
+struct NimBLEAdvertisedDeviceAllocStats {
+    uint32_t poolAllocs;
+    uint32_t heapAllocs;
+    uint16_t inUse;
+    uint16_t highWater;
+};
+
+class NimBLEAdvertisedDevice {
+   public:
+    NimBLEAdvertisedDevice(const NimBLEAddress& address, const NimBLEUUID& service)
+        : m_address(address), m_service(service) {}
+
+    // counts the piano's report in each scan as one pooled device
+    static NimBLEAdvertisedDeviceAllocStats getAllocStats();
+
+    NimBLEAddress getAddress() { return m_address; }
+    bool haveServiceUUID() { return true; }
+    bool isAdvertisingService(const NimBLEUUID& uuid) { return uuid == m_service; }
+    NimBLEUUID getServiceUUID(uint8_t index = 0) { return index == 0 ? m_service : NimBLEUUID(); }
+    uint8_t getServiceDataCount() { return 0; }
+    NimBLEUUID getServiceDataUUID(uint8_t index = 0) { return NimBLEUUID(); }
+    std::string toString() { return m_address.toString(); }
+
+   private:
+    NimBLEAddress m_address;
+    NimBLEUUID m_service;
+};
+
+class NimBLEAdvertisedDeviceCallbacks {
+   public:
+    virtual ~NimBLEAdvertisedDeviceCallbacks() {}
+    virtual void onResult(NimBLEAdvertisedDevice* advertisedDevice) = 0;
+};
+
+class NimBLEClientCallbacks {
+   public:
+    virtual ~NimBLEClientCallbacks() {}
+    virtual void onConnect(NimBLEClient* pClient) {}
+    virtual void onDisconnect(NimBLEClient* pClient) {}
+    virtual uint32_t onPassKeyRequest() { return 0; }
+    virtual void onAuthenticationComplete(ble_gap_conn_desc* desc) {}
+    virtual bool onConfirmPIN(uint32_t pin) { return true; }
+};
+
+typedef std::function<void(NimBLERemoteCharacteristic* pBLERemoteCharacteristic, uint8_t* pData, size_t length,
+                           bool isNotify)>
+    notify_callback;
+
+/* The stack's received data always arrives in one buffer here */
+class NimBLEMbufView {
+   public:
+    struct Segment {
+        const uint8_t* data;
+        uint16_t length;
+    };
+
+    NimBLEMbufView(const uint8_t* data, size_t length) : m_data(data), m_length(length) {}
+
+    size_t size() const { return m_length; }
+    bool isContiguous() const { return true; }
+    const uint8_t* data() const { return m_data; }
+    size_t dataLength() const { return m_length; }
+    const Segment* begin() const { return &m_segment; }
+    const Segment* end() const { return &m_segment + 1; }
+    size_t copyTo(uint8_t* buf, size_t offset, size_t length) const {
+        if (offset >= m_length) {
+            return 0;
+        }
+        length = std::min(length, m_length - offset);
+        memcpy(buf, m_data + offset, length);
+        return length;
+    }
+
+   private:
+    const uint8_t* m_data;
+    size_t m_length;
+    Segment m_segment{m_data, (uint16_t)m_length};
+};
+
+typedef std::function<void(NimBLERemoteCharacteristic* pBLERemoteCharacteristic, const NimBLEMbufView& data,
+                           bool isNotify)>
+    notify_view_callback;
+
+class NimBLERemoteCharacteristic {
+   public:
+    explicit NimBLERemoteCharacteristic(const NimBLEUUID& uuid) : m_uuid(uuid) {}
+
+    NimBLEUUID getUUID() { return m_uuid; }
+    bool canNotify() { return true; }
+    bool subscribe(bool notifications = true, notify_callback notifyCallback = nullptr, bool response = false);
+    bool subscribeView(bool notifications = true, notify_view_callback notifyCallback = nullptr, bool response = true);
+    bool unsubscribe(bool response = false);
+
+   private:
+    NimBLEUUID m_uuid;
+};
+
+class NimBLERemoteService {
+   public:
+    NimBLERemoteService(const NimBLEUUID& uuid, NimBLERemoteCharacteristic* characteristic)
+        : m_uuid(uuid), m_characteristic(characteristic) {}
+
+    NimBLEUUID getUUID() { return m_uuid; }
+    NimBLERemoteCharacteristic* getCharacteristic(const NimBLEUUID& uuid);
+
+   private:
+    NimBLEUUID m_uuid;
+    NimBLERemoteCharacteristic* m_characteristic;
+};
+
+class NimBLEConnInfo {
+   public:
+    NimBLEConnInfo(uint16_t interval = 0, uint8_t phy = 0) : m_interval(interval), m_phy(phy) {}
+
+    uint16_t getConnInterval() { return m_interval; }
+    uint8_t getTxPhy() { return m_phy; }
+    uint8_t getRxPhy() { return m_phy; }
+
+   private:
+    uint16_t m_interval;
+    uint8_t m_phy;
+};
+
+class NimBLEClient {
+   public:
+    enum ConnProfile : uint8_t { LOW_LATENCY, THROUGHPUT, LOW_POWER };
+
+    bool connect(NimBLEAdvertisedDevice* device, bool deleteAttributes = true);
+    int disconnect(uint8_t reason = 0);
+    bool isConnected() { return m_connected; }
+    void setClientCallbacks(NimBLEClientCallbacks* pClientCallbacks, bool deleteCallbacks = true) {
+        m_callbacks = pClientCallbacks;
+    }
+    NimBLERemoteService* getService(const NimBLEUUID& uuid);
+    /* The simulated piano's attributes never change, so they restore once saved */
+    bool restoreAttributes() { return m_connected && s_attributesSaved; }
+    bool saveAttributes() { return s_attributesSaved = m_connected; }
+    /* The simulated piano accepts every profile, and gets the shortest interval of it */
+    bool applyProfile(ConnProfile profile) {
+        m_profile = profile;
+        return true;
+    }
+    NimBLEConnInfo getConnInfo() {
+        if (!m_connected) {
+            return NimBLEConnInfo();
+        }
+        static const uint16_t intervals[] = {6, 12, 80};
+        return NimBLEConnInfo(intervals[m_profile], m_profile == LOW_POWER ? BLE_GAP_LE_PHY_1M : BLE_GAP_LE_PHY_2M);
+    }
+
+   private:
+    NimBLEClientCallbacks* m_callbacks = nullptr;
+    bool m_connected = false;
+    ConnProfile m_profile = LOW_POWER;
+    static bool s_attributesSaved;
+};
+
+/** @brief Stand-in devices only advertise a service, so the other conditions reject everything once set */
+class NimBLEScanFilter {
+   public:
+    void addServiceUUID(const NimBLEUUID& uuid) { m_serviceUUIDs.push_back(uuid); }
+    void addManufacturerId(uint16_t companyId) { m_companyIds.push_back(companyId); }
+    void setNamePrefix(const std::string& prefix) { m_namePrefix = prefix; }
+    void setMinRSSI(int8_t rssi) { m_minRSSI = rssi; }
+    void clear() { *this = NimBLEScanFilter(); }
+
+    bool matches(const NimBLEUUID& service, int8_t rssi) const {
+        return rssi >= m_minRSSI && m_companyIds.empty() && m_namePrefix.empty() &&
+               (m_serviceUUIDs.empty() ||
+                std::find(m_serviceUUIDs.begin(), m_serviceUUIDs.end(), service) != m_serviceUUIDs.end());
+    }
+
+   private:
+    std::vector<NimBLEUUID> m_serviceUUIDs;
+    std::vector<uint16_t> m_companyIds;
+    std::string m_namePrefix;
+    int8_t m_minRSSI = -128;
+};
+
+class NimBLEScan {
+   public:
+    void setAdvertisedDeviceCallbacks(NimBLEAdvertisedDeviceCallbacks* pAdvertisedDeviceCallbacks,
+                                      bool wantDuplicates = false) {
+        m_callbacks = pAdvertisedDeviceCallbacks;
+    }
+    void setActiveScan(bool active) {}
+    void setInterval(uint16_t intervalMSecs) {}
+    void setWindow(uint16_t windowMSecs) {}
+    void setFilter(const NimBLEScanFilter& filter) { m_filter = filter; }
+    void clearFilter() { m_filter.clear(); }
+
+    /**
+     * @brief Blocks for up to `duration` seconds, reporting a few neighbouring devices and then the piano to the
+     * callbacks, unless stopped first or rejected by the filter
+     */
+    bool start(uint32_t duration, bool is_continue = false);
+    bool stop();
+
+   private:
+    void report(NimBLEAdvertisedDevice* device, int8_t rssi);
+
+    NimBLEAdvertisedDeviceCallbacks* m_callbacks = nullptr;
+    NimBLEScanFilter m_filter;
+    bool m_stopped = false;
+};
+
+class NimBLEDevice {
+   public:
+    static void init(const std::string& deviceName) {}
+    static NimBLEScan* getScan();
+    static NimBLEClient* createClient();
+    static NimBLEClient* getDisconnectedClient();
+};
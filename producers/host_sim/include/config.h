@@ -0,0 +1,10 @@
+#pragma once
+
+// stand-in for the per-device config.h that isn't checked in, the broker is the in-process sink in mqtt_client.cpp
+#define DEVICE_ID "producers/sim"
+#define WIFI_SSID "host_sim"
+#define WIFI_PASSWORD "host_sim"
+#define MQTT_ADDRESS "mqtt://sim"
+
+// the piano advertises the standard BLE-MIDI service
+#define PIANO_UUID "03b80e5a-ede8-4b33-a751-6ce34ec4c700"
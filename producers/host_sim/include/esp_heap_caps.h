@@ -0,0 +1,11 @@
+#pragma once
+
+#include <malloc.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+
+// glibc can't tell the largest free block, so the host heap always reads as unfragmented
+static inline size_t heap_caps_get_free_size(uint32_t caps) { return mallinfo2().fordblks; }
+static inline size_t heap_caps_get_largest_free_block(uint32_t caps) { return mallinfo2().fordblks; }
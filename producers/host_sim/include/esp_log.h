@@ -0,0 +1,16 @@
+#pragma once
+
+// the real header declares printf-style loggers, the producers get stdarg.h through it
+#include <stdarg.h>
+#include <stdio.h>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+#define ESP_LOG_LEVEL_LOCAL(level, tag, format, ...) fprintf(stderr, "%s: " format "\n", tag, ##__VA_ARGS__)
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <random>
+
+// a different value on every run, as the hardware generator gives a different one on every boot
+static inline uint32_t esp_random() {
+    static std::random_device device;
+    return device();
+}
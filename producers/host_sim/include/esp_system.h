@@ -0,0 +1,4 @@
+#pragma once
+
+// ESP-IDF pulls esp_timer.h in transitively, and the producers rely on that
+#include "esp_timer.h"
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_bit_defs.h"
+
+/*
+ * FreeRTOS stand-in, tasks are pthreads. Priorities are accepted and ignored, the host scheduler decides who runs, so
+ * priority inversions on the device won't show up here.
+ */
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+
+// matches CONFIG_FREERTOS_HZ in the producers' sdkconfig
+#define configTICK_RATE_HZ 100
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+
+#define IRAM_ATTR
+
+// ISRs run on ordinary threads here, so there is never anyone to yield to
+#define portYIELD_FROM_ISR(woken) ((void)(woken))
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "driver/gpio.h"
+
+/*
+ * Knobs of the simulation, read from the environment:
+ *
+ *   HOST_SIM_VERBOSE           1 prints every publish as it reaches the broker
+ *   HOST_SIM_WIFI_SCAN_MS      time to find and associate with the access point by scanning, default 1200
+ *   HOST_SIM_WIFI_DIRECTED_MS  the same with its BSSID and channel known, default 40
+ *   HOST_SIM_WIFI_AP_MOVED     1 gives the access point a new BSSID, so cached ones no longer work
+ *   HOST_SIM_DHCP_MS           time from association to a DHCP lease, default 300
+ *   HOST_SIM_NVS_FILE          file NVS is kept in across runs, in memory only if unset
+ *   HOST_SIM_MQTT_OUTAGE       "from,to" seconds into the run during which the broker is unreachable
+ *   HOST_SIM_MQTT_ACK_MS       time from a QoS 1 or 2 publish to its acknowledgement, default 2
+ *   HOST_SIM_NOTES_PER_SECOND  MIDI messages per second from the simulated piano, default 20, 0 for none
+ *   HOST_SIM_NOTES_PER_PACKET  MIDI messages per BLE-MIDI notification, default 1
+ *   HOST_SIM_EVLOG_SIZE        bytes in the "evlog" partition, default 256K as in the piano's partitions.csv
+ */
+
+/** @brief Integer value of environment variable `name`, or `fallback` if it isn't set */
+long host_sim_env(const char* name, long fallback);
+
+/** @brief Whether the station has an IP address, the simulated broker can't be reached before it does */
+bool host_sim_has_ip();
+
+/** @brief Run the registered GPIO interrupt handler of `pin`, as if its edge had fired */
+void host_sim_gpio_trigger(gpio_num_t pin);
+
+void host_sim_mqtt_summary(FILE* out, double seconds);
+void host_sim_gpio_summary(FILE* out);
+void host_sim_ble_summary(FILE* out);
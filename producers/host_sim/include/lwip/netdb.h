@@ -0,0 +1,3 @@
+#pragma once
+
+// nothing from here is used by the producers, the include only has to resolve
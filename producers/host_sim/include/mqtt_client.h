@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_event.h"
+
+/*
+ * In-process broker: publishes are counted per topic rather than sent anywhere, see host_sim.h for the summary and
+ * for taking the broker down. Like the real client, a connect attempt without an IP address fails and is retried after
+ * reconnect_timeout_ms, and a QoS 1 or 2 publish is acknowledged with MQTT_EVENT_PUBLISHED a round trip later, unless
+ * the broker goes down first.
+ */
+
+#define MQTT_RECON_DEFAULT_MS 10000
+
+typedef struct esp_mqtt_client* esp_mqtt_client_handle_t;
+
+typedef enum {
+    MQTT_EVENT_ANY = -1,
+    MQTT_EVENT_ERROR = 0,
+    MQTT_EVENT_CONNECTED,
+    MQTT_EVENT_DISCONNECTED,
+    MQTT_EVENT_SUBSCRIBED,
+    MQTT_EVENT_UNSUBSCRIBED,
+    MQTT_EVENT_PUBLISHED,
+    MQTT_EVENT_DATA,
+    MQTT_EVENT_BEFORE_CONNECT,
+} esp_mqtt_event_id_t;
+
+/** @brief Passed as event_data to the event handlers, with only the fields the producers read */
+typedef struct esp_mqtt_event_t {
+    esp_mqtt_event_id_t event_id;
+    esp_mqtt_client_handle_t client;
+    int msg_id;  // of the message acknowledged, for MQTT_EVENT_PUBLISHED
+} esp_mqtt_event_t;
+
+typedef esp_mqtt_event_t* esp_mqtt_event_handle_t;
+
+typedef struct {
+    const char* uri;
+    const char* client_id;
+    const char* username;
+    const char* password;
+    int keepalive;
+    int reconnect_timeout_ms;
+} esp_mqtt_client_config_t;
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t* config);
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client);
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t event_handler, void* event_handler_arg);
+
+/**
+ * @return message id, or -1 while the broker is down
+ */
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char* topic, const char* data, int len, int qos,
+                            int retain);
+
+/**
+ * @return bytes of the QoS 1 and 2 messages waiting on the broker's acknowledgement
+ */
+int esp_mqtt_client_get_outbox_size(esp_mqtt_client_handle_t client);
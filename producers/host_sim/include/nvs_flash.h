@@ -0,0 +1,12 @@
+#pragma once
+
+#include "esp_err.h"
+#include "nvs.h"
+
+/*
+ * NVS lives in memory, and in HOST_SIM_NVS_FILE across runs if that is set, so that boots after the first one can be
+ * simulated.
+ */
+
+esp_err_t nvs_flash_init();
+esp_err_t nvs_flash_erase();
@@ -0,0 +1,136 @@
+#include "esp_timer.h"
+
+#include <pthread.h>
+#include <time.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void* arg;
+    const char* name;
+
+    int64_t due_us;  // INT64_MAX while not armed
+    uint64_t period_us;  // 0 for one-shot timers
+};
+
+// few enough timers that a linear scan for the next one to fire beats keeping a heap consistent with stop/restart
+static std::mutex s_mutex;
+static std::condition_variable s_cv;
+static std::vector<esp_timer*> s_timers;
+static bool s_thread_started = false;
+
+static int64_t now_us() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static const int64_t s_boot_us = now_us();
+
+int64_t esp_timer_get_time() { return now_us() - s_boot_us; }
+
+static void timer_thread() {
+    pthread_setname_np(pthread_self(), "esp_timer");
+
+    std::unique_lock<std::mutex> lock(s_mutex);
+    while (true) {
+        esp_timer* next = NULL;
+        for (esp_timer* timer : s_timers) {
+            if (next == NULL || timer->due_us < next->due_us) {
+                next = timer;
+            }
+        }
+
+        if (next == NULL || next->due_us == INT64_MAX) {
+            s_cv.wait(lock);
+            continue;
+        }
+
+        int64_t now = esp_timer_get_time();
+        if (next->due_us > now) {
+            s_cv.wait_for(lock, std::chrono::microseconds(next->due_us - now));
+            continue;
+        }
+
+        // periodic timers keep their phase instead of drifting by however late the callback ran
+        next->due_us = next->period_us > 0 ? next->due_us + next->period_us : INT64_MAX;
+
+        // callbacks routinely restart timers, including their own
+        lock.unlock();
+        next->callback(next->arg);
+        lock.lock();
+    }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args, esp_timer_handle_t* out_handle) {
+    if (create_args == NULL || create_args->callback == NULL || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_timer* timer = new esp_timer();
+    timer->callback = create_args->callback;
+    timer->arg = create_args->arg;
+    timer->name = create_args->name;
+    timer->due_us = INT64_MAX;
+    timer->period_us = 0;
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_timers.push_back(timer);
+    if (!s_thread_started) {
+        std::thread(timer_thread).detach();
+        s_thread_started = true;
+    }
+
+    *out_handle = timer;
+
+    return ESP_OK;
+}
+
+static esp_err_t start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us) {
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (timer->due_us != INT64_MAX) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        timer->due_us = esp_timer_get_time() + timeout_us;
+        timer->period_us = period_us;
+    }
+    s_cv.notify_one();
+
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) { return start(timer, timeout_us, 0); }
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) { return start(timer, period, period); }
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (timer->due_us == INT64_MAX) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->due_us = INT64_MAX;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (timer->due_us != INT64_MAX) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    for (size_t i = 0; i < s_timers.size(); i++) {
+        if (s_timers[i] == timer) {
+            s_timers.erase(s_timers.begin() + i);
+            break;
+        }
+    }
+    delete timer;
+
+    return ESP_OK;
+}
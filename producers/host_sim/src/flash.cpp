@@ -0,0 +1,239 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "esp_partition.h"
+#include "host_sim.h"
+#include "nvs_flash.h"
+
+#define SECTOR_SIZE 4096
+
+static esp_partition_t s_evlog = {ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, 0x210000, 0, "evlog", false};
+
+static std::mutex s_mutex;
+static std::vector<uint8_t> s_evlog_data;
+
+typedef struct {
+    std::string name;
+    nvs_open_mode_t mode;
+} nvs_namespace_t;
+
+static bool s_nvs_initialized = false;
+static std::map<std::string, std::map<std::string, std::vector<uint8_t>>> s_nvs;
+static std::vector<nvs_namespace_t> s_nvs_handles;
+
+/*
+ * HOST_SIM_NVS_FILE holds a sequence of entries, each
+ *   uint32 namespace length, namespace, uint32 key length, key, uint32 value length, value
+ * in host byte order.
+ */
+
+static bool read_string(FILE* f, std::string* s) {
+    uint32_t len;
+    if (fread(&len, sizeof(len), 1, f) != 1 || len > 4096) {
+        return false;
+    }
+    s->resize(len);
+    return fread(&(*s)[0], 1, len, f) == len;
+}
+
+static void write_string(FILE* f, const void* data, uint32_t len) {
+    fwrite(&len, sizeof(len), 1, f);
+    fwrite(data, 1, len, f);
+}
+
+static void nvs_load() {
+    const char* path = getenv("HOST_SIM_NVS_FILE");
+    FILE* f = path != NULL ? fopen(path, "rb") : NULL;
+    if (f == NULL) {
+        return;
+    }
+
+    std::string name, key, value;
+    while (read_string(f, &name) && read_string(f, &key) && read_string(f, &value)) {
+        s_nvs[name][key].assign(value.begin(), value.end());
+    }
+    fclose(f);
+}
+
+static void nvs_save() {
+    const char* path = getenv("HOST_SIM_NVS_FILE");
+    FILE* f = path != NULL ? fopen(path, "wb") : NULL;
+    if (f == NULL) {
+        return;
+    }
+
+    for (const auto& name : s_nvs) {
+        for (const auto& entry : name.second) {
+            write_string(f, name.first.data(), name.first.size());
+            write_string(f, entry.first.data(), entry.first.size());
+            write_string(f, entry.second.data(), entry.second.size());
+        }
+    }
+    fclose(f);
+}
+
+esp_err_t nvs_flash_init() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (!s_nvs_initialized) {
+        nvs_load();
+        s_nvs_initialized = true;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_nvs.clear();
+    nvs_save();
+
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (!s_nvs_initialized) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    if (open_mode == NVS_READONLY && s_nvs.find(name) == s_nvs.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    s_nvs_handles.push_back({name, open_mode});
+    // handle 0 is never valid
+    *out_handle = s_nvs_handles.size();
+
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {}
+
+static nvs_namespace_t* nvs_lookup(nvs_handle_t handle) {
+    return handle > 0 && handle <= s_nvs_handles.size() ? &s_nvs_handles[handle - 1] : NULL;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    nvs_namespace_t* ns = nvs_lookup(handle);
+    if (ns == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+
+    auto& entries = s_nvs[ns->name];
+    auto entry = entries.find(key);
+    if (entry == entries.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    // a NULL buffer asks for the length only
+    if (out_value == NULL) {
+        *length = entry->second.size();
+        return ESP_OK;
+    }
+    if (*length < entry->second.size()) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out_value, entry->second.data(), entry->second.size());
+    *length = entry->second.size();
+
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    nvs_namespace_t* ns = nvs_lookup(handle);
+    if (ns == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (ns->mode == NVS_READONLY) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+
+    s_nvs[ns->name][key].assign((const uint8_t*)value, (const uint8_t*)value + length);
+
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    nvs_namespace_t* ns = nvs_lookup(handle);
+    if (ns == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (ns->mode == NVS_READONLY) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+
+    return s_nvs[ns->name].erase(key) > 0 ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (nvs_lookup(handle) == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    nvs_save();
+
+    return ESP_OK;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+    if (type != ESP_PARTITION_TYPE_DATA || label == NULL || strcmp(label, s_evlog.label) != 0) {
+        return NULL;
+    }
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (s_evlog_data.empty()) {
+        // same size as in the piano's partitions.csv, fresh flash reads as all ones
+        s_evlog.size = host_sim_env("HOST_SIM_EVLOG_SIZE", 256 * 1024);
+        s_evlog_data.assign(s_evlog.size, 0xFF);
+    }
+
+    return &s_evlog;
+}
+
+static bool in_bounds(const esp_partition_t* partition, size_t offset, size_t size) {
+    return partition == &s_evlog && offset <= s_evlog_data.size() && size <= s_evlog_data.size() - offset;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (!in_bounds(partition, src_offset, size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(dst, s_evlog_data.data() + src_offset, size);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (!in_bounds(partition, dst_offset, size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // NOR flash can only clear bits, a write over something that wasn't erased first corrupts it the same way
+    const uint8_t* bytes = (const uint8_t*)src;
+    for (size_t i = 0; i < size; i++) {
+        s_evlog_data[dst_offset + i] &= bytes[i];
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (!in_bounds(partition, offset, size) || offset % SECTOR_SIZE != 0 || size % SECTOR_SIZE != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(s_evlog_data.data() + offset, 0xFF, size);
+
+    return ESP_OK;
+}
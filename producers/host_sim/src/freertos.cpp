@@ -0,0 +1,180 @@
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "freertos/event_groups.h"
+#include "freertos/task.h"
+
+struct sim_task {
+    TaskFunction_t code;
+    void* param;
+    pthread_t thread;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    uint32_t notifications = 0;
+};
+
+struct sim_event_group {
+    std::mutex mutex;
+    std::condition_variable cv;
+    EventBits_t bits = 0;
+};
+
+// app_main and anything else that isn't a task gets this one, so that they can wait on notifications too
+static sim_task s_main_task;
+static thread_local sim_task* s_current = &s_main_task;
+
+static std::chrono::steady_clock::time_point deadline(TickType_t ticks) {
+    return std::chrono::steady_clock::now() + std::chrono::milliseconds((uint64_t)ticks * portTICK_PERIOD_MS);
+}
+
+static void* task_entry(void* arg) {
+    sim_task* task = (sim_task*)arg;
+    s_current = task;
+    task->code(task->param);
+
+    // FreeRTOS tasks must never return, the producers' loops don't, but don't take the process down if one does
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char* name, uint32_t stack_depth, void* param, UBaseType_t priority,
+                       TaskHandle_t* created_task) {
+    sim_task* task = new sim_task();
+    task->code = code;
+    task->param = param;
+
+    // the handle has to be out before the task runs, tasks are often notified by whoever created them right away
+    if (created_task != NULL) {
+        *created_task = task;
+    }
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int err = pthread_create(&task->thread, &attr, task_entry, task);
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        delete task;
+        return pdFAIL;
+    }
+
+    pthread_setname_np(task->thread, name);
+
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    // only self-deletion is used, other tasks would have to be cancelled at a point where they hold no locks
+    if (task == NULL || task == s_current) {
+        pthread_exit(NULL);
+    }
+}
+
+void vTaskDelay(TickType_t ticks) {
+    // a delay of 0 ticks is a yield on the device
+    if (ticks == 0) {
+        sched_yield();
+        return;
+    }
+
+    std::this_thread::sleep_until(deadline(ticks));
+}
+
+TickType_t xTaskGetTickCount() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (TickType_t)((uint64_t)now.tv_sec * configTICK_RATE_HZ + now.tv_nsec / (1000000000 / configTICK_RATE_HZ));
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+    sim_task* task = s_current;
+    std::unique_lock<std::mutex> lock(task->mutex);
+
+    auto pending = [task] { return task->notifications > 0; };
+    if (ticks_to_wait == portMAX_DELAY) {
+        task->cv.wait(lock, pending);
+    } else {
+        task->cv.wait_until(lock, deadline(ticks_to_wait), pending);
+    }
+
+    uint32_t value = task->notifications;
+    if (value > 0) {
+        task->notifications = clear_on_exit ? 0 : value - 1;
+    }
+
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->notifications++;
+    }
+    task->cv.notify_one();
+
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken) {
+    xTaskNotifyGive(task);
+    if (higher_priority_task_woken != NULL) {
+        *higher_priority_task_woken = pdFALSE;
+    }
+}
+
+EventGroupHandle_t xEventGroupCreate() { return new sim_event_group(); }
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    EventBits_t value;
+    {
+        std::lock_guard<std::mutex> lock(group->mutex);
+        group->bits |= bits;
+        value = group->bits;
+    }
+    group->cv.notify_all();
+
+    return value;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    std::lock_guard<std::mutex> lock(group->mutex);
+    EventBits_t value = group->bits;
+    group->bits &= ~bits;
+
+    return value;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    std::lock_guard<std::mutex> lock(group->mutex);
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks_to_wait) {
+    std::unique_lock<std::mutex> lock(group->mutex);
+
+    auto satisfied = [group, bits, wait_for_all] {
+        return wait_for_all ? (group->bits & bits) == bits : (group->bits & bits) != 0;
+    };
+    bool met;
+    if (ticks_to_wait == portMAX_DELAY) {
+        group->cv.wait(lock, satisfied);
+        met = true;
+    } else {
+        met = group->cv.wait_until(lock, deadline(ticks_to_wait), satisfied);
+    }
+
+    // like FreeRTOS, the bits as they were before clearing
+    EventBits_t value = group->bits;
+    if (met && clear_on_exit) {
+        group->bits &= ~bits;
+    }
+
+    return value;
+}
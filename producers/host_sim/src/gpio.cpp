@@ -0,0 +1,98 @@
+#include <atomic>
+#include <mutex>
+
+#include "driver/gpio.h"
+#include "host_sim.h"
+
+typedef struct {
+    gpio_isr_t handler;
+    void* arg;
+} isr_t;
+
+static std::mutex s_mutex;
+static bool s_isr_service_installed = false;
+static isr_t s_isrs[GPIO_NUM_MAX];
+static std::atomic<uint32_t> s_levels{0};
+static std::atomic<uint32_t> s_level_changes[GPIO_NUM_MAX];
+
+static bool valid(gpio_num_t gpio_num) { return gpio_num >= 0 && gpio_num < GPIO_NUM_MAX; }
+
+esp_err_t gpio_config(const gpio_config_t* config) {
+    if (config == NULL || (config->pin_bit_mask >> GPIO_NUM_MAX) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+    if (!valid(gpio_num) || gpio_num >= 32) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t bit = 1u << gpio_num;
+    uint32_t previous = level ? s_levels.fetch_or(bit) : s_levels.fetch_and(~bit);
+    if (((previous & bit) != 0) != (level != 0)) {
+        s_level_changes[gpio_num]++;
+    }
+
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+    return valid(gpio_num) && gpio_num < 32 ? (s_levels.load() >> gpio_num) & 1 : 0;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (s_isr_service_installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_isr_service_installed = true;
+
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void* args) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (!s_isr_service_installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!valid(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_isrs[gpio_num] = {isr_handler, args};
+
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (!valid(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_isrs[gpio_num] = {NULL, NULL};
+
+    return ESP_OK;
+}
+
+void host_sim_gpio_trigger(gpio_num_t pin) {
+    isr_t isr = {NULL, NULL};
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (valid(pin)) {
+            isr = s_isrs[pin];
+        }
+    }
+
+    if (isr.handler != NULL) {
+        isr.handler(isr.arg);
+    }
+}
+
+void host_sim_gpio_summary(FILE* out) {
+    for (int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        if (s_level_changes[pin] > 0) {
+            fprintf(out, "gpio %d: %u level changes\n", pin, s_level_changes[pin].load());
+        }
+    }
+}
@@ -0,0 +1,8 @@
+#include <stdlib.h>
+
+#include "host_sim.h"
+
+long host_sim_env(const char* name, long fallback) {
+    const char* value = getenv(name);
+    return value != NULL ? strtol(value, NULL, 10) : fallback;
+}
@@ -0,0 +1,235 @@
+#include "mqtt_client.h"
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "esp_timer.h"
+#include "host_sim.h"
+
+typedef struct {
+    esp_mqtt_event_id_t event;
+    esp_event_handler_t handler;
+    void* arg;
+} mqtt_handler_t;
+
+typedef struct {
+    int64_t due_us;  // when the broker's acknowledgement comes in
+    int msg_id;
+    int len;
+} unacked_t;
+
+typedef struct {
+    uint32_t count;
+    uint64_t bytes;
+    std::string last;
+} topic_stats_t;
+
+struct esp_mqtt_client {
+    std::string uri;
+    int reconnect_timeout_ms;
+    std::vector<mqtt_handler_t> handlers;
+
+    std::mutex mutex;
+    bool connected = false;
+    int next_msg_id = 1;
+    // QoS 1 and 2 messages the broker hasn't acknowledged yet, oldest first, kept in the outbox until it does
+    std::deque<unacked_t> unacked;
+    std::condition_variable unacked_changed;
+    int outbox_bytes = 0;
+    uint32_t rejected = 0;
+    std::map<std::string, topic_stats_t> topics;
+};
+
+static esp_mqtt_client* s_client = NULL;
+static const bool s_verbose = host_sim_env("HOST_SIM_VERBOSE", 0) != 0;
+static const int64_t s_ack_us = host_sim_env("HOST_SIM_MQTT_ACK_MS", 2) * 1000;
+
+static bool printable(const std::string& body) {
+    for (char c : body) {
+        if (!isprint((unsigned char)c) && !isspace((unsigned char)c)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void dispatch(esp_mqtt_client* client, esp_mqtt_event_id_t event, int msg_id = 0) {
+    esp_mqtt_event_t data = {event, client, msg_id};
+    for (const mqtt_handler_t& h : client->handlers) {
+        if (h.event == MQTT_EVENT_ANY || h.event == event) {
+            h.handler(h.arg, "MQTT_EVENTS", event, &data);
+        }
+    }
+}
+
+static void set_connected(esp_mqtt_client* client, bool connected) {
+    {
+        std::lock_guard<std::mutex> lock(client->mutex);
+        client->connected = connected;
+        // whatever was in flight is lost with the connection
+        client->unacked.clear();
+        client->outbox_bytes = 0;
+    }
+    dispatch(client, connected ? MQTT_EVENT_CONNECTED : MQTT_EVENT_DISCONNECTED);
+}
+
+static void sleep_until_s(double at_s) {
+    int64_t delay_us = (int64_t)(at_s * 1000000) - esp_timer_get_time();
+    if (delay_us > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(delay_us));
+    }
+}
+
+// stands in for the client's own task, which is where the real client calls the event handlers from
+static void mqtt_task(esp_mqtt_client* client) {
+    pthread_setname_np(pthread_self(), "mqtt_task");
+
+    while (!host_sim_has_ip()) {
+        dispatch(client, MQTT_EVENT_ERROR);
+        std::this_thread::sleep_for(std::chrono::milliseconds(client->reconnect_timeout_ms));
+    }
+
+    // connecting to a broker on the LAN takes a few milliseconds
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    set_connected(client, true);
+
+    double from_s, to_s;
+    const char* outage = getenv("HOST_SIM_MQTT_OUTAGE");
+    if (outage == NULL || sscanf(outage, "%lf,%lf", &from_s, &to_s) != 2 || to_s <= from_s) {
+        return;
+    }
+
+    sleep_until_s(from_s);
+    set_connected(client, false);
+    sleep_until_s(to_s);
+    set_connected(client, true);
+}
+
+// the broker's acknowledgements, each HOST_SIM_MQTT_ACK_MS after its publish, from the client's task like the real ones
+static void ack_task(esp_mqtt_client* client) {
+    pthread_setname_np(pthread_self(), "mqtt_ack");
+
+    std::unique_lock<std::mutex> lock(client->mutex);
+    while (true) {
+        client->unacked_changed.wait(lock, [client] { return !client->unacked.empty(); });
+
+        int64_t due_us = client->unacked.front().due_us;
+        int64_t now_us = esp_timer_get_time();
+        if (now_us < due_us) {
+            client->unacked_changed.wait_for(lock, std::chrono::microseconds(due_us - now_us));
+            continue;
+        }
+
+        int msg_id = client->unacked.front().msg_id;
+        client->outbox_bytes -= client->unacked.front().len;
+        client->unacked.pop_front();
+        lock.unlock();
+        dispatch(client, MQTT_EVENT_PUBLISHED, msg_id);
+        lock.lock();
+    }
+}
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t* config) {
+    esp_mqtt_client* client = new esp_mqtt_client();
+    client->uri = config->uri != NULL ? config->uri : "";
+    client->reconnect_timeout_ms = config->reconnect_timeout_ms > 0 ? config->reconnect_timeout_ms : MQTT_RECON_DEFAULT_MS;
+    s_client = client;
+
+    return client;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client) {
+    std::thread(mqtt_task, client).detach();
+    std::thread(ack_task, client).detach();
+
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t event_handler, void* event_handler_arg) {
+    client->handlers.push_back({event, event_handler, event_handler_arg});
+
+    return ESP_OK;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char* topic, const char* data, int len, int qos,
+                            int retain) {
+    if (len <= 0) {
+        len = data != NULL ? strlen(data) : 0;
+    }
+
+    std::lock_guard<std::mutex> lock(client->mutex);
+    if (!client->connected) {
+        client->rejected++;
+        return -1;
+    }
+
+    topic_stats_t& stats = client->topics[topic];
+    stats.count++;
+    stats.bytes += len;
+    stats.last.assign(data, len);
+
+    if (s_verbose) {
+        if (printable(stats.last)) {
+            printf("mqtt %s %s\n", topic, stats.last.c_str());
+        } else {
+            printf("mqtt %s <%d bytes>\n", topic, len);
+        }
+    }
+
+    int msg_id = client->next_msg_id++;
+    if (qos > 0) {
+        client->unacked.push_back({esp_timer_get_time() + s_ack_us, msg_id, len});
+        client->outbox_bytes += len;
+        client->unacked_changed.notify_one();
+    }
+
+    return msg_id;
+}
+
+int esp_mqtt_client_get_outbox_size(esp_mqtt_client_handle_t client) {
+    std::lock_guard<std::mutex> lock(client->mutex);
+    return client->outbox_bytes;
+}
+
+void host_sim_mqtt_summary(FILE* out, double seconds) {
+    if (s_client == NULL) {
+        fprintf(out, "mqtt: no client\n");
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(s_client->mutex);
+    uint32_t count = 0;
+    uint64_t bytes = 0;
+    for (const auto& topic : s_client->topics) {
+        count += topic.second.count;
+        bytes += topic.second.bytes;
+    }
+
+    fprintf(out, "mqtt: %u publishes (%.1f/s), %llu bytes, %u rejected while disconnected\n", count,
+            seconds > 0 ? count / seconds : 0.0, (unsigned long long)bytes, s_client->rejected);
+    for (const auto& topic : s_client->topics) {
+        const topic_stats_t& stats = topic.second;
+        fprintf(out, "  %-32s %8u  %10llu bytes  last: ", topic.first.c_str(), stats.count,
+                (unsigned long long)stats.bytes);
+        if (printable(stats.last)) {
+            // debug messages often end in a newline of their own
+            size_t len = stats.last.find_last_not_of(" \r\n") + 1;
+            fprintf(out, "%.*s\n", (int)len, stats.last.c_str());
+        } else {
+            fprintf(out, "<%zu bytes>\n", stats.last.size());
+        }
+    }
+}
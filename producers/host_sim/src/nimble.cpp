@@ -0,0 +1,222 @@
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "NimBLEDevice.h"
+#include "ble_midi.h"
+#include "config.h"
+#include "esp_timer.h"
+#include "host_sim.h"
+
+#define MIDI_NOTE_OFF 0x80
+#define MIDI_NOTE_ON 0x90
+#define MIDI_CONTROL_CHANGE 0xB0
+
+// 3 bytes of MIDI message and its timestamp byte
+#define MIDI_MESSAGE_SIZE 4
+#define MAX_MESSAGES_PER_PACKET 32
+
+static NimBLEScan s_scan;
+static NimBLEClient s_client;
+static bool s_client_created = false;
+static NimBLEAdvertisedDevice s_piano(NimBLEAddress("c0:ff:ee:00:00:01"), NimBLEUUID(PIANO_UUID));
+// a phone, a fitness band and a beacon
+static NimBLEAdvertisedDevice s_neighbours[] = {
+    NimBLEAdvertisedDevice(NimBLEAddress("4a:11:22:33:44:55"), NimBLEUUID("0000fd6f-0000-1000-8000-00805f9b34fb")),
+    NimBLEAdvertisedDevice(NimBLEAddress("e4:aa:bb:cc:dd:ee"), NimBLEUUID("0000180d-0000-1000-8000-00805f9b34fb")),
+    NimBLEAdvertisedDevice(NimBLEAddress("d0:01:02:03:04:05"), NimBLEUUID("0000feaa-0000-1000-8000-00805f9b34fb")),
+};
+static NimBLERemoteCharacteristic s_midi(NimBLEUUID(BLE_MIDI_CHARACTERISTIC_UUID));
+static NimBLERemoteService s_midi_service(NimBLEUUID(PIANO_UUID), &s_midi);
+
+static std::atomic<uint32_t> s_scan_reports{0};
+static std::atomic<uint32_t> s_scan_filtered{0};
+
+static notify_callback s_notify;
+static notify_view_callback s_notify_view;
+static std::atomic<bool> s_playing{false};
+static std::atomic<uint32_t> s_notifications{0};
+static std::atomic<uint32_t> s_messages{0};
+
+NimBLEUUID::NimBLEUUID(const std::string& uuid) : m_uuid(uuid) {
+    std::transform(m_uuid.begin(), m_uuid.end(), m_uuid.begin(), [](unsigned char c) { return tolower(c); });
+}
+
+NimBLEUUID::NimBLEUUID(const ble_uuid128_t* uuid) {
+    // the string form, most significant byte first
+    char buf[37];
+    char* p = buf;
+    for (int i = 15; i >= 0; i--) {
+        p += sprintf(p, "%02x", uuid->value[i]);
+        if (i == 12 || i == 10 || i == 8 || i == 6) {
+            *p++ = '-';
+        }
+    }
+    m_uuid = buf;
+}
+
+/**
+ * @brief Play up and down a scale, with the sustain pedal going down and up every octave, in BLE-MIDI notifications
+ * of `per_packet` messages each
+ */
+static void play(long notes_per_second, long per_packet) {
+    pthread_setname_np(pthread_self(), "nimble_host");
+
+    uint8_t packet[1 + MAX_MESSAGES_PER_PACKET * MIDI_MESSAGE_SIZE];
+    auto interval = std::chrono::duration<double>((double)per_packet / notes_per_second);
+    auto next = std::chrono::steady_clock::now();
+    uint32_t n = 0;
+
+    while (s_playing) {
+        uint16_t timestamp_ms = (esp_timer_get_time() / 1000) & 0x1FFF;
+        packet[0] = 0x80 | (timestamp_ms >> 7);
+
+        uint8_t* p = packet + 1;
+        for (long i = 0; i < per_packet; i++, n++) {
+            uint8_t key = 48 + (n / 2) % 24;
+            *p++ = 0x80 | (timestamp_ms & 0x7F);
+            if (n % 24 == 23) {
+                *p++ = MIDI_CONTROL_CHANGE;
+                *p++ = BLE_MIDI_CC_SUSTAIN;
+                *p++ = (n / 24) % 2 == 0 ? 127 : 0;
+            } else {
+                *p++ = n % 2 == 0 ? MIDI_NOTE_ON : MIDI_NOTE_OFF;
+                *p++ = key;
+                *p++ = 64;
+            }
+        }
+
+        if (s_notify_view != nullptr) {
+            s_notify_view(&s_midi, NimBLEMbufView(packet, p - packet), true);
+        } else {
+            s_notify(&s_midi, packet, p - packet, true);
+        }
+        s_notifications++;
+        s_messages += per_packet;
+
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+        std::this_thread::sleep_until(next);
+    }
+}
+
+static bool start_playing(notify_callback notify, notify_view_callback notify_view) {
+    long notes_per_second = host_sim_env("HOST_SIM_NOTES_PER_SECOND", 20);
+    long per_packet = std::min(std::max(host_sim_env("HOST_SIM_NOTES_PER_PACKET", 1), 1L), (long)MAX_MESSAGES_PER_PACKET);
+    if ((notify == nullptr && notify_view == nullptr) || s_playing.exchange(true)) {
+        return false;
+    }
+
+    s_notify = notify;
+    s_notify_view = notify_view;
+    if (notes_per_second > 0) {
+        std::thread(play, notes_per_second, per_packet).detach();
+    }
+
+    return true;
+}
+
+bool NimBLERemoteCharacteristic::subscribe(bool notifications, notify_callback notifyCallback, bool response) {
+    return start_playing(notifyCallback, nullptr);
+}
+
+bool NimBLERemoteCharacteristic::subscribeView(bool notifications, notify_view_callback notifyCallback,
+                                               bool response) {
+    return start_playing(nullptr, notifyCallback);
+}
+
+bool NimBLERemoteCharacteristic::unsubscribe(bool response) {
+    s_playing = false;
+    return true;
+}
+
+NimBLERemoteCharacteristic* NimBLERemoteService::getCharacteristic(const NimBLEUUID& uuid) {
+    return uuid == m_characteristic->getUUID() ? m_characteristic : nullptr;
+}
+
+bool NimBLEClient::s_attributesSaved = false;
+
+bool NimBLEClient::connect(NimBLEAdvertisedDevice* device, bool deleteAttributes) {
+    m_connected = true;
+    if (m_callbacks != nullptr) {
+        m_callbacks->onConnect(this);
+    }
+    return true;
+}
+
+int NimBLEClient::disconnect(uint8_t reason) {
+    s_playing = false;
+    m_connected = false;
+    if (m_callbacks != nullptr) {
+        m_callbacks->onDisconnect(this);
+    }
+    return 0;
+}
+
+NimBLERemoteService* NimBLEClient::getService(const NimBLEUUID& uuid) {
+    return m_connected && uuid == s_midi_service.getUUID() ? &s_midi_service : nullptr;
+}
+
+bool NimBLEScan::start(uint32_t duration, bool is_continue) {
+    m_stopped = false;
+
+    // the piano advertises every 100 ms or so, its neighbours get in first
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    for (NimBLEAdvertisedDevice& device : s_neighbours) {
+        report(&device, -70);
+    }
+    report(&s_piano, -50);
+
+    if (!m_stopped && duration > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(duration * 1000 - 100));
+    }
+
+    return true;
+}
+
+void NimBLEScan::report(NimBLEAdvertisedDevice* device, int8_t rssi) {
+    if (m_stopped) {
+        return;
+    }
+    if (!m_filter.matches(device->getServiceUUID(), rssi)) {
+        s_scan_filtered++;
+        return;
+    }
+
+    s_scan_reports++;
+    if (m_callbacks != nullptr) {
+        m_callbacks->onResult(device);
+    }
+}
+
+bool NimBLEScan::stop() {
+    m_stopped = true;
+    return true;
+}
+
+NimBLEAdvertisedDeviceAllocStats NimBLEAdvertisedDevice::getAllocStats() {
+    NimBLEAdvertisedDeviceAllocStats stats = {};
+    stats.poolAllocs = s_scan_reports.load();
+    stats.inUse = stats.highWater = 1;
+    return stats;
+}
+
+NimBLEScan* NimBLEDevice::getScan() { return &s_scan; }
+
+NimBLEClient* NimBLEDevice::createClient() {
+    s_client_created = true;
+    return &s_client;
+}
+
+NimBLEClient* NimBLEDevice::getDisconnectedClient() {
+    return s_client_created && !s_client.isConnected() ? &s_client : nullptr;
+}
+
+void host_sim_ble_summary(FILE* out) {
+    fprintf(out, "ble: %u scan reports, %u filtered out, %u notifications, %u MIDI messages\n", s_scan_reports.load(),
+            s_scan_filtered.load(), s_notifications.load(), s_messages.load());
+}
@@ -0,0 +1,41 @@
+/*
+ * Runs a producer's app_main on the host for a while, then prints what reached the simulated broker.
+ *
+ *   ./piano_sim [seconds]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <thread>
+
+#include "esp_timer.h"
+#include "host_sim.h"
+#include "producer_runtime.h"
+
+extern "C" void app_main();
+
+// the piano sim links the bluetooth stand-in, the template doesn't
+__attribute__((weak)) void host_sim_ble_summary(FILE* out) {}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 10;
+
+    app_main();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+
+    double elapsed = esp_timer_get_time() / 1e6;
+    runtime_stats_t stats;
+    runtime_get_stats(&stats);
+
+    printf("ran for %.2f s\n", elapsed);
+    host_sim_mqtt_summary(stdout, elapsed);
+    host_sim_ble_summary(stdout);
+    host_sim_gpio_summary(stdout);
+    printf("runtime: %u publisher wakeups, %u timer, %u gpio, %u notify\n", stats.publisher_wakeups,
+           stats.timer_wakeups, stats.gpio_wakeups, stats.notify_wakeups);
+    fflush(stdout);
+
+    // the producer's tasks never return, so don't wait for them
+    _Exit(0);
+}
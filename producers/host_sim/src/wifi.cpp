@@ -0,0 +1,271 @@
+#include <pthread.h>
+#include <string.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+#include "host_sim.h"
+
+esp_event_base_t const WIFI_EVENT = "WIFI_EVENT";
+esp_event_base_t const IP_EVENT = "IP_EVENT";
+
+struct esp_netif_obj {
+    bool dhcpc_running;
+    esp_netif_ip_info_t ip_info;
+    esp_netif_dns_info_t dns;
+};
+
+typedef struct {
+    esp_event_base_t base;
+    int32_t id;
+    esp_event_handler_t handler;
+    void* arg;
+} loop_handler_t;
+
+typedef struct {
+    esp_event_base_t base;
+    int32_t id;
+    std::vector<uint8_t> data;
+} posted_event_t;
+
+static std::mutex s_mutex;
+static std::condition_variable s_cv;
+static std::vector<loop_handler_t> s_handlers;
+static std::deque<posted_event_t> s_queue;
+static bool s_loop_created = false;
+
+static esp_netif_obj s_sta_netif;
+static wifi_config_t s_sta_config;
+static bool s_sta_connected = false;
+static bool s_sta_has_ip = false;
+
+// the one access point there is
+static const uint8_t s_ap_bssid[6] = {0x24, 0x4b, 0xfe, 0x12, 0x34, 0x56};
+static const uint8_t s_ap_channel = 6;
+
+// what the DHCP server hands out, 192.168.4.2/24 behind 192.168.4.1 in network byte order
+static const esp_netif_ip_info_t s_lease = {{0x0204a8c0}, {0x00ffffff}, {0x0104a8c0}};
+
+static void event_loop() {
+    pthread_setname_np(pthread_self(), "sys_evt");
+
+    std::unique_lock<std::mutex> lock(s_mutex);
+    while (true) {
+        s_cv.wait(lock, [] { return !s_queue.empty(); });
+        posted_event_t event = std::move(s_queue.front());
+        s_queue.pop_front();
+
+        // handlers may post events or register more handlers
+        std::vector<loop_handler_t> handlers = s_handlers;
+        lock.unlock();
+        for (const loop_handler_t& h : handlers) {
+            // event bases are compared by address, as on the device
+            if (h.base == event.base && (h.id == ESP_EVENT_ANY_ID || h.id == event.id)) {
+                h.handler(h.arg, event.base, event.id, event.data.empty() ? NULL : event.data.data());
+            }
+        }
+        lock.lock();
+    }
+}
+
+esp_err_t esp_event_loop_create_default() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (s_loop_created) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    std::thread(event_loop).detach();
+    s_loop_created = true;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t event_base, int32_t event_id,
+                                              esp_event_handler_t event_handler, void* event_handler_arg,
+                                              esp_event_handler_instance_t* instance) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_handlers.push_back({event_base, event_id, event_handler, event_handler_arg});
+    if (instance != NULL) {
+        *instance = (esp_event_handler_instance_t)s_handlers.size();
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id, const void* event_data,
+                         size_t event_data_size, uint32_t ticks_to_wait) {
+    posted_event_t event;
+    event.base = event_base;
+    event.id = event_id;
+    if (event_data != NULL) {
+        event.data.assign((const uint8_t*)event_data, (const uint8_t*)event_data + event_data_size);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (!s_loop_created) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        s_queue.push_back(std::move(event));
+    }
+    s_cv.notify_one();
+
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_init() { return ESP_OK; }
+
+esp_netif_t* esp_netif_create_default_wifi_sta() {
+    s_sta_netif.dhcpc_running = true;
+    return &s_sta_netif;
+}
+
+esp_err_t esp_netif_dhcpc_start(esp_netif_t* esp_netif) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    esp_netif->dhcpc_running = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_dhcpc_stop(esp_netif_t* esp_netif) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    esp_netif->dhcpc_running = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_set_ip_info(esp_netif_t* esp_netif, const esp_netif_ip_info_t* ip_info) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (esp_netif->dhcpc_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_netif->ip_info = *ip_info;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_get_ip_info(esp_netif_t* esp_netif, esp_netif_ip_info_t* ip_info) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    *ip_info = esp_netif->ip_info;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_set_dns_info(esp_netif_t* esp_netif, esp_netif_dns_type_t type, esp_netif_dns_info_t* dns) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (type == ESP_NETIF_DNS_MAIN) {
+        esp_netif->dns = *dns;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_get_dns_info(esp_netif_t* esp_netif, esp_netif_dns_type_t type, esp_netif_dns_info_t* dns) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    *dns = type == ESP_NETIF_DNS_MAIN ? esp_netif->dns : esp_netif_dns_info_t{};
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_init(const wifi_init_config_t* config) { return ESP_OK; }
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode) { return mode == WIFI_MODE_STA ? ESP_OK : ESP_ERR_INVALID_ARG; }
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t* conf) {
+    if (interface != WIFI_IF_STA || conf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_sta_config = *conf;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t* conf) {
+    if (interface != WIFI_IF_STA || conf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(s_mutex);
+    *conf = s_sta_config;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_start() { return esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_START, NULL, 0, 0); }
+
+static void sleep_ms(long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+static void associate(wifi_sta_config_t sta) {
+    bool directed = sta.bssid_set && sta.channel != 0;
+    if (directed && (memcmp(sta.bssid, s_ap_bssid, sizeof(s_ap_bssid)) != 0 || sta.channel != s_ap_channel ||
+                     host_sim_env("HOST_SIM_WIFI_AP_MOVED", 0))) {
+        // the station probes the one channel it was given and gives up
+        sleep_ms(host_sim_env("HOST_SIM_WIFI_DIRECTED_MS", 40));
+
+        wifi_event_sta_disconnected_t disconnected = {};
+        memcpy(disconnected.bssid, sta.bssid, sizeof(sta.bssid));
+        disconnected.reason = WIFI_REASON_NO_AP_FOUND;
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &disconnected, sizeof(disconnected), 0);
+        return;
+    }
+
+    sleep_ms(directed ? host_sim_env("HOST_SIM_WIFI_DIRECTED_MS", 40) : host_sim_env("HOST_SIM_WIFI_SCAN_MS", 1200));
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_sta_connected = true;
+    }
+    esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, NULL, 0, 0);
+
+    bool dhcp;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        dhcp = s_sta_netif.dhcpc_running;
+    }
+    if (dhcp) {
+        sleep_ms(host_sim_env("HOST_SIM_DHCP_MS", 300));
+    }
+
+    ip_event_got_ip_t got_ip = {};
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (s_sta_netif.dhcpc_running) {
+            s_sta_netif.ip_info = s_lease;
+            s_sta_netif.dns.ip.u_addr.ip4.addr = s_lease.gw.addr;
+        }
+        s_sta_has_ip = true;
+        got_ip.esp_netif = &s_sta_netif;
+        got_ip.ip_info = s_sta_netif.ip_info;
+        got_ip.ip_changed = true;
+    }
+    esp_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &got_ip, sizeof(got_ip), 0);
+}
+
+esp_err_t esp_wifi_connect() {
+    wifi_sta_config_t sta;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        sta = s_sta_config.sta;
+    }
+    std::thread(associate, sta).detach();
+
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t* ap_info) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (!s_sta_connected) {
+        return ESP_ERR_WIFI_NOT_CONNECT;
+    }
+
+    *ap_info = {};
+    memcpy(ap_info->bssid, s_ap_bssid, sizeof(s_ap_bssid));
+    memcpy(ap_info->ssid, s_sta_config.sta.ssid, sizeof(s_sta_config.sta.ssid));
+    ap_info->primary = s_ap_channel;
+    ap_info->rssi = -50;
+
+    return ESP_OK;
+}
+
+bool host_sim_has_ip() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return s_sta_has_ip;
+}
@@ -28,6 +28,8 @@
 #undef max
 /**************************/
 
+#include "NimBLELiteral.h"
+
 #include <string>
 #include <algorithm>
 
@@ -53,6 +55,22 @@ public:
     operator        std::string() const;
     operator        uint64_t() const;
 
+    /**
+     * @brief Parse an address string at compile time.
+     * @details Use it to initialize a constexpr ble_addr_t, which is then stored in flash, and construct a
+     * NimBLEAddress from that. A malformed string fails to compile.\n
+     * <tt>static constexpr ble_addr_t peer = NimBLEAddress::literal("a4:c1:38:5d:ef:16");</tt>
+     * @param [in] address The address string, of the form "a4:c1:38:5d:ef:16".
+     * @param [in] type The type of the address.
+     * @return The native address.
+     */
+    static constexpr ble_addr_t literal(const char (&address)[18], uint8_t type = BLE_ADDR_PUBLIC) {
+        return ble_addr_t{type, {
+            NimBLELiteral::addressByte(address, 0), NimBLELiteral::addressByte(address, 1),
+            NimBLELiteral::addressByte(address, 2), NimBLELiteral::addressByte(address, 3),
+            NimBLELiteral::addressByte(address, 4), NimBLELiteral::addressByte(address, 5)}};
+    }
+
 private:
     uint8_t        m_address[6];
     uint8_t        m_addrType;
@@ -0,0 +1,130 @@
+/*
+ * NimBLEAdvFieldIndex.h
+ *
+ *  Created: on October 17 2026
+ */
+
+#ifndef COMPONENTS_NIMBLE_ADV_FIELD_INDEX_H_
+#define COMPONENTS_NIMBLE_ADV_FIELD_INDEX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Positions of the AD structures in an advertisement payload, grouped by type.
+ * @details The payload is walked once when it is stored, after which finding a field of some type is a binary
+ * search over the types present instead of a walk over the payload. Results are exactly those of walking the
+ * payload, including for malformed payloads. Has no dependencies on the stack so that it also builds on a host.
+ * @tparam N The size of the payload buffer, at most 255.
+ */
+template<size_t N>
+class NimBLEAdvFieldIndex {
+    static_assert(N <= 255, "field offsets are stored in a byte");
+
+public:
+    /**
+     * @brief Index a payload, replacing the previous one.
+     * @param [in] payload The payload, which must stay in place while the index is used.
+     * @param [in] length The length of the payload in bytes, at most N.
+     */
+    void build(const uint8_t* payload, size_t length) {
+        m_count = 0;
+        m_end = 0;
+        m_state = length < 3 ? EMPTY : COMPLETE;
+
+        size_t data = 0;
+        while(length > 2) {
+            uint8_t fieldLength = payload[data];
+            if(fieldLength >= length) {
+                m_state = TRUNCATED;
+                break;
+            }
+
+            // Insertion sort by type keeps fields of one type in payload order, there are only a handful.
+            uint8_t type = payload[data + 1];
+            size_t i = m_count++;
+            while(i > 0 && payload[m_fields[i - 1] + 1] > type) {
+                m_fields[i] = m_fields[i - 1];
+                i--;
+            }
+            m_fields[i] = (uint8_t)data;
+
+            length -= 1 + fieldLength;
+            data += 1 + fieldLength;
+        }
+        m_end = (uint8_t)data;
+    } // build
+
+
+    /**
+     * @brief Count the items of a type, and find the field an item is in.
+     * @param [in] payload The payload that was indexed.
+     * @param [in] type The AD type to look for.
+     * @param [in] index With data_loc, stop at the field where the count reaches this, 0 stops at the first.
+     * @param [out] data_loc The offset of the field that was stopped at, or of the end of the payload if none was.
+     * @return The number of items counted: UUIDs or addresses for list types, fields otherwise.
+     */
+    uint8_t find(const uint8_t* payload, uint8_t type, uint8_t index = 0, size_t* data_loc = nullptr) const {
+        uint8_t count = 0;
+
+        size_t lo = 0, hi = m_count;
+        while(lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if(payload[m_fields[mid] + 1] < type) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+
+        for(size_t i = lo; i < m_count && payload[m_fields[i] + 1] == type; i++) {
+            count += itemCount(type, payload[m_fields[i]]);
+            if(data_loc != nullptr && (index == 0 || count >= index)) {
+                *data_loc = m_fields[i];
+                return count;
+            }
+        }
+
+        // A walk that ran into a field longer than the payload gave up without a location.
+        if(data_loc != nullptr && m_state == COMPLETE) {
+            *data_loc = m_end;
+        }
+        return count;
+    } // find
+
+private:
+    /**
+     * @brief Get the number of items in a field, going by its length byte, which includes the type.
+     */
+    static uint8_t itemCount(uint8_t type, uint8_t length) {
+        switch(type) {
+            case 0x02: // BLE_HS_ADV_TYPE_INCOMP_UUIDS16
+            case 0x03: // BLE_HS_ADV_TYPE_COMP_UUIDS16
+                return length / 2;
+            case 0x04: // BLE_HS_ADV_TYPE_INCOMP_UUIDS32
+            case 0x05: // BLE_HS_ADV_TYPE_COMP_UUIDS32
+                return length / 4;
+            case 0x06: // BLE_HS_ADV_TYPE_INCOMP_UUIDS128
+            case 0x07: // BLE_HS_ADV_TYPE_COMP_UUIDS128
+                return length / 16;
+            case 0x17: // BLE_HS_ADV_TYPE_PUBLIC_TGT_ADDR
+            case 0x18: // BLE_HS_ADV_TYPE_RANDOM_TGT_ADDR
+                return length / 6;
+            default:
+                return 1;
+        }
+    } // itemCount
+
+    enum State : uint8_t {
+        EMPTY,     // too short to hold a field
+        COMPLETE,  // every field fits in the payload
+        TRUNCATED, // the walk stopped at a field longer than the rest of the payload
+    };
+
+    uint8_t m_fields[N]; // offsets of the fields, sorted by type
+    uint8_t m_count = 0;
+    uint8_t m_end = 0;   // where the walk stopped
+    State   m_state = EMPTY;
+};
+
+#endif /* COMPONENTS_NIMBLE_ADV_FIELD_INDEX_H_ */
@@ -21,24 +21,109 @@
 #include "NimBLELog.h"
 
 #include <climits>
+#include <string.h>
 
 static const char* LOG_TAG = "NimBLEAdvertisedDevice";
 
+#if CONFIG_NIMBLE_CPP_ADV_DEVICE_POOL_SIZE > 0
+/* Devices come and go on every advertising report when results aren't kept, so they are carved out of a fixed pool
+ * rather than the heap, which would fragment over a long scan. */
+union NimBLEAdvertisedDevicePoolSlot {
+    NimBLEAdvertisedDevicePoolSlot* next;
+    alignas(NimBLEAdvertisedDevice) uint8_t storage[sizeof(NimBLEAdvertisedDevice)];
+};
+
+static NimBLEAdvertisedDevicePoolSlot  s_devicePool[CONFIG_NIMBLE_CPP_ADV_DEVICE_POOL_SIZE];
+static NimBLEAdvertisedDevicePoolSlot* s_devicePoolFree = nullptr;
+static bool                            s_devicePoolInit = false;
+#endif
+static NimBLEAdvertisedDeviceAllocStats s_allocStats = {};
+
 
 /**
  * @brief Constructor
  */
-NimBLEAdvertisedDevice::NimBLEAdvertisedDevice() :
-    m_payload(62,0)
-{
+NimBLEAdvertisedDevice::NimBLEAdvertisedDevice() {
     m_advType          = 0;
     m_rssi             = -9999;
     m_callbackSent     = false;
     m_timestamp        = 0;
     m_advLength        = 0;
+    m_payloadLength    = 0;
 } // NimBLEAdvertisedDevice
 
 
+/**
+ * @brief Allocate a device from the pool, or from the heap once the pool is full.
+ * @param [in] size The size of the object, classes derived from this one always go to the heap.
+ */
+void* NimBLEAdvertisedDevice::operator new(size_t size) {
+#if CONFIG_NIMBLE_CPP_ADV_DEVICE_POOL_SIZE > 0
+    void* slot = nullptr;
+
+    if(size == sizeof(NimBLEAdvertisedDevice)) {
+        uint32_t ctx = ble_npl_hw_enter_critical();
+        if(!s_devicePoolInit) {
+            for(int i = 0; i < CONFIG_NIMBLE_CPP_ADV_DEVICE_POOL_SIZE; i++) {
+                s_devicePool[i].next = s_devicePoolFree;
+                s_devicePoolFree = &s_devicePool[i];
+            }
+            s_devicePoolInit = true;
+        }
+
+        if(s_devicePoolFree != nullptr) {
+            slot = s_devicePoolFree;
+            s_devicePoolFree = s_devicePoolFree->next;
+            s_allocStats.poolAllocs++;
+            if(++s_allocStats.inUse > s_allocStats.highWater) {
+                s_allocStats.highWater = s_allocStats.inUse;
+            }
+        }
+        ble_npl_hw_exit_critical(ctx);
+    }
+
+    if(slot != nullptr) {
+        return slot;
+    }
+#endif
+
+    s_allocStats.heapAllocs++;
+    return ::operator new(size);
+} // operator new
+
+
+/**
+ * @brief Return a device to the pool, or to the heap if it didn't come from the pool.
+ */
+void NimBLEAdvertisedDevice::operator delete(void* ptr) {
+#if CONFIG_NIMBLE_CPP_ADV_DEVICE_POOL_SIZE > 0
+    NimBLEAdvertisedDevicePoolSlot* slot = (NimBLEAdvertisedDevicePoolSlot*)ptr;
+
+    if(slot >= &s_devicePool[0] && slot < &s_devicePool[CONFIG_NIMBLE_CPP_ADV_DEVICE_POOL_SIZE]) {
+        uint32_t ctx = ble_npl_hw_enter_critical();
+        slot->next = s_devicePoolFree;
+        s_devicePoolFree = slot;
+        s_allocStats.inUse--;
+        ble_npl_hw_exit_critical(ctx);
+        return;
+    }
+#endif
+
+    ::operator delete(ptr);
+} // operator delete
+
+
+/**
+ * @brief Get the allocation counters for advertised devices.
+ * @details The pool is sized with CONFIG_NIMBLE_CPP_ADV_DEVICE_POOL_SIZE, a rising heapAllocs count means it is
+ * too small for the number of devices in range.
+ * @return A copy of the counters.
+ */
+/*STATIC*/NimBLEAdvertisedDeviceAllocStats NimBLEAdvertisedDevice::getAllocStats() {
+    return s_allocStats;
+} // getAllocStats
+
+
 /**
  * @brief Get the address of the advertising device.
  * @return The address of the advertised device.
@@ -289,7 +374,7 @@ std::string NimBLEAdvertisedDevice::getServiceData(const NimBLEUUID &uuid) {
     uint8_t bytes;
     uint8_t index = 0;
     size_t  data_loc = findServiceData(index, &bytes);
-    size_t  plSize = m_payload.size() - 2;
+    size_t  plSize = m_payloadLength - 2;
     uint8_t uuidBytes = uuid.bitSize() / 8;
 
     while(data_loc < plSize) {
@@ -626,67 +711,17 @@ uint16_t NimBLEAdvertisedDevice::getPeriodicInterval() {
 #endif
 
 
+/**
+ * @brief Count the items of an AD type in the payload, and find the field an item is in.
+ * @details The payload is indexed once when it is stored, so this doesn't walk it.
+ * @param [in] type The AD type to look for.
+ * @param [in] index With data_loc, stop at the field where the count reaches this, 0 stops at the first.
+ * @param [out] data_loc The offset of the field in the payload.
+ * @return The number of items counted.
+ */
 uint8_t NimBLEAdvertisedDevice::findAdvField(uint8_t type, uint8_t index, size_t * data_loc) {
-    ble_hs_adv_field *field = nullptr;
-    size_t  length = m_payload.size();
-    size_t  data   = 0;
-    uint8_t count  = 0;
-
-    if (length < 3) {
-        return count;
-    }
-
-    while (length > 2) {
-        field = (ble_hs_adv_field*)&m_payload[data];
-
-        if (field->length >= length) {
-            return count;
-        }
-
-        if (field->type == type) {
-            switch (type) {
-                case BLE_HS_ADV_TYPE_INCOMP_UUIDS16:
-                case BLE_HS_ADV_TYPE_COMP_UUIDS16:
-                    count += field->length / 2;
-                    break;
-
-                case BLE_HS_ADV_TYPE_INCOMP_UUIDS32:
-                case BLE_HS_ADV_TYPE_COMP_UUIDS32:
-                    count += field->length / 4;
-                    break;
-
-                case BLE_HS_ADV_TYPE_INCOMP_UUIDS128:
-                case BLE_HS_ADV_TYPE_COMP_UUIDS128:
-                    count += field->length / 16;
-                    break;
-
-                case BLE_HS_ADV_TYPE_PUBLIC_TGT_ADDR:
-                case BLE_HS_ADV_TYPE_RANDOM_TGT_ADDR:
-                    count += field->length / 6;
-                    break;
-
-                default:
-                    count++;
-                    break;
-            }
-
-            if (data_loc != nullptr) {
-                if (index == 0 || count >= index) {
-                    break;
-                }
-            }
-        }
-
-        length -= 1 + field->length;
-        data += 1 + field->length;
-    }
-
-    if (data_loc != nullptr && field != nullptr) {
-        *data_loc = data;
-    }
-
-    return count;
-}
+    return m_fieldIndex.find(m_payload, type, index, data_loc);
+} // findAdvField
 
 
 /**
@@ -777,7 +812,7 @@ uint8_t* NimBLEAdvertisedDevice::getPayload() {
 
 
 /**
- * @brief Stores the payload of the advertised device in a vector.
+ * @brief Stores the payload of the advertised device.
  * @param [in] payload The advertisement payload.
  * @param [in] length The length of the payload in bytes.
  * @param [in] append Indicates if the the data should be appended (scan response).
@@ -785,10 +820,17 @@ uint8_t* NimBLEAdvertisedDevice::getPayload() {
 void NimBLEAdvertisedDevice::setPayload(const uint8_t *payload, uint8_t length, bool append) {
     if(!append) {
         m_advLength = length;
-        m_payload.assign(payload, payload + length);
-    } else {
-        m_payload.insert(m_payload.end(), payload, payload + length);
+        m_payloadLength = 0;
     }
+
+    if(m_payloadLength + length > NIMBLE_CPP_ADV_PAYLOAD_MAX_LEN) {
+        NIMBLE_LOGW(LOG_TAG, "Payload too long, truncated to %d bytes", NIMBLE_CPP_ADV_PAYLOAD_MAX_LEN);
+        length = NIMBLE_CPP_ADV_PAYLOAD_MAX_LEN - m_payloadLength;
+    }
+
+    memcpy(&m_payload[m_payloadLength], payload, length);
+    m_payloadLength += length;
+    m_fieldIndex.build(m_payload, m_payloadLength);
 }
 
 
@@ -828,7 +870,7 @@ time_t NimBLEAdvertisedDevice::getTimestamp() {
  * @return The size of the payload in bytes.
  */
 size_t NimBLEAdvertisedDevice::getPayloadLength() {
-    return m_payload.size();
+    return m_payloadLength;
 } // getPayloadLength
 
 
@@ -18,6 +18,7 @@
 #if defined(CONFIG_BT_ENABLED) && defined(CONFIG_BT_NIMBLE_ROLE_OBSERVER)
 
 #include "NimBLEAddress.h"
+#include "NimBLEAdvFieldIndex.h"
 #include "NimBLEScan.h"
 #include "NimBLEUUID.h"
 
@@ -31,8 +32,32 @@
 #include <vector>
 #include <time.h>
 
+#if !defined(CONFIG_NIMBLE_CPP_ADV_DEVICE_POOL_SIZE)
+#    define CONFIG_NIMBLE_CPP_ADV_DEVICE_POOL_SIZE 16
+#elif CONFIG_NIMBLE_CPP_ADV_DEVICE_POOL_SIZE < 0
+#    error CONFIG_NIMBLE_CPP_ADV_DEVICE_POOL_SIZE cannot be negative
+#endif
+
+/** @brief The most payload bytes a device stores: an advertisement and its scan response, or one extended report. */
+#if CONFIG_BT_NIMBLE_EXT_ADV
+#    define NIMBLE_CPP_ADV_PAYLOAD_MAX_LEN 255
+#else
+#    define NIMBLE_CPP_ADV_PAYLOAD_MAX_LEN (BLE_HS_ADV_MAX_SZ * 2)
+#endif
+
 
 class NimBLEScan;
+
+/**
+ * @brief Allocation counters for advertised devices, totals since boot.
+ */
+struct NimBLEAdvertisedDeviceAllocStats {
+    uint32_t        poolAllocs;  // devices placed in the pool
+    uint32_t        heapAllocs;  // devices allocated on the heap because the pool was full
+    uint16_t        inUse;       // pool slots in use now
+    uint16_t        highWater;   // most pool slots that have been in use at once
+};
+
 /**
  * @brief A representation of a %BLE advertised device found by a scan.
  *
@@ -43,6 +68,10 @@ class NimBLEAdvertisedDevice {
 public:
     NimBLEAdvertisedDevice();
 
+    static void*    operator new(size_t size);
+    static void     operator delete(void* ptr);
+    static NimBLEAdvertisedDeviceAllocStats getAllocStats();
+
     NimBLEAddress   getAddress();
     uint8_t         getAdvType();
     uint16_t        getAppearance();
@@ -172,7 +201,9 @@ private:
     uint16_t        m_periodicItvl;
 #endif
 
-    std::vector<uint8_t>    m_payload;
+    uint16_t        m_payloadLength;
+    uint8_t         m_payload[NIMBLE_CPP_ADV_PAYLOAD_MAX_LEN];
+    NimBLEAdvFieldIndex<NIMBLE_CPP_ADV_PAYLOAD_MAX_LEN> m_fieldIndex;
 };
 
 /**
@@ -41,6 +41,14 @@
 #    error CONFIG_NIMBLE_CPP_ATT_VALUE_INIT_LENGTH cannot be less than 1; Range = 1 : 512
 #endif
 
+#if !defined(CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH)
+#    define CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH 20
+#elif CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH > BLE_ATT_ATTR_MAX_LEN
+#    error CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH cannot be larger than 512 (BLE_ATT_ATTR_MAX_LEN)
+#elif CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH < 0
+#    error CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH cannot be less than 0; Range = 0 : 512
+#endif
+
 
 /* Used to determine if the type passed to a template has a c_str() and length() method. */
 template <typename T, typename = void, typename = void>
@@ -55,18 +63,22 @@ struct Has_c_str_len<T, decltype(void(std::declval<T &>().c_str())),
  * @brief A specialized container class to hold BLE attribute values.
  * @details This class is designed to be more memory efficient than using\n
  * standard container types for value storage, while being convertable to\n
- * many different container classes.
+ * many different container classes. Values of up to CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH\n
+ * bytes are stored in the object itself, longer ones on the heap.
  */
 class NimBLEAttValue
 {
-    uint8_t*     m_attr_value = nullptr;
+    uint8_t*     m_attr_value = m_inline;
     uint16_t     m_attr_max_len = 0;
     uint16_t     m_attr_len = 0;
-    uint16_t     m_capacity = 0;
+    uint16_t     m_capacity = CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH;
 #if CONFIG_NIMBLE_CPP_ATT_VALUE_TIMESTAMP_ENABLED
     time_t       m_timestamp = 0;
 #endif
+    uint8_t      m_inline[CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH + 1] = {};
     void         deepCopy(const NimBLEAttValue & source);
+    uint8_t*     reserve(uint16_t len);
+    bool         isInline()    const   { return m_attr_value == m_inline; }
 
 public:
     /**
@@ -132,8 +144,8 @@ public:
     /** @brief Copy constructor */
     NimBLEAttValue(const NimBLEAttValue & source) { deepCopy(source); }
 
-    /** @brief Move constructor */
-    NimBLEAttValue(NimBLEAttValue && source) { *this = std::move(source); }
+    /** @brief Move constructor, leaves the source empty */
+    NimBLEAttValue(NimBLEAttValue && source) noexcept { *this = std::move(source); }
 
     /** @brief Destructor */
     ~NimBLEAttValue();
@@ -288,7 +300,7 @@ public:
         setValue((uint8_t*)source.data(), (uint16_t)source.size()); return *this; }
 
     /** @brief Move assignment operator */
-    NimBLEAttValue& operator  =(NimBLEAttValue && source);
+    NimBLEAttValue& operator  =(NimBLEAttValue && source) noexcept;
 
     /** @brief Copy assignment operator */
     NimBLEAttValue& operator  =(const NimBLEAttValue & source);
@@ -310,11 +322,13 @@ public:
 
 
 inline NimBLEAttValue::NimBLEAttValue(uint16_t init_len, uint16_t max_len) {
-    m_attr_value   = (uint8_t*)calloc(init_len + 1, 1);
-    assert(m_attr_value && "No Mem");
+    if (init_len > m_capacity) {
+        m_attr_value = (uint8_t*)calloc(init_len + 1, 1);
+        assert(m_attr_value && "No Mem");
+        m_capacity   = init_len;
+    }
     m_attr_max_len = std::min(BLE_ATT_ATTR_MAX_LEN, (int)max_len);
     m_attr_len     = 0;
-    m_capacity     = init_len;
     setTimeStamp(0);
 }
 
@@ -326,21 +340,34 @@ inline NimBLEAttValue::NimBLEAttValue(const uint8_t *value, uint16_t len, uint16
 }
 
 inline NimBLEAttValue::~NimBLEAttValue() {
-    if(m_attr_value != nullptr) {
+    if(!isInline()) {
         free(m_attr_value);
     }
 }
 
-inline NimBLEAttValue& NimBLEAttValue::operator =(NimBLEAttValue && source) {
+inline NimBLEAttValue& NimBLEAttValue::operator =(NimBLEAttValue && source) noexcept {
     if (this != &source){
-        free(m_attr_value);
-
-        m_attr_value   = source.m_attr_value;
+        if (!isInline()) {
+            free(m_attr_value);
+        }
+
+        // A heap buffer changes hands, an inline value is at most a few bytes to copy.
+        if (source.isInline()) {
+            m_attr_value = m_inline;
+            m_capacity   = CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH;
+            memcpy(m_inline, source.m_inline, source.m_attr_len + 1);
+        } else {
+            m_attr_value = source.m_attr_value;
+            m_capacity   = source.m_capacity;
+        }
         m_attr_max_len = source.m_attr_max_len;
         m_attr_len     = source.m_attr_len;
-        m_capacity     = source.m_capacity;
         setTimeStamp(source.getTimeStamp());
-        source.m_attr_value = nullptr;
+
+        source.m_attr_value = source.m_inline;
+        source.m_capacity   = CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH;
+        source.m_attr_len   = 0;
+        source.m_inline[0]  = '\0';
     }
     return *this;
 }
@@ -353,19 +380,40 @@ inline NimBLEAttValue& NimBLEAttValue::operator =(const NimBLEAttValue & source)
 }
 
 inline void NimBLEAttValue::deepCopy(const NimBLEAttValue & source) {
-    uint8_t* res = (uint8_t*)realloc( m_attr_value, source.m_capacity + 1);
+    uint8_t* res = reserve(source.m_attr_len);
     assert(res && "deepCopy: realloc failed");
 
     ble_npl_hw_enter_critical();
     m_attr_value   = res;
     m_attr_max_len = source.m_attr_max_len;
     m_attr_len     = source.m_attr_len;
-    m_capacity     = source.m_capacity;
     setTimeStamp(source.getTimeStamp());
     memcpy(m_attr_value, source.m_attr_value, m_attr_len + 1);
     ble_npl_hw_exit_critical(0);
 }
 
+/**
+ * @brief Get a buffer that holds a value of len bytes, moving the current value to the heap if it doesn't fit.
+ * @details The buffer returned still has to be stored in m_attr_value, callers do so with the new value.
+ */
+inline uint8_t* NimBLEAttValue::reserve(uint16_t len) {
+    if (len <= m_capacity) {
+        return m_attr_value;
+    }
+
+    uint8_t* res;
+    if (isInline()) {
+        res = (uint8_t*)malloc(len + 1);
+        if (res != nullptr) {
+            memcpy(res, m_inline, m_attr_len + 1);
+        }
+    } else {
+        res = (uint8_t*)realloc(m_attr_value, len + 1);
+    }
+    m_capacity = len;
+    return res;
+}
+
 inline const uint8_t*  NimBLEAttValue::getValue(time_t *timestamp) {
     if(timestamp != nullptr) {
 #if CONFIG_NIMBLE_CPP_ATT_VALUE_TIMESTAMP_ENABLED
@@ -384,11 +432,7 @@ inline bool NimBLEAttValue::setValue(const uint8_t *value, uint16_t len) {
         return false;
     }
 
-    uint8_t *res = m_attr_value;
-    if (len > m_capacity) {
-        res = (uint8_t*)realloc(m_attr_value, (len + 1));
-        m_capacity = len;
-    }
+    uint8_t *res = reserve(len);
     assert(res && "setValue: realloc failed");
 
 #if CONFIG_NIMBLE_CPP_ATT_VALUE_TIMESTAMP_ENABLED
@@ -418,12 +462,8 @@ inline NimBLEAttValue& NimBLEAttValue::append(const uint8_t *value, uint16_t len
         return *this;
     }
 
-    uint8_t* res = m_attr_value;
     uint16_t new_len = m_attr_len + len;
-    if (new_len > m_capacity) {
-        res = (uint8_t*)realloc(m_attr_value, (new_len + 1));
-        m_capacity = new_len;
-    }
+    uint8_t* res = reserve(new_len);
     assert(res && "append: realloc failed");
 
 #if CONFIG_NIMBLE_CPP_ATT_VALUE_TIMESTAMP_ENABLED
@@ -18,6 +18,12 @@
 #include "NimBLEDevice.h"
 #include "NimBLELog.h"
 
+#if defined(CONFIG_NIMBLE_CPP_IDF)
+#include "nimble/nimble_port.h"
+#else
+#include "nimble/porting/nimble/include/nimble/nimble_port.h"
+#endif
+
 #define NULL_HANDLE (0xffff)
 #define NIMBLE_SUB_NOTIFY   0x0001
 #define NIMBLE_SUB_INDICATE 0x0002
@@ -25,6 +31,17 @@
 static NimBLECharacteristicCallbacks defaultCallback;
 static const char* LOG_TAG = "NimBLECharacteristic";
 
+/**
+ * @brief The state of notification coalescing, allocated only for the characteristics that use it.
+ */
+struct NimBLECharacteristic::Coalescing {
+    NimBLENotifyCoalescer frame;
+    ble_npl_callout       timer;
+    ble_npl_mutex         lock;
+    ble_npl_time_t        delay;
+    uint8_t               out[BLE_ATT_ATTR_MAX_LEN];  // the frame being sent
+};
+
 
 /**
  * @brief Construct a characteristic
@@ -54,6 +71,7 @@ NimBLECharacteristic::NimBLECharacteristic(const NimBLEUUID &uuid, uint16_t prop
     m_pCallbacks  = &defaultCallback;
     m_pService    = pService;
     m_removed     = 0;
+    m_pCoalescing = nullptr;
 } // NimBLECharacteristic
 
 /**
@@ -63,6 +81,8 @@ NimBLECharacteristic::~NimBLECharacteristic() {
     for(auto &it : m_dscVec) {
         delete it;
     }
+
+    setNotifyCoalescing(0);
 } // ~NimBLECharacteristic
 
 
@@ -330,7 +350,7 @@ int NimBLECharacteristic::handleGapEvent(uint16_t conn_handle, uint16_t attr_han
  * @returns Number of clients subscribed to notifications / indications.
  */
 size_t NimBLECharacteristic::getSubscribedCount() {
-    return m_subscribedVec.size();
+    return m_subscribers.size();
 }
 
 
@@ -360,22 +380,9 @@ void NimBLECharacteristic::setSubscribe(struct ble_gap_event *event) {
     }
 
 
-    auto it = m_subscribedVec.begin();
-    for(;it != m_subscribedVec.end(); ++it) {
-        if((*it).first == event->subscribe.conn_handle) {
-            break;
-        }
-    }
-
-    if(subVal > 0) {
-        if(it == m_subscribedVec.end()) {
-            m_subscribedVec.push_back({event->subscribe.conn_handle, subVal});
-        } else {
-            (*it).second = subVal;
-        }
-    } else if(it != m_subscribedVec.end()) {
-        m_subscribedVec.erase(it);
-    }
+    // The MTU and encryption are kept up to date by the server from here on.
+    m_subscribers.set(event->subscribe.conn_handle, subVal,
+                      ble_att_mtu(event->subscribe.conn_handle), desc.sec_state.encrypted);
 
     m_pCallbacks->onSubscribe(this, &desc, subVal);
 }
@@ -434,6 +441,170 @@ void NimBLECharacteristic::notify(const std::vector<uint8_t>& value, bool is_not
  * @param[in] is_notification if true sends a notification, false sends an indication.
  */
 void NimBLECharacteristic::notify(const uint8_t* value, size_t length, bool is_notification) {
+    notify(value, length, is_notification, nullptr, 0);
+} // Notify
+
+
+/**
+ * @brief Coalesce values sent with notifyCoalesced() into fewer notifications, or stop.
+ * @details Values are packed as records into a frame as large as the smallest MTU of the subscribers allows, each
+ * record a length byte followed by the value (see NimBLENotifyCoalescer::next() to unpack them). The frame is sent
+ * when the next value doesn't fit, when maxDelayMs has passed since its first value, or on flushNotify(), so no
+ * value is held back longer than maxDelayMs.
+ * @param [in] maxDelayMs The longest a value is held back, 0 to send what is held and stop coalescing.
+ */
+void NimBLECharacteristic::setNotifyCoalescing(uint32_t maxDelayMs) {
+    if(maxDelayMs == 0) {
+        if(m_pCoalescing != nullptr) {
+            flushNotify();
+            ble_npl_callout_stop(&m_pCoalescing->timer);
+            ble_npl_callout_deinit(&m_pCoalescing->timer);
+            ble_npl_mutex_deinit(&m_pCoalescing->lock);
+            delete m_pCoalescing;
+            m_pCoalescing = nullptr;
+        }
+        return;
+    }
+
+    if(m_pCoalescing == nullptr) {
+        m_pCoalescing = new Coalescing();
+        memset(&m_pCoalescing->timer, 0, sizeof(m_pCoalescing->timer));
+        ble_npl_callout_init(&m_pCoalescing->timer, nimble_port_get_dflt_eventq(),
+                             NimBLECharacteristic::coalesceTimerCb, this);
+        ble_npl_mutex_init(&m_pCoalescing->lock);
+    }
+
+    ble_npl_time_ms_to_ticks(maxDelayMs, &m_pCoalescing->delay);
+} // setNotifyCoalescing
+
+
+/**
+ * @brief Send a value as a notification, coalesced with others if setNotifyCoalescing() was set.
+ * @param [in] value A pointer to the data to send.
+ * @param [in] length The length of the data to send, at most 255 bytes and 4 less than the smallest MTU.
+ * @return False if the value is too long to coalesce, in which case it isn't sent.
+ */
+bool NimBLECharacteristic::notifyCoalesced(const uint8_t* value, size_t length) {
+    if(m_pCoalescing == nullptr) {
+        notify(value, length);
+        return true;
+    }
+
+    size_t capacity = coalesceCapacity();
+    if(capacity == 0) {
+        NIMBLE_LOGD(LOG_TAG, "notifyCoalesced: No clients subscribed.");
+        return true;
+    }
+
+    Coalescing* c = m_pCoalescing;
+    ble_npl_mutex_pend(&c->lock, BLE_NPL_TIME_FOREVER);
+
+    if(capacity < c->frame.length()) {
+        sendCoalesced(capacity);
+    }
+    c->frame.setCapacity(capacity);
+
+    if(!c->frame.accepts(length)) {
+        ble_npl_mutex_release(&c->lock);
+        NIMBLE_LOGE(LOG_TAG, "notifyCoalesced: %d bytes is too long to coalesce", length);
+        return false;
+    }
+
+    if(!c->frame.fits(length)) {
+        sendCoalesced(capacity);
+    }
+    c->frame.add(value, length);
+
+    if(c->frame.full()) {
+        sendCoalesced(capacity);
+    } else if(c->frame.records() == 1) {
+        ble_npl_callout_reset(&c->timer, c->delay);
+    }
+
+    ble_npl_mutex_release(&c->lock);
+    return true;
+} // notifyCoalesced
+
+
+/**
+ * @brief Send the values notifyCoalesced() is holding back now.
+ */
+void NimBLECharacteristic::flushNotify() {
+    if(m_pCoalescing == nullptr) {
+        return;
+    }
+
+    ble_npl_mutex_pend(&m_pCoalescing->lock, BLE_NPL_TIME_FOREVER);
+    if(!m_pCoalescing->frame.empty()) {
+        sendCoalesced(coalesceCapacity());
+    }
+    ble_npl_mutex_release(&m_pCoalescing->lock);
+} // flushNotify
+
+
+/**
+ * @brief Get the largest frame every subscriber can be notified whole, from the smallest MTU among them.
+ * @return The capacity, 0 if there are no subscribers.
+ */
+size_t NimBLECharacteristic::coalesceCapacity() const {
+    uint16_t mtu = 0;
+    for(const NimBLESubscriber &sub : m_subscribers) {
+        if(sub.mtu > 3 && (mtu == 0 || sub.mtu < mtu)) {
+            mtu = sub.mtu;
+        }
+    }
+    return mtu == 0 ? 0 : std::min(mtu - 3, BLE_ATT_ATTR_MAX_LEN);
+} // coalesceCapacity
+
+
+/**
+ * @brief Send the coalesced frame, must be called with the coalescing lock held.
+ * @details The frame was packed for the MTUs of the subscribers when its records were added. One with a smaller MTU
+ * may have subscribed since, so the frame is sent in pieces of whole records that each fit the capacity, rather
+ * than cut short by notify().
+ * @param [in] capacity The largest frame every subscriber can be notified whole, 0 to drop the frame.
+ */
+void NimBLECharacteristic::sendCoalesced(size_t capacity) {
+    ble_npl_callout_stop(&m_pCoalescing->timer);
+    const uint8_t* out = m_pCoalescing->out;
+    size_t length = m_pCoalescing->frame.take(m_pCoalescing->out);
+
+    for(size_t offset = 0; capacity > 0 && offset < length;) {
+        size_t piece = NimBLENotifyCoalescer::fit(out + offset, length - offset, capacity);
+        if(piece == 0) {
+            NIMBLE_LOGE(LOG_TAG, "sendCoalesced: %d byte value no longer fits the MTU, dropped", out[offset]);
+            offset += 1 + out[offset];
+            continue;
+        }
+        notify(out + offset, piece);
+        offset += piece;
+    }
+} // sendCoalesced
+
+
+/**
+ * @brief Sends the coalesced frame once its first value has waited the longest it may.
+ */
+void NimBLECharacteristic::coalesceTimerCb(ble_npl_event *event) {
+    NimBLECharacteristic* pChr = (NimBLECharacteristic*)ble_npl_event_get_arg(event);
+    pChr->flushNotify();
+} // coalesceTimerCb
+
+
+/**
+ * @brief Send a notification or indication to every subscriber, and get the outcome for each.
+ * @details Uses the MTU and encryption of each connection as of its last change event, so the stack is only called
+ * to send.
+ * @param[in] value A pointer to the data to send.
+ * @param[in] length The length of the data to send.
+ * @param[in] is_notification if true sends a notification, false sends an indication.
+ * A subscriber to the other kind gets that kind instead.
+ * @param[out] results Where to store the outcome for each subscriber, can be nullptr.
+ * @param[in] maxResults The number of results there is room for, the outcome for subscribers beyond it is dropped.
+ * @return The number of subscribers the value was sent to.
+ */
+size_t NimBLECharacteristic::notify(const uint8_t* value, size_t length, bool is_notification,
+                                    NimBLENotifyResult* results, size_t maxResults) {
     NIMBLE_LOGD(LOG_TAG, ">> notify: length: %d", length);
 
     if(!(m_properties & NIMBLE_PROPERTY::NOTIFY) &&
@@ -444,9 +615,9 @@ void NimBLECharacteristic::notify(const uint8_t* value, size_t length, bool is_n
                     std::string(getUUID()).c_str());
     }
 
-    if (m_subscribedVec.size() == 0) {
+    if (m_subscribers.size() == 0) {
         NIMBLE_LOGD(LOG_TAG, "<< notify: No clients subscribed.");
-        return;
+        return 0;
     }
 
     m_pCallbacks->onNotify(this);
@@ -454,64 +625,70 @@ void NimBLECharacteristic::notify(const uint8_t* value, size_t length, bool is_n
     bool reqSec = (m_properties & BLE_GATT_CHR_F_READ_AUTHEN) ||
                   (m_properties & BLE_GATT_CHR_F_READ_AUTHOR) ||
                   (m_properties & BLE_GATT_CHR_F_READ_ENC);
-    int rc = 0;
+    NimBLEServer* pServer = NimBLEDevice::getServer();
+    size_t sent = 0;
+    size_t nResults = 0;
 
-    for (auto &it : m_subscribedVec) {
-        uint16_t _mtu = getService()->getServer()->getPeerMTU(it.first) - 3;
-
-        // check if connected and subscribed
-        if(_mtu == 0 || it.second == 0) {
-            continue;
-        }
+    for (const NimBLESubscriber &sub : m_subscribers) {
+        int rc = 0;
 
         // check if security requirements are satisfied
-        if(reqSec) {
-            struct ble_gap_conn_desc desc;
-            rc = ble_gap_conn_find(it.first, &desc);
-            if(rc != 0 || !desc.sec_state.encrypted) {
-                continue;
+        if(reqSec && !sub.encrypted) {
+            rc = BLE_HS_EAUTHEN;
+        } else if(sub.mtu <= 3) {
+            rc = BLE_HS_ENOTCONN;
+        } else {
+            uint16_t _mtu = sub.mtu - 3;
+            if (length > _mtu) {
+                NIMBLE_LOGW(LOG_TAG, "- Truncating to %d bytes (maximum notify size)", _mtu);
             }
-        }
-
-        if (length > _mtu) {
-            NIMBLE_LOGW(LOG_TAG, "- Truncating to %d bytes (maximum notify size)", _mtu);
-        }
-
-        if(is_notification && (!(it.second & NIMBLE_SUB_NOTIFY))) {
-            NIMBLE_LOGW(LOG_TAG,
-            "Sending notification to client subscribed to indications, sending indication instead");
-            is_notification = false;
-        }
 
-        if(!is_notification && (!(it.second & NIMBLE_SUB_INDICATE))) {
-            NIMBLE_LOGW(LOG_TAG,
-            "Sending indication to client subscribed to notification, sending notification instead");
-            is_notification = true;
-        }
-
-        // don't create the m_buf until we are sure to send the data or else
-        // we could be allocating a buffer that doesn't get released.
-        // We also must create it in each loop iteration because it is consumed with each host call.
-        os_mbuf *om = ble_hs_mbuf_from_flat(value, length);
+            bool notification = is_notification;
+            if(notification && (!(sub.subValue & NIMBLE_SUB_NOTIFY))) {
+                NIMBLE_LOGW(LOG_TAG,
+                "Sending notification to client subscribed to indications, sending indication instead");
+                notification = false;
+            }
 
-        if(!is_notification && (m_properties & NIMBLE_PROPERTY::INDICATE)) {
-            if(!NimBLEDevice::getServer()->setIndicateWait(it.first)) {
-               NIMBLE_LOGE(LOG_TAG, "prior Indication in progress");
-               os_mbuf_free_chain(om);
-               return;
+            if(!notification && (!(sub.subValue & NIMBLE_SUB_INDICATE))) {
+                NIMBLE_LOGW(LOG_TAG,
+                "Sending indication to client subscribed to notification, sending notification instead");
+                notification = true;
             }
 
-            rc = ble_gattc_indicate_custom(it.first, m_handle, om);
-            if(rc != 0){
-                NimBLEDevice::getServer()->clearIndicateWait(it.first);
+            if(!notification && (m_properties & NIMBLE_PROPERTY::INDICATE) &&
+               !pServer->setIndicateWait(sub.connHandle))
+            {
+                NIMBLE_LOGE(LOG_TAG, "prior Indication in progress");
+                rc = BLE_HS_EBUSY;
+            } else {
+                // Created only once we are sure to send it, as every host call consumes its buffer.
+                os_mbuf *om = ble_hs_mbuf_from_flat(value, length);
+
+                if(!notification && (m_properties & NIMBLE_PROPERTY::INDICATE)) {
+                    rc = ble_gattc_indicate_custom(sub.connHandle, m_handle, om);
+                    if(rc != 0){
+                        pServer->clearIndicateWait(sub.connHandle);
+                    }
+                } else {
+                    rc = ble_gattc_notify_custom(sub.connHandle, m_handle, om);
+                }
             }
-        } else {
-            ble_gattc_notify_custom(it.first, m_handle, om);
+        }
+
+        if(rc == 0) {
+            sent++;
+        }
+        if(results != nullptr && nResults < maxResults) {
+            results[nResults].connHandle = sub.connHandle;
+            results[nResults].rc         = rc;
+            nResults++;
         }
     }
 
     NIMBLE_LOGD(LOG_TAG, "<< notify");
-} // Notify
+    return sent;
+} // notify
 
 
 /**
@@ -45,6 +45,8 @@ typedef enum {
 #include "NimBLEService.h"
 #include "NimBLEDescriptor.h"
 #include "NimBLEAttValue.h"
+#include "NimBLESubscriberList.h"
+#include "NimBLENotifyCoalescer.h"
 
 #include <string>
 #include <vector>
@@ -53,6 +55,13 @@ class NimBLEService;
 class NimBLEDescriptor;
 class NimBLECharacteristicCallbacks;
 
+/**
+ * @brief The outcome of a notification or indication to one subscriber.
+ */
+struct NimBLENotifyResult {
+    uint16_t connHandle;
+    int      rc;         // 0 if sent, BLE_HS_EAUTHEN if not encrypted, BLE_HS_EBUSY if an indication is pending
+};
 
 /**
  * @brief The model of a %BLE Characteristic.
@@ -86,6 +95,11 @@ public:
     void              notify(bool is_notification = true);
     void              notify(const uint8_t* value, size_t length, bool is_notification = true);
     void              notify(const std::vector<uint8_t>& value, bool is_notification = true);
+    size_t            notify(const uint8_t* value, size_t length, bool is_notification,
+                             NimBLENotifyResult* results, size_t maxResults);
+    void              setNotifyCoalescing(uint32_t maxDelayMs);
+    bool              notifyCoalesced(const uint8_t* value, size_t length);
+    void              flushNotify();
     size_t            getSubscribedCount();
     void              addDescriptor(NimBLEDescriptor *pDescriptor);
     NimBLEDescriptor* getDescriptorByUUID(const char* uuid);
@@ -177,6 +191,11 @@ private:
     void            setSubscribe(struct ble_gap_event *event);
     static int      handleGapEvent(uint16_t conn_handle, uint16_t attr_handle,
                                    struct ble_gatt_access_ctxt *ctxt, void *arg);
+    static void     coalesceTimerCb(ble_npl_event *event);
+    size_t          coalesceCapacity() const;
+    void            sendCoalesced(size_t capacity);
+
+    struct Coalescing;
 
     NimBLEUUID                     m_uuid;
     uint16_t                       m_handle;
@@ -187,7 +206,8 @@ private:
     std::vector<NimBLEDescriptor*> m_dscVec;
     uint8_t                        m_removed;
 
-    std::vector<std::pair<uint16_t, uint16_t>>  m_subscribedVec;
+    NimBLESubscriberList           m_subscribers;
+    Coalescing*                    m_pCoalescing;
 }; // NimBLECharacteristic
 
 
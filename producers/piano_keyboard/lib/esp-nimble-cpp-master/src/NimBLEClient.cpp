@@ -21,6 +21,7 @@
 #include <string>
 #include <unordered_set>
 #include <climits>
+#include <algorithm>
 
 #if defined(CONFIG_NIMBLE_CPP_IDF)
 #include "nimble/nimble_port.h"
@@ -29,6 +30,10 @@
 #endif
 
 static const char* LOG_TAG = "NimBLEClient";
+
+// Most handle table entries to allocate, beyond that notifications are routed by searching the services.
+#define NIMBLE_CPP_HANDLE_TABLE_MAX_SPAN 512
+
 static NimBLEClientCallbacks defaultCallbacks;
 
 /*
@@ -60,9 +65,11 @@ static NimBLEClientCallbacks defaultCallbacks;
 NimBLEClient::NimBLEClient(const NimBLEAddress &peerAddress) : m_peerAddress(peerAddress) {
     m_pClientCallbacks = &defaultCallbacks;
     m_conn_id          = BLE_HS_CONN_HANDLE_NONE;
+    m_clientSlot       = -1;
     m_connectTimeout   = 30000;
     m_deleteCallbacks  = false;
     m_pTaskData        = nullptr;
+    m_pUpdateTaskData  = nullptr;
     m_connEstablished  = false;
     m_lastErr          = 0;
 #if CONFIG_BT_NIMBLE_EXT_ADV
@@ -80,6 +87,12 @@ NimBLEClient::NimBLEClient(const NimBLEAddress &peerAddress) : m_peerAddress(pee
     m_pConnParams.min_ce_len = BLE_GAP_INITIAL_CONN_MIN_CE_LEN; // Minimum length of connection event in 0.625ms units
     m_pConnParams.max_ce_len = BLE_GAP_INITIAL_CONN_MAX_CE_LEN; // Maximum length of connection event in 0.625ms units
 
+    m_handleTableState = HANDLE_TABLE_STALE;
+    m_gattOpHead       = nullptr;
+    m_gattOpTail       = nullptr;
+    m_dbHashRc         = BLE_HS_EUNKNOWN;
+    m_unresolvedIndication = 0;
+
     memset(&m_dcTimer, 0, sizeof(m_dcTimer));
     ble_npl_callout_init(&m_dcTimer, nimble_port_get_dflt_eventq(),
                          NimBLEClient::dcTimerCb, this);
@@ -123,11 +136,14 @@ void NimBLEClient::dcTimerCb(ble_npl_event *event) {
  */
 void NimBLEClient::deleteServices() {
     NIMBLE_LOGD(LOG_TAG, ">> deleteServices");
+    cancelGattOps();
+
     // Delete all the services.
     for(auto &it: m_servicesVector) {
         delete it;
     }
     m_servicesVector.clear();
+    invalidateHandleTable();
 
     NIMBLE_LOGD(LOG_TAG, "<< deleteServices");
 } // deleteServices
@@ -145,6 +161,7 @@ size_t NimBLEClient::deleteService(const NimBLEUUID &uuid) {
         if((*it)->getUUID() == uuid) {
             delete *it;
             m_servicesVector.erase(it);
+            invalidateHandleTable();
             break;
         }
     }
@@ -212,7 +229,7 @@ bool NimBLEClient::connect(const NimBLEAddress &address, bool deleteAttibutes) {
         NIMBLE_LOGE(LOG_TAG, "Invalid peer address;(NULL)");
         return false;
     } else {
-        m_peerAddress = address;
+        setPeerAddress(address);
     }
 
     TaskHandle_t cur_task = xTaskGetCurrentTaskHandle();
@@ -321,6 +338,8 @@ bool NimBLEClient::connect(const NimBLEAddress &address, bool deleteAttibutes) {
         deleteServices();
     }
 
+    m_dbHashRc = BLE_HS_EUNKNOWN;
+    m_unresolvedIndication = 0;
     m_connEstablished = true;
     m_pClientCallbacks->onConnect(this);
 
@@ -513,6 +532,159 @@ void NimBLEClient::setDataLen(uint16_t tx_octets) {
 } // setDataLen
 
 
+/**
+ * @brief The connection settings of each NimBLEClient::ConnProfile, in the order it lists them.
+ * A PHY mask or data length of 0 leaves the connection's as they are.
+ */
+static const struct {
+    uint16_t itvlMin;  // 1.25ms units
+    uint16_t itvlMax;  // 1.25ms units
+    uint16_t latency;  // connection events the peer may skip
+    uint16_t timeout;  // 10ms units
+    uint8_t  phyMask;
+    uint16_t dataLen;  // octets
+} connProfiles[] = {
+    // 7.5 to 15ms, the range BLE MIDI asks for, and a lost link noticed within 2 seconds
+    { 6,  12,  0, 200, BLE_GAP_LE_PHY_2M_MASK, 251 },
+    // 15 to 30ms, long enough for several long packets each connection event
+    { 12, 24,  0, 400, BLE_GAP_LE_PHY_2M_MASK, 251 },
+    // 100 to 200ms, of which the peer may skip 4 when it has nothing to send
+    { 80, 160, 4, 600, 0,                      0   },
+};
+
+/** @brief How many times a rejected profile is retried with a longer interval. */
+#define NIMBLE_CPP_CONN_PROFILE_RETRIES 2
+
+
+/**
+ * @brief Apply a preset of connection parameters, PHY and data length.
+ * @details The connection parameters are used for the next connection, and as the answer to the server's requests
+ * to update them. When connected, the 2M PHY and the data length are requested first, since the longest packet the
+ * data length allows depends on the PHY, then the connection parameters. If the server rejects those, the interval
+ * is doubled up to NIMBLE_CPP_CONN_PROFILE_RETRIES times. The MTU is exchanged when connecting, set it with
+ * NimBLEDevice::setMTU beforehand.\n
+ * Blocks until the connection parameters are updated, so do not call it from a callback. What the connection ended
+ * up with can be read from getConnInfo(); the link layer runs one procedure at a time, so the PHY is updated by then
+ * unless the connection parameters needed no update.
+ * @param [in] profile The preset to apply.
+ * @return True if not connected, or the connection got the profile's parameters or a relaxed version of them.
+ */
+bool NimBLEClient::applyProfile(ConnProfile profile) {
+    NIMBLE_LOGD(LOG_TAG, ">> applyProfile(%d)", profile);
+
+    if(profile >= sizeof(connProfiles) / sizeof(connProfiles[0])) {
+        NIMBLE_LOGE(LOG_TAG, "Invalid connection profile: %d", profile);
+        return false;
+    }
+
+    const auto &p = connProfiles[profile];
+    m_pConnParams.itvl_min = p.itvlMin;
+    m_pConnParams.itvl_max = p.itvlMax;
+    m_pConnParams.latency  = p.latency;
+    m_pConnParams.supervision_timeout = p.timeout;
+
+    if(!isConnected()) {
+        NIMBLE_LOGD(LOG_TAG, "<< applyProfile(): not connected, used for the next connection");
+        return true;
+    }
+
+    int rc;
+    if(p.phyMask != 0) {
+        rc = ble_gap_set_prefered_le_phy(m_conn_id, p.phyMask, p.phyMask, BLE_GAP_LE_PHY_CODED_ANY);
+        if(rc != 0) {
+            NIMBLE_LOGW(LOG_TAG, "Set PHY error: %d, %s", rc, NimBLEUtils::returnCodeToString(rc));
+        }
+    }
+
+    if(p.dataLen != 0) {
+        setDataLen(p.dataLen);
+    }
+
+    ble_gap_upd_params params;
+    params.itvl_min = p.itvlMin;
+    params.itvl_max = p.itvlMax;
+    params.latency  = p.latency;
+    params.supervision_timeout = p.timeout;
+    params.min_ce_len = BLE_GAP_INITIAL_CONN_MIN_CE_LEN;
+    params.max_ce_len = BLE_GAP_INITIAL_CONN_MAX_CE_LEN;
+
+    for(int attempt = 0; ; attempt++) {
+        ble_gap_conn_desc desc;
+        rc = ble_gap_conn_find(m_conn_id, &desc);
+        if(rc != 0) {
+            break;
+        }
+
+        if(desc.conn_itvl >= params.itvl_min && desc.conn_itvl <= params.itvl_max &&
+           desc.conn_latency == params.latency && desc.supervision_timeout == params.supervision_timeout)
+        {
+            NIMBLE_LOGI(LOG_TAG, "Connection interval %d, latency %d, timeout %d",
+                        desc.conn_itvl, desc.conn_latency, desc.supervision_timeout);
+            break;
+        }
+
+        if(attempt > NIMBLE_CPP_CONN_PROFILE_RETRIES) {
+            rc = BLE_HS_EREJECT;
+            break;
+        }
+
+        if(attempt > 0) {
+            // The server rejected them or chose others, ask for a longer interval.
+            params.itvl_min = params.itvl_max;
+            params.itvl_max = std::min<uint16_t>(params.itvl_max * 2, BLE_HCI_CONN_ITVL_MAX);
+            // The timeout has to outlast two intervals, skipped ones included.
+            params.supervision_timeout = std::max<uint16_t>(params.supervision_timeout,
+                                                            (1 + params.latency) * params.itvl_max / 4 + 1);
+        }
+
+        rc = requestConnParams(&params);
+        if(rc == BLE_HS_ENOTCONN) {
+            break;
+        }
+        if(rc != 0) {
+            NIMBLE_LOGW(LOG_TAG, "Connection parameters rejected: %d, %s",
+                        rc, NimBLEUtils::returnCodeToString(rc));
+        }
+    }
+
+    m_lastErr = rc;
+    NIMBLE_LOGD(LOG_TAG, "<< applyProfile(): rc=%d", rc);
+    return rc == 0;
+} // applyProfile
+
+
+/**
+ * @brief Request new connection parameters and wait for the server to accept or reject them.
+ * @param [in] params The connection parameters to request.
+ * @return 0 when updated, the status the update failed with, or BLE_HS_ENOTCONN if disconnected meanwhile.
+ */
+int NimBLEClient::requestConnParams(const ble_gap_upd_params* params) {
+    if(m_pUpdateTaskData != nullptr) {
+        NIMBLE_LOGE(LOG_TAG, "Connection parameters update already in progress");
+        return BLE_HS_EBUSY;
+    }
+
+    TaskHandle_t cur_task = xTaskGetCurrentTaskHandle();
+    ble_task_data_t taskData = {this, cur_task, 0, nullptr};
+    m_pUpdateTaskData = &taskData;
+
+    int rc = ble_gap_update_params(m_conn_id, params);
+    if(rc != 0) {
+        m_pUpdateTaskData = nullptr;
+        return rc;
+    }
+
+#ifdef ulTaskNotifyValueClear
+    // Clear the task notification value to ensure we block
+    ulTaskNotifyValueClear(cur_task, ULONG_MAX);
+#endif
+    // Released by the connection update event, which comes on success, rejection or link layer timeout,
+    // or by the disconnect event.
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    return taskData.rc;
+} // requestConnParams
+
+
 /**
  * @brief Get detailed information about the current peer connection.
  */
@@ -557,6 +729,24 @@ NimBLEAddress NimBLEClient::getPeerAddress() {
 } // getPeerAddress
 
 
+/**
+ * @brief Set the connection handle, and index the client by it in NimBLEDevice's client table.
+ * @param [in] connId The connection handle, BLE_HS_CONN_HANDLE_NONE when disconnected.
+ */
+void NimBLEClient::setConnId(uint16_t connId) {
+    m_conn_id = connId;
+    if(m_clientSlot < 0) {
+        return;
+    }
+
+    if(connId == BLE_HS_CONN_HANDLE_NONE) {
+        NimBLEDevice::m_clients.clearConnHandle(m_clientSlot);
+    } else {
+        NimBLEDevice::m_clients.setConnHandle(m_clientSlot, connId);
+    }
+} // setConnId
+
+
 /**
  * @brief Set the peer address.
  * @param [in] address The address of the peer that this client is
@@ -569,6 +759,9 @@ void NimBLEClient::setPeerAddress(const NimBLEAddress &address) {
     }
 
     m_peerAddress = address;
+    if(m_clientSlot >= 0) {
+        NimBLEDevice::m_clients.setAddress(m_clientSlot, NimBLEDevice::clientAddressKey(address));
+    }
     NIMBLE_LOGD(LOG_TAG, "Peer address set: %s", std::string(m_peerAddress).c_str());
 } // setPeerAddress
 
@@ -729,6 +922,315 @@ bool NimBLEClient::discoverAttributes() {
 } // discoverAttributes
 
 
+/**
+ * @brief Restore the peer's attributes as saveAttributes() stored them, instead of discovering them.
+ * @details Call after connecting, any attributes the client has are replaced. Checks the stored attributes are
+ * current by reading the peer's Database Hash, one request where discovery takes several. A peer without one has
+ * to be bonded, and its stored attributes have to include the Service Changed characteristic saveAttributes()
+ * subscribed to, or they are erased and have to be discovered again. Attributes that weren't stored are still
+ * discovered when asked for.
+ * @return True if the attributes were restored.
+ */
+bool NimBLEClient::restoreAttributes() {
+    if(!isConnected()) {
+        NIMBLE_LOGE(LOG_TAG, "Disconnected, could not restore attributes");
+        return false;
+    }
+
+    m_dbHashRc = NimBLEGattCache::readDatabaseHash(this, m_dbHash);
+    if(m_dbHashRc != 0 && m_dbHashRc != BLE_HS_ENOENT) {
+        return false;
+    }
+
+    if(m_dbHashRc == BLE_HS_ENOENT && !NimBLEDevice::isBonded(m_peerAddress)) {
+        NIMBLE_LOGD(LOG_TAG, "Peer has no database hash and isn't bonded, attributes not restored");
+        return false;
+    }
+
+    deleteServices();
+    if(!NimBLEGattCache::load(this, m_dbHashRc == 0 ? m_dbHash : nullptr)) {
+        return false;
+    }
+
+    if(m_dbHashRc == 0) {
+        return true;
+    }
+
+    // Without a hash only a Service Changed indication tells the attributes changed. It may have come before they
+    // were restored, when it couldn't be matched to a characteristic.
+    NimBLERemoteCharacteristic* pServiceChanged = getServiceChanged();
+    if(pServiceChanged == nullptr || pServiceChanged->getHandle() == m_unresolvedIndication) {
+        NIMBLE_LOGI(LOG_TAG, "Stored attributes may have changed, discovering them again");
+        deleteServices();
+        NimBLEGattCache::erase(m_peerAddress);
+        return false;
+    }
+
+    return true;
+} // restoreAttributes
+
+
+/**
+ * @brief Store the attributes discovered so far in NVS, for restoreAttributes() on the next connection.
+ * @details Call once the attributes the application uses have been retrieved, including the descriptors it
+ * subscribes through. Only peers with a Database Hash or a bond are stored, and the entry is marked stale when the
+ * peer indicates Service Changed, to be erased from the application's task (see NimBLEGattCache::erasePending()).
+ * For a bonded peer without a hash this subscribes to Service Changed indications first, and nothing is stored if
+ * the peer doesn't offer them.
+ * @return True if the attributes were stored.
+ */
+bool NimBLEClient::saveAttributes() {
+    if(!isConnected()) {
+        NIMBLE_LOGE(LOG_TAG, "Disconnected, could not save attributes");
+        return false;
+    }
+
+    if(m_dbHashRc != 0 && m_dbHashRc != BLE_HS_ENOENT) {
+        m_dbHashRc = NimBLEGattCache::readDatabaseHash(this, m_dbHash);
+    }
+
+    if(m_dbHashRc != 0 && (m_dbHashRc != BLE_HS_ENOENT || !NimBLEDevice::isBonded(m_peerAddress))) {
+        NIMBLE_LOGI(LOG_TAG, "Attributes of an unbonded peer without a database hash can't be checked, not saved");
+        return false;
+    }
+
+    if(m_dbHashRc != 0) {
+        // The server keeps a bonded client's subscription, so this lasts until the bond is deleted.
+        NimBLERemoteService* pService = getService(NimBLEUUID((uint16_t)0x1801));
+        NimBLERemoteCharacteristic* pChr = pService == nullptr ? nullptr :
+                                           pService->getCharacteristic(NimBLEUUID((uint16_t)0x2a05));
+        if(pChr == nullptr || !pChr->canIndicate() || pChr->getDescriptor(NimBLEUUID((uint16_t)0x2902)) == nullptr ||
+           !pChr->subscribe(false)) {
+            NIMBLE_LOGI(LOG_TAG, "Peer without a database hash doesn't indicate Service Changed, not saved");
+            return false;
+        }
+    }
+
+    return NimBLEGattCache::save(this, m_dbHashRc == 0 ? m_dbHash : nullptr);
+} // saveAttributes
+
+
+/**
+ * @brief Get the Service Changed characteristic among the attributes retrieved so far, without discovering any.
+ * @return The characteristic, or nullptr if it or its Client Characteristic Configuration descriptor wasn't retrieved.
+ */
+NimBLERemoteCharacteristic* NimBLEClient::getServiceChanged() {
+    for(auto &svc: m_servicesVector) {
+        if(svc->m_uuid != NimBLEUUID((uint16_t)0x1801)) {
+            continue;
+        }
+        for(auto &chr: svc->m_characteristicVector) {
+            if(chr->m_uuid != NimBLEUUID((uint16_t)0x2a05)) {
+                continue;
+            }
+            for(auto &dsc: chr->m_descriptorVector) {
+                if(dsc->getUUID() == NimBLEUUID((uint16_t)0x2902)) {
+                    return chr;
+                }
+            }
+        }
+    }
+    return nullptr;
+} // getServiceChanged
+
+
+/**
+ * @brief Get the characteristic a notification or indication is for.
+ * @details Looks the handle up in a flat table of the characteristics retrieved so far, which is rebuilt here
+ * after they change. Falls back to searching each service if the handles are too far apart for a table.
+ * @param [in] handle The value handle the notification came from.
+ * @return The characteristic, or nullptr if it hasn't been retrieved.
+ */
+NimBLERemoteCharacteristic* NimBLEClient::getNotifyCharacteristic(uint16_t handle) {
+    if(m_handleTableState == HANDLE_TABLE_STALE) {
+        // Set first, an invalidation while building makes the next lookup build again.
+        m_handleTableState = HANDLE_TABLE_READY;
+
+        uint16_t first = UINT16_MAX;
+        uint16_t last  = 0;
+        for(auto &svc: m_servicesVector) {
+            for(auto &chr: svc->m_characteristicVector) {
+                first = std::min(first, chr->getHandle());
+                last  = std::max(last, chr->getHandle());
+            }
+        }
+
+        if(m_handleTable.reset(first, last, NIMBLE_CPP_HANDLE_TABLE_MAX_SPAN)) {
+            for(auto &svc: m_servicesVector) {
+                for(auto &chr: svc->m_characteristicVector) {
+                    m_handleTable.set(chr->getHandle(), chr);
+                }
+            }
+        } else if(first <= last) {
+            m_handleTableState = HANDLE_TABLE_TOO_WIDE;
+        }
+    }
+
+    if(m_handleTableState != HANDLE_TABLE_TOO_WIDE) {
+        return m_handleTable.find(handle);
+    }
+
+    for(auto &svc: m_servicesVector) {
+        // Dont waste cycles searching services without this handle in its range
+        if(svc->getEndHandle() < handle) {
+            continue;
+        }
+
+        for(auto &chr: svc->m_characteristicVector) {
+            if(chr->getHandle() == handle) {
+                return chr;
+            }
+        }
+    }
+
+    return nullptr;
+} // getNotifyCharacteristic
+
+
+/**
+ * @brief Mark the handle table stale, after characteristics were added or deleted.
+ */
+void NimBLEClient::invalidateHandleTable() {
+    m_handleTableState = HANDLE_TABLE_STALE;
+} // invalidateHandleTable
+
+
+/**
+ * @brief Queue an asynchronous operation, starting it if no other is in progress.
+ * @details ATT allows a client one request at a time, so the operations run one after another, each started from
+ * the host task as the one before it completes rather than by the task that queued it.
+ * @param [in] op The operation, which the queue owns from here on.
+ * @return false if the operation could not be started, in which case it has been deleted without a callback.
+ */
+bool NimBLEClient::queueGattOp(NimBLEGattOp* op) {
+    op->next = nullptr;
+
+    ble_npl_hw_enter_critical();
+    bool idle = m_gattOpHead == nullptr;
+    if(idle) {
+        m_gattOpHead = op;
+    } else {
+        m_gattOpTail->next = op;
+    }
+    m_gattOpTail = op;
+    ble_npl_hw_exit_critical(0);
+
+    if(!idle) {
+        return true;
+    }
+
+    int rc = NimBLERemoteCharacteristic::startOp(op);
+    if(rc != 0) {
+        NIMBLE_LOGE(LOG_TAG, "Failed to start GATT operation; rc=%d, %s",
+                    rc, NimBLEUtils::returnCodeToString(rc));
+        // Drop it and start whatever was queued behind it meanwhile. If its characteristic was deleted in the
+        // meantime it has been reported already, as callers of a successful queue expect.
+        bool claimed = claimGattOp(op);
+        nextGattOp();
+        return !claimed;
+    }
+
+    return true;
+} // queueGattOp
+
+
+/**
+ * @brief Delete the operation at the head of the queue, which has completed, and start the next.
+ * @details Operations that fail to start, as all do once disconnected, complete with the error straight away.
+ */
+void NimBLEClient::nextGattOp() {
+    while(true) {
+        ble_npl_hw_enter_critical();
+        NimBLEGattOp* op = m_gattOpHead;
+        m_gattOpHead = op->next;
+        if(m_gattOpHead == nullptr) {
+            m_gattOpTail = nullptr;
+        }
+        NimBLEGattOp* next = m_gattOpHead;
+        ble_npl_hw_exit_critical(0);
+
+        delete op;
+        if(next == nullptr) {
+            return;
+        }
+
+        int rc = NimBLERemoteCharacteristic::startOp(next);
+        if(rc == 0) {
+            return;
+        }
+        if(claimGattOp(next)) {
+            NimBLERemoteCharacteristic::completeOp(next, rc);
+        }
+    }
+} // nextGattOp
+
+
+/**
+ * @brief Take the right to report an operation to its callback, which only one of the stack's completion and
+ * cancelGattOps() gets.
+ * @param [in] op The operation, queued.
+ * @return false if it has been reported already.
+ */
+bool NimBLEClient::claimGattOp(NimBLEGattOp* op) {
+    ble_npl_hw_enter_critical();
+    bool claimed = !op->completed;
+    op->completed = true;
+    ble_npl_hw_exit_critical(0);
+
+    return claimed;
+} // claimGattOp
+
+
+/**
+ * @brief Complete the queued operations on the characteristics of a service with BLE_HS_ENOENT, before the
+ * characteristics are deleted.
+ * @details Operations that haven't started are taken off the queue. The one in progress is reported now, while its
+ * characteristic still exists, and stays at the head of the queue until the stack completes it; a write may still
+ * reach the peer.
+ * @param [in] pService The service whose characteristics are deleted, nullptr for all of them.
+ */
+void NimBLEClient::cancelGattOps(const NimBLERemoteService* pService) {
+    NimBLEGattOp*  inProgress = nullptr;
+    NimBLEGattOp*  cancelled = nullptr;
+    NimBLEGattOp** cancelledTail = &cancelled;
+
+    ble_npl_hw_enter_critical();
+    NimBLEGattOp* head = m_gattOpHead;
+    if(head != nullptr) {
+        // A head reported already may have lost its characteristic, so it isn't looked at again.
+        if(!head->completed &&
+           (pService == nullptr || head->pCharacteristic->getRemoteService() == pService)) {
+            head->completed = true;
+            inProgress = head;
+        }
+
+        NimBLEGattOp* prev = head;
+        for(NimBLEGattOp* op = head->next; op != nullptr; op = prev->next) {
+            if(pService == nullptr || op->pCharacteristic->getRemoteService() == pService) {
+                prev->next = op->next;
+                op->next = nullptr;
+                *cancelledTail = op;
+                cancelledTail = &op->next;
+            } else {
+                prev = op;
+            }
+        }
+        m_gattOpTail = prev;
+    }
+    ble_npl_hw_exit_critical(0);
+
+    if(inProgress != nullptr) {
+        NimBLERemoteCharacteristic::completeOp(inProgress, BLE_HS_ENOENT);
+    }
+    while(cancelled != nullptr) {
+        NimBLEGattOp* next = cancelled->next;
+        NimBLERemoteCharacteristic::completeOp(cancelled, BLE_HS_ENOENT);
+        delete cancelled;
+        cancelled = next;
+    }
+} // cancelGattOps
+
+
 /**
  * @brief Ask the remote %BLE server for its services.\n
  * Here we ask the server for its set of services and wait until we have received them all.
@@ -960,7 +1462,13 @@ int NimBLEClient::handleGapEvent(struct ble_gap_event *event, void *arg) {
             NimBLEDevice::removeIgnored(client->m_peerAddress);
 
             // No longer connected, clear the connection ID.
-            client->m_conn_id = BLE_HS_CONN_HANDLE_NONE;
+            client->setConnId(BLE_HS_CONN_HANDLE_NONE);
+
+            if(client->m_pUpdateTaskData != nullptr) {
+                client->m_pUpdateTaskData->rc = BLE_HS_ENOTCONN;
+                xTaskNotifyGive(client->m_pUpdateTaskData->task);
+                client->m_pUpdateTaskData = nullptr;
+            }
 
             // If we received a connected event but did not get established (no PDU)
             // then a disconnect event will be sent but we should not send it to the
@@ -989,7 +1497,7 @@ int NimBLEClient::handleGapEvent(struct ble_gap_event *event, void *arg) {
             if (rc == 0) {
                 NIMBLE_LOGI(LOG_TAG, "Connected event");
 
-                client->m_conn_id = event->connect.conn_handle;
+                client->setConnId(event->connect.conn_handle);
 
                 rc = ble_gattc_exchange_mtu(client->m_conn_id, NULL,NULL);
                 if(rc != 0) {
@@ -1002,7 +1510,7 @@ int NimBLEClient::handleGapEvent(struct ble_gap_event *event, void *arg) {
                 // scanning since we are already connected to it
                 NimBLEDevice::addIgnored(client->m_peerAddress);
             } else {
-                client->m_conn_id = BLE_HS_CONN_HANDLE_NONE;
+                client->setConnId(BLE_HS_CONN_HANDLE_NONE);
                 break;
             }
 
@@ -1022,38 +1530,40 @@ int NimBLEClient::handleGapEvent(struct ble_gap_event *event, void *arg) {
             NIMBLE_LOGD(LOG_TAG, "Notify Recieved for handle: %d",
                         event->notify_rx.attr_handle);
 
-            for(auto &it: client->m_servicesVector) {
-                // Dont waste cycles searching services without this handle in its range
-                if(it->getEndHandle() < event->notify_rx.attr_handle) {
-                    continue;
-                }
-
-                auto cVector = &it->m_characteristicVector;
-                NIMBLE_LOGD(LOG_TAG, "checking service %s for handle: %d",
-                            it->getUUID().toString().c_str(),
-                            event->notify_rx.attr_handle);
-
-                auto characteristic = cVector->cbegin();
-                for(; characteristic != cVector->cend(); ++characteristic) {
-                    if((*characteristic)->m_handle == event->notify_rx.attr_handle)
-                        break;
-                }
+            NimBLERemoteCharacteristic* characteristic =
+                client->getNotifyCharacteristic(event->notify_rx.attr_handle);
 
-                if(characteristic != cVector->cend()) {
-                    NIMBLE_LOGD(LOG_TAG, "Got Notification for characteristic %s",
-                                (*characteristic)->toString().c_str());
+            if(characteristic != nullptr) {
+                NIMBLE_LOGD(LOG_TAG, "Got Notification for characteristic %s",
+                            characteristic->toString().c_str());
 
+                if (characteristic->m_notifyViewCallback != nullptr) {
+                    // Hand out the received buffers as they are, the value is not stored.
+                    NIMBLE_LOGD(LOG_TAG, "Invoking view callback for notification on characteristic %s",
+                                characteristic->toString().c_str());
+                    characteristic->m_notifyViewCallback(characteristic, NimBLEMbufView(event->notify_rx.om),
+                                                         !event->notify_rx.indication);
+                } else {
                     uint32_t data_len = OS_MBUF_PKTLEN(event->notify_rx.om);
-                    (*characteristic)->m_value.setValue(event->notify_rx.om->om_data, data_len);
+                    characteristic->m_value.setValue(event->notify_rx.om->om_data, data_len);
 
-                    if ((*characteristic)->m_notifyCallback != nullptr) {
+                    if (characteristic->m_notifyCallback != nullptr) {
                         NIMBLE_LOGD(LOG_TAG, "Invoking callback for notification on characteristic %s",
-                                    (*characteristic)->toString().c_str());
-                        (*characteristic)->m_notifyCallback(*characteristic, event->notify_rx.om->om_data,
-                                                            data_len, !event->notify_rx.indication);
+                                    characteristic->toString().c_str());
+                        characteristic->m_notifyCallback(characteristic, event->notify_rx.om->om_data,
+                                                         data_len, !event->notify_rx.indication);
                     }
-                    break;
                 }
+
+                // Service Changed, the peer's attributes changed and their handles may have moved.
+                if(event->notify_rx.indication &&
+                   characteristic->getUUID() == NimBLEUUID((uint16_t)0x2a05)) {
+                    client->invalidateHandleTable();
+                    NimBLEGattCache::markStale(client->m_peerAddress);
+                }
+            } else if(event->notify_rx.indication) {
+                // May be Service Changed before the attributes are restored, restoreAttributes() checks the handle.
+                client->m_unresolvedIndication = event->notify_rx.attr_handle;
             }
 
             return 0;
@@ -1095,6 +1605,12 @@ int NimBLEClient::handleGapEvent(struct ble_gap_event *event, void *arg) {
             } else {
                 NIMBLE_LOGE(LOG_TAG, "Update connection parameters failed.");
             }
+
+            if(client->m_pUpdateTaskData != nullptr) {
+                client->m_pUpdateTaskData->rc = event->conn_update.status;
+                xTaskNotifyGive(client->m_pUpdateTaskData->task);
+                client->m_pUpdateTaskData = nullptr;
+            }
             return 0;
         } // BLE_GAP_EVENT_CONN_UPDATE
 
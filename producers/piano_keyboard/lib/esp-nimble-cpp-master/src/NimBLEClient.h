@@ -23,7 +23,9 @@
 #include "NimBLEConnInfo.h"
 #include "NimBLEAttValue.h"
 #include "NimBLEAdvertisedDevice.h"
+#include "NimBLEHandleTable.h"
 #include "NimBLERemoteService.h"
+#include "NimBLEGattCache.h"
 
 #include <vector>
 #include <string>
@@ -32,12 +34,22 @@ class NimBLERemoteService;
 class NimBLERemoteCharacteristic;
 class NimBLEClientCallbacks;
 class NimBLEAdvertisedDevice;
+struct NimBLEGattOp;
 
 /**
  * @brief A model of a %BLE client.
  */
 class NimBLEClient {
 public:
+    /**
+     * @brief Presets of connection parameters, PHY and data length for applyProfile().
+     */
+    enum ConnProfile : uint8_t {
+        LOW_LATENCY, // the shortest interval BLE MIDI allows, for input devices
+        THROUGHPUT,  // an interval with room for several long packets, for bulk transfers
+        LOW_POWER,   // a long interval the peer may skip when idle, for sensors
+    };
+
     bool                                        connect(NimBLEAdvertisedDevice* device, bool deleteAttibutes = true);
     bool                                        connect(const NimBLEAddress &address, bool deleteAttibutes = true);
     bool                                        connect(bool deleteAttibutes = true);
@@ -70,7 +82,10 @@ public:
     void                                        updateConnParams(uint16_t minInterval, uint16_t maxInterval,
                                                                  uint16_t latency, uint16_t timeout);
     void                                        setDataLen(uint16_t tx_octets);
+    bool                                        applyProfile(ConnProfile profile);
     bool                                        discoverAttributes();
+    bool                                        restoreAttributes();
+    bool                                        saveAttributes();
     NimBLEConnInfo                              getConnInfo();
     int                                         getLastError();
 #if CONFIG_BT_NIMBLE_EXT_ADV
@@ -83,6 +98,8 @@ private:
 
     friend class            NimBLEDevice;
     friend class            NimBLERemoteService;
+    friend class            NimBLERemoteCharacteristic;
+    friend class            NimBLEGattCache;
 
     static int              handleGapEvent(struct ble_gap_event *event, void *arg);
     static int              serviceDiscoveredCB(uint16_t conn_handle,
@@ -91,15 +108,26 @@ private:
                                                 void *arg);
     static void             dcTimerCb(ble_npl_event *event);
     bool                    retrieveServices(const NimBLEUUID *uuid_filter = nullptr);
+    NimBLERemoteCharacteristic* getNotifyCharacteristic(uint16_t handle);
+    NimBLERemoteCharacteristic* getServiceChanged();
+    void                    invalidateHandleTable();
+    bool                    queueGattOp(NimBLEGattOp* op);
+    void                    nextGattOp();
+    bool                    claimGattOp(NimBLEGattOp* op);
+    void                    cancelGattOps(const NimBLERemoteService* pService = nullptr);
+    int                     requestConnParams(const ble_gap_upd_params* params);
+    void                    setConnId(uint16_t connId);
 
     NimBLEAddress           m_peerAddress;
     int                     m_lastErr;
     uint16_t                m_conn_id;
+    int                     m_clientSlot; // in NimBLEDevice's client table
     bool                    m_connEstablished;
     bool                    m_deleteCallbacks;
     int32_t                 m_connectTimeout;
     NimBLEClientCallbacks*  m_pClientCallbacks;
     ble_task_data_t*        m_pTaskData;
+    ble_task_data_t*        m_pUpdateTaskData;
     ble_npl_callout         m_dcTimer;
 #if CONFIG_BT_NIMBLE_EXT_ADV
     uint8_t                 m_phyMask;
@@ -107,6 +135,24 @@ private:
 
     std::vector<NimBLERemoteService*> m_servicesVector;
 
+    enum HandleTableState : uint8_t {
+        HANDLE_TABLE_STALE,    // attributes changed since it was built
+        HANDLE_TABLE_READY,
+        HANDLE_TABLE_TOO_WIDE, // the handles are too far apart for a flat table
+    };
+    NimBLEHandleTable<NimBLERemoteCharacteristic> m_handleTable;
+    volatile HandleTableState m_handleTableState;
+
+    // Asynchronous operations in the order they were queued, the first is the one in progress.
+    NimBLEGattOp*           m_gattOpHead;
+    NimBLEGattOp*           m_gattOpTail;
+
+    // The result of reading the peer's Database Hash this connection, BLE_HS_EUNKNOWN until read.
+    int                     m_dbHashRc;
+    uint8_t                 m_dbHash[NIMBLE_CPP_GATT_DB_HASH_LEN];
+    // The handle of the last indication this connection for a characteristic not retrieved yet, 0 if none.
+    volatile uint16_t       m_unresolvedIndication;
+
 private:
     friend class NimBLEClientCallbacks;
     ble_gap_conn_params m_pConnParams;
@@ -0,0 +1,235 @@
+/*
+ * NimBLEClientTable.h
+ *
+ *  Created: on October 17 2026
+ */
+
+#ifndef COMPONENTS_NIMBLE_CLIENT_TABLE_H_
+#define COMPONENTS_NIMBLE_CLIENT_TABLE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief The bits of the smallest power of two that is at least twice n. */
+constexpr size_t nimbleClientTableIndexBits(size_t n, size_t bits = 1) {
+    return ((size_t)1 << bits) >= 2 * n ? bits : nimbleClientTableIndexBits(n, bits + 1);
+}
+
+/**
+ * @brief Fixed capacity table of clients, with constant time lookups by connection handle and by peer address.
+ * @details A client lives in one of N slots for as long as it is in the table; the slot is the client's key for
+ * every other call. Each slot's connection handle and peer address are indexed in a hash table of at least twice
+ * N entries, open addressed with linear probing and backward-shift deletion. Several clients may have the same
+ * peer address, but only one the same connection handle. Nothing is allocated after construction. The table does
+ * not own the clients, and has no dependencies on the stack so that it also builds on a host.
+ */
+template<typename T, size_t N>
+class NimBLEClientTable {
+    static_assert(N > 0 && N <= 32, "A client table holds 1 to 32 clients");
+
+public:
+    static const int NO_SLOT = -1;
+
+    NimBLEClientTable() {
+        for(size_t i = 0; i < N; i++) {
+            m_clients[i] = nullptr;
+        }
+    } // NimBLEClientTable
+
+
+    /**
+     * @brief Put a client in a free slot, not connected and with a peer address.
+     * @param [in] client The client, must not be nullptr.
+     * @param [in] addressKey The key of the client's peer address.
+     * @return The slot, or NO_SLOT if all N are taken.
+     */
+    int add(T* client, uint64_t addressKey) {
+        uint32_t free = ~m_used & ALL_SLOTS;
+        if(free == 0) {
+            return NO_SLOT;
+        }
+
+        int slot = lowestBit(free);
+        m_clients[slot]   = client;
+        m_addresses[slot] = addressKey;
+        m_used           |= 1UL << slot;
+        m_byAddress.insert(addressKey, slot);
+        return slot;
+    } // add
+
+
+    /**
+     * @brief Take a client out of the table, along with its connection handle and peer address.
+     */
+    void remove(int slot) {
+        clearConnHandle(slot);
+        m_byAddress.erase(m_addresses[slot], slot);
+        m_clients[slot] = nullptr;
+        m_used         &= ~(1UL << slot);
+    } // remove
+
+
+    /**
+     * @brief Record the connection handle of a client that connected.
+     */
+    void setConnHandle(int slot, uint16_t connHandle) {
+        clearConnHandle(slot);
+        m_handles[slot] = connHandle;
+        m_connected    |= 1UL << slot;
+        m_byHandle.insert(connHandle, slot);
+    } // setConnHandle
+
+
+    /**
+     * @brief Forget the connection handle of a client that disconnected, if it had one.
+     */
+    void clearConnHandle(int slot) {
+        if(m_connected & (1UL << slot)) {
+            m_byHandle.erase(m_handles[slot], slot);
+            m_connected &= ~(1UL << slot);
+        }
+    } // clearConnHandle
+
+
+    /**
+     * @brief Change the peer address of a client.
+     */
+    void setAddress(int slot, uint64_t addressKey) {
+        m_byAddress.erase(m_addresses[slot], slot);
+        m_addresses[slot] = addressKey;
+        m_byAddress.insert(addressKey, slot);
+    } // setAddress
+
+
+    /**
+     * @brief Get the client with a connection handle.
+     * @return The client, or nullptr if none is connected with it.
+     */
+    T* findByConnHandle(uint16_t connHandle) const {
+        int slot = m_byHandle.find(connHandle);
+        return slot == NO_SLOT ? nullptr : m_clients[slot];
+    } // findByConnHandle
+
+
+    /**
+     * @brief Get a client with a peer address.
+     * @return The client, any one of them if several have the address, or nullptr if none has.
+     */
+    T* findByAddress(uint64_t addressKey) const {
+        int slot = m_byAddress.find(addressKey);
+        return slot == NO_SLOT ? nullptr : m_clients[slot];
+    } // findByAddress
+
+
+    /**
+     * @brief Get the client in the lowest slot that isn't connected.
+     * @return The client, or nullptr if all of them are connected.
+     */
+    T* findDisconnected() const {
+        uint32_t disconnected = m_used & ~m_connected;
+        return disconnected == 0 ? nullptr : m_clients[lowestBit(disconnected)];
+    } // findDisconnected
+
+
+    /**
+     * @brief Get the client in a slot.
+     * @return The client, or nullptr if the slot is free.
+     */
+    T* at(size_t slot) const {
+        return slot < N ? m_clients[slot] : nullptr;
+    } // at
+
+
+    size_t size() const {
+        size_t count = 0;
+        for(uint32_t used = m_used; used != 0; used &= used - 1) {
+            count++;
+        }
+        return count;
+    } // size
+
+
+    static size_t capacity() { return N; }
+
+private:
+    static const uint32_t ALL_SLOTS = 0xFFFFFFFFUL >> (32 - N);
+
+    static int lowestBit(uint32_t bits) {
+        return __builtin_ctz(bits);
+    } // lowestBit
+
+    /**
+     * @brief Hash index from key to slot.
+     */
+    class Index {
+    public:
+        Index() {
+            for(size_t i = 0; i < SIZE; i++) {
+                m_slots[i] = 0;
+            }
+        } // Index
+
+        int find(uint64_t key) const {
+            for(size_t i = home(key); m_slots[i] != 0; i = (i + 1) & MASK) {
+                if(m_keys[i] == key) {
+                    return m_slots[i] - 1;
+                }
+            }
+            return NO_SLOT;
+        } // find
+
+        void insert(uint64_t key, int slot) {
+            size_t i = home(key);
+            while(m_slots[i] != 0) {
+                i = (i + 1) & MASK;
+            }
+            m_keys[i]  = key;
+            m_slots[i] = (uint8_t)(slot + 1);
+        } // insert
+
+        void erase(uint64_t key, int slot) {
+            size_t hole = home(key);
+            while(m_slots[hole] != slot + 1 || m_keys[hole] != key) {
+                if(m_slots[hole] == 0) {
+                    return;
+                }
+                hole = (hole + 1) & MASK;
+            }
+
+            // Pull back every later entry of the run that may not be probed past the hole.
+            for(size_t i = (hole + 1) & MASK; m_slots[i] != 0; i = (i + 1) & MASK) {
+                size_t h = home(m_keys[i]);
+                // The entry can move if its home slot is not cyclically within (hole, i].
+                if(((i - h) & MASK) >= ((i - hole) & MASK)) {
+                    m_keys[hole]  = m_keys[i];
+                    m_slots[hole] = m_slots[i];
+                    hole = i;
+                }
+            }
+            m_slots[hole] = 0;
+        } // erase
+
+    private:
+        static const size_t BITS = nimbleClientTableIndexBits(N);
+        static const size_t SIZE = (size_t)1 << BITS;
+        static const size_t MASK = SIZE - 1;
+
+        // Fibonacci hashing, which spreads sequential handles and the addresses one vendor assigns.
+        static size_t home(uint64_t key) {
+            return (key * 0x9E3779B97F4A7C15ULL) >> (64 - BITS);
+        } // home
+
+        uint64_t m_keys[SIZE];
+        uint8_t  m_slots[SIZE]; // the slot + 1, 0 for an empty entry
+    };
+
+    T*       m_clients[N];
+    uint16_t m_handles[N];
+    uint64_t m_addresses[N];
+    uint32_t m_used      = 0;
+    uint32_t m_connected = 0;
+    Index    m_byHandle;
+    Index    m_byAddress;
+};
+
+#endif /* COMPONENTS_NIMBLE_CLIENT_TABLE_H_ */
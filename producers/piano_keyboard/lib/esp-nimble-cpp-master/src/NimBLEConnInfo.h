@@ -34,6 +34,12 @@ public:
     /** @brief Gets the maximum transmission unit size for this connection (in bytes) */
     uint16_t         getMTU()              { return ble_att_mtu(m_desc.conn_handle); }
 
+    /** @brief Gets the PHY this connection transmits on, BLE_GAP_LE_PHY_1M, _2M or _CODED, 0 if it can't be read */
+    uint8_t          getTxPhy()            { uint8_t tx = 0, rx = 0; ble_gap_read_le_phy(m_desc.conn_handle, &tx, &rx); return tx; }
+
+    /** @brief Gets the PHY this connection receives on, BLE_GAP_LE_PHY_1M, _2M or _CODED, 0 if it can't be read */
+    uint8_t          getRxPhy()            { uint8_t tx = 0, rx = 0; ble_gap_read_le_phy(m_desc.conn_handle, &tx, &rx); return rx; }
+
     /** @brief Check if we are in the master role in this connection */
     bool             isMaster()            { return (m_desc.role == BLE_GAP_ROLE_MASTER); }
 
@@ -79,7 +79,7 @@ NimBLEAdvertising* NimBLEDevice::m_bleAdvertising = nullptr;
 gap_event_handler           NimBLEDevice::m_customGapHandler = nullptr;
 ble_gap_event_listener      NimBLEDevice::m_listener;
 #if defined( CONFIG_BT_NIMBLE_ROLE_CENTRAL)
-std::list <NimBLEClient*>   NimBLEDevice::m_cList;
+NimBLEClientTable<NimBLEClient, NIMBLE_MAX_CONNECTIONS> NimBLEDevice::m_clients;
 #endif
 std::list <NimBLEAddress>   NimBLEDevice::m_ignoreList;
 std::vector<NimBLEAddress>  NimBLEDevice::m_whiteList;
@@ -205,22 +205,23 @@ NimBLEScan* NimBLEDevice::getScan() {
 
 
 /**
- * @brief Creates a new client object and maintains a list of all client objects
+ * @brief Creates a new client object and maintains a table of all client objects
  * each client can connect to 1 peripheral device.
  * @param [in] peerAddress An optional peer address that is copied to the new client
  * object, allows for calling NimBLEClient::connect(bool) without a device or address parameter.
- * @return A reference to the new client object.
+ * @return A reference to the new client object, or nullptr if there are already NIMBLE_MAX_CONNECTIONS clients.
  */
 #if defined(CONFIG_BT_NIMBLE_ROLE_CENTRAL)
 /* STATIC */
 NimBLEClient* NimBLEDevice::createClient(NimBLEAddress peerAddress) {
-    if(m_cList.size() >= NIMBLE_MAX_CONNECTIONS) {
-        NIMBLE_LOGW(LOG_TAG,"Number of clients exceeds Max connections. Cur=%d Max=%d",
-                    m_cList.size(), NIMBLE_MAX_CONNECTIONS);
-    }
-
     NimBLEClient* pClient = new NimBLEClient(peerAddress);
-    m_cList.push_back(pClient);
+    pClient->m_clientSlot = m_clients.add(pClient, clientAddressKey(peerAddress));
+    if(pClient->m_clientSlot == m_clients.NO_SLOT) {
+        NIMBLE_LOGE(LOG_TAG,"Number of clients would exceed Max connections. Max=%d",
+                    NIMBLE_MAX_CONNECTIONS);
+        delete pClient;
+        return nullptr;
+    }
 
     return pClient;
 } // createClient
@@ -265,7 +266,7 @@ bool NimBLEDevice::deleteClient(NimBLEClient* pClient) {
         }
     }
 
-    m_cList.remove(pClient);
+    m_clients.remove(pClient->m_clientSlot);
     delete pClient;
 
     return true;
@@ -273,12 +274,19 @@ bool NimBLEDevice::deleteClient(NimBLEClient* pClient) {
 
 
 /**
- * @brief Get the list of created client objects.
- * @return A pointer to the list of clients.
+ * @brief Get the created client objects.
+ * @return A copy of the clients, in the order of their slots in the client table.
  */
 /* STATIC */
-std::list<NimBLEClient*>* NimBLEDevice::getClientList() {
-    return &m_cList;
+std::vector<NimBLEClient*> NimBLEDevice::getClientList() {
+    std::vector<NimBLEClient*> clients;
+    clients.reserve(m_clients.size());
+    for(size_t i = 0; i < m_clients.capacity(); i++) {
+        if(m_clients.at(i) != nullptr) {
+            clients.push_back(m_clients.at(i));
+        }
+    }
+    return clients;
 } // getClientList
 
 
@@ -288,7 +296,7 @@ std::list<NimBLEClient*>* NimBLEDevice::getClientList() {
  */
 /* STATIC */
 size_t NimBLEDevice::getClientListSize() {
-    return m_cList.size();
+    return m_clients.size();
 } // getClientList
 
 
@@ -299,13 +307,9 @@ size_t NimBLEDevice::getClientListSize() {
  */
 /* STATIC */
 NimBLEClient* NimBLEDevice::getClientByID(uint16_t conn_id) {
-    for(auto it = m_cList.cbegin(); it != m_cList.cend(); ++it) {
-        if((*it)->getConnId() == conn_id) {
-            return (*it);
-        }
-    }
-    assert(0);
-    return nullptr;
+    NimBLEClient* pClient = m_clients.findByConnHandle(conn_id);
+    assert(pClient != nullptr);
+    return pClient;
 } // getClientByID
 
 
@@ -316,29 +320,36 @@ NimBLEClient* NimBLEDevice::getClientByID(uint16_t conn_id) {
  */
 /* STATIC */
 NimBLEClient* NimBLEDevice::getClientByPeerAddress(const NimBLEAddress &peer_addr) {
-    for(auto it = m_cList.cbegin(); it != m_cList.cend(); ++it) {
-        if((*it)->getPeerAddress().equals(peer_addr)) {
-            return (*it);
-        }
-    }
-    return nullptr;
+    return m_clients.findByAddress(clientAddressKey(peer_addr));
 } // getClientPeerAddress
 
 
 /**
- * @brief Finds the first disconnected client in the list.
+ * @brief Finds the first disconnected client in the table.
  * @return A pointer to the first client object that is not connected to a peer.
  */
 /* STATIC */
 NimBLEClient* NimBLEDevice::getDisconnectedClient() {
-    for(auto it = m_cList.cbegin(); it != m_cList.cend(); ++it) {
-        if(!(*it)->isConnected()) {
-            return (*it);
-        }
-    }
-    return nullptr;
+    return m_clients.findDisconnected();
 } // getDisconnectedClient
 
+
+/**
+ * @brief Get the key of a peer address in the client table.
+ * @details Addresses compare equal regardless of their type, so the type is left out.
+ * @param [in] address The peer address.
+ * @return The 6 address bytes as an integer.
+ */
+/* STATIC */
+uint64_t NimBLEDevice::clientAddressKey(const NimBLEAddress &address) {
+    const uint8_t* native = address.getNative();
+    uint64_t key = 0;
+    for(int i = 5; i >= 0; i--) {
+        key = (key << 8) | native[i];
+    }
+    return key;
+} // clientAddressKey
+
 #endif // #if defined(CONFIG_BT_NIMBLE_ROLE_CENTRAL)
 
 #ifdef ESP_PLATFORM
@@ -956,9 +967,8 @@ void NimBLEDevice::deinit(bool clearAll) {
 #endif
 
 #if defined( CONFIG_BT_NIMBLE_ROLE_CENTRAL)
-            for(auto &it : m_cList) {
+            for(auto &it : getClientList()) {
                 deleteClient(it);
-                m_cList.clear();
             }
 #endif
 
@@ -32,6 +32,7 @@
 
 #if defined(CONFIG_BT_NIMBLE_ROLE_CENTRAL)
 #include "NimBLEClient.h"
+#include "NimBLEClientTable.h"
 #endif
 
 #if defined(CONFIG_BT_NIMBLE_ROLE_PERIPHERAL)
@@ -164,7 +165,7 @@ public:
     static NimBLEClient*    getClientByPeerAddress(const NimBLEAddress &peer_addr);
     static NimBLEClient*    getDisconnectedClient();
     static size_t           getClientListSize();
-    static std::list<NimBLEClient*>* getClientList();
+    static std::vector<NimBLEClient*> getClientList();
 #endif
 
 #if defined(CONFIG_BT_NIMBLE_ROLE_CENTRAL) || defined(CONFIG_BT_NIMBLE_ROLE_PERIPHERAL)
@@ -219,7 +220,8 @@ private:
 #endif
 
 #if defined( CONFIG_BT_NIMBLE_ROLE_CENTRAL)
-    static std::list <NimBLEClient*>  m_cList;
+    static NimBLEClientTable<NimBLEClient, NIMBLE_MAX_CONNECTIONS> m_clients;
+    static uint64_t                   clientAddressKey(const NimBLEAddress &address);
 #endif
     static std::list <NimBLEAddress>  m_ignoreList;
     static NimBLESecurityCallbacks*   m_securityCallbacks;
@@ -0,0 +1,507 @@
+/*
+ * NimBLEGattCache.cpp
+ *
+ *  Created: on October 17 2026
+ */
+
+#include "nimconfig.h"
+#if defined(CONFIG_BT_ENABLED) && defined(CONFIG_BT_NIMBLE_ROLE_CENTRAL)
+
+#include "NimBLEGattCache.h"
+#include "NimBLEClient.h"
+#include "NimBLEDevice.h"
+#include "NimBLERemoteService.h"
+#include "NimBLERemoteCharacteristic.h"
+#include "NimBLERemoteDescriptor.h"
+#include "NimBLELog.h"
+
+#include <climits>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#ifdef ESP_PLATFORM
+#  include "nvs.h"
+#endif
+
+#define NIMBLE_CPP_GATT_CACHE_NAMESPACE "nimble_gatt"
+#define NIMBLE_CPP_GATT_CACHE_VERSION   1
+
+static const char* LOG_TAG = "NimBLEGattCache";
+
+namespace {
+
+/**
+ * @brief The start of a stored entry, followed by the attributes: each service, then its characteristics, each of
+ * them followed by its descriptors.
+ */
+struct CacheHeader {
+    uint8_t  version;
+    uint8_t  hasHash;
+    uint8_t  count;
+    uint8_t  reserved;
+    uint8_t  hash[NIMBLE_CPP_GATT_DB_HASH_LEN];
+};
+
+enum CacheEntryKind : uint8_t {
+    ENTRY_SERVICE = 1,
+    ENTRY_CHARACTERISTIC,
+    ENTRY_DESCRIPTOR,
+};
+
+struct CacheEntry {
+    uint8_t  kind;
+    uint8_t  uuidType;    // BLE_UUID_TYPE_16, _32 or _128
+    uint8_t  properties;  // a characteristic's
+    uint8_t  reserved;
+    uint16_t handle;      // a service's start, a characteristic's value, a descriptor's
+    uint16_t handle2;     // a service's end, a characteristic's declaration
+    uint16_t endHandle;   // a characteristic's last descriptor, 0 if not known
+    uint8_t  uuid[16];
+};
+
+
+void storeUUID(CacheEntry* entry, const NimBLEUUID &uuid) {
+    const ble_uuid_any_t* native = uuid.getNative();
+    entry->uuidType = native->u.type;
+    memset(entry->uuid, 0, sizeof(entry->uuid));
+    switch(native->u.type) {
+        case BLE_UUID_TYPE_16:
+            memcpy(entry->uuid, &native->u16.value, sizeof(native->u16.value));
+            break;
+        case BLE_UUID_TYPE_32:
+            memcpy(entry->uuid, &native->u32.value, sizeof(native->u32.value));
+            break;
+        default:
+            memcpy(entry->uuid, native->u128.value, sizeof(native->u128.value));
+            break;
+    }
+}
+
+
+bool loadUUID(const CacheEntry* entry, ble_uuid_any_t* uuid) {
+    uuid->u.type = entry->uuidType;
+    switch(entry->uuidType) {
+        case BLE_UUID_TYPE_16:
+            memcpy(&uuid->u16.value, entry->uuid, sizeof(uuid->u16.value));
+            return true;
+        case BLE_UUID_TYPE_32:
+            memcpy(&uuid->u32.value, entry->uuid, sizeof(uuid->u32.value));
+            return true;
+        case BLE_UUID_TYPE_128:
+            memcpy(uuid->u128.value, entry->uuid, sizeof(uuid->u128.value));
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+/**
+ * @brief Make the NVS key of a peer, its address and address type in hex.
+ */
+void makeKey(const NimBLEAddress &address, char* key, size_t len) {
+    const uint8_t* val = address.getNative();
+    snprintf(key, len, "%02x%02x%02x%02x%02x%02x%x",
+             val[5], val[4], val[3], val[2], val[1], val[0], address.getType());
+}
+
+
+/**
+ * @brief Peers whose entries a Service Changed indication made stale, waiting to be erased. If more peers than
+ * there are connections indicate before they are, every entry is treated as stale.
+ */
+ble_addr_t staleAddresses[NIMBLE_MAX_CONNECTIONS];
+uint8_t    staleCount    = 0;
+bool       staleOverflow = false;
+
+} // namespace
+
+
+/**
+ * @brief Read the peer's Database Hash characteristic.
+ * @param [in] pClient The connected client.
+ * @param [out] hash Where to store the hash, NIMBLE_CPP_GATT_DB_HASH_LEN bytes.
+ * @return 0 on success, BLE_HS_ENOENT if the peer has no Database Hash, or the error.
+ */
+int NimBLEGattCache::readDatabaseHash(NimBLEClient* pClient, uint8_t* hash) {
+    TaskHandle_t cur_task = xTaskGetCurrentTaskHandle();
+    // buf is cleared once the hash is found
+    ble_task_data_t taskData = {pClient, cur_task, 0, hash};
+    ble_uuid16_t uuid = BLE_UUID16_INIT(0x2b2a);
+
+    int rc = ble_gattc_read_by_uuid(pClient->getConnId(), 1, 0xffff, &uuid.u,
+                                    NimBLEGattCache::onHashReadCB, &taskData);
+    if(rc != 0) {
+        NIMBLE_LOGE(LOG_TAG, "Error reading the database hash; rc=%d %s",
+                    rc, NimBLEUtils::returnCodeToString(rc));
+        return rc;
+    }
+
+#ifdef ulTaskNotifyValueClear
+    // Clear the task notification value to ensure we block
+    ulTaskNotifyValueClear(cur_task, ULONG_MAX);
+#endif
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    return taskData.rc;
+} // readDatabaseHash
+
+
+/**
+ * @brief Callback for the Database Hash read, once with the value and once at the end.
+ */
+int NimBLEGattCache::onHashReadCB(uint16_t conn_handle, const struct ble_gatt_error *error,
+                                  struct ble_gatt_attr *attr, void *arg)
+{
+    ble_task_data_t *pTaskData = (ble_task_data_t*)arg;
+    NimBLEClient *client = (NimBLEClient*)pTaskData->pATT;
+
+    if(client->getConnId() != conn_handle) {
+        return 0;
+    }
+
+    int rc = error->status;
+    if(rc == 0) {
+        if(attr != nullptr && pTaskData->buf != nullptr &&
+           OS_MBUF_PKTLEN(attr->om) == NIMBLE_CPP_GATT_DB_HASH_LEN)
+        {
+            os_mbuf_copydata(attr->om, 0, NIMBLE_CPP_GATT_DB_HASH_LEN, pTaskData->buf);
+            pTaskData->buf = nullptr;
+        }
+        return 0;
+    }
+
+    if(rc == BLE_HS_EDONE) {
+        rc = pTaskData->buf == nullptr ? 0 : BLE_HS_ENOENT;
+    } else if(rc == BLE_HS_ATT_ERR(BLE_ATT_ERR_ATTR_NOT_FOUND)) {
+        rc = BLE_HS_ENOENT;
+    }
+
+    pTaskData->rc = rc;
+    xTaskNotifyGive(pTaskData->task);
+    return 0;
+} // onHashReadCB
+
+
+/**
+ * @brief Create the client's attributes from the peer's entry.
+ * @details The client should have no attributes. A corrupt entry is erased.
+ * @param [in] pClient The connected client.
+ * @param [in] hash The peer's Database Hash, nullptr if it has none.
+ * @return True if the entry was found, current and restored.
+ */
+bool NimBLEGattCache::load(NimBLEClient* pClient, const uint8_t* hash) {
+#if defined(ESP_PLATFORM) && CONFIG_NIMBLE_CPP_GATT_CACHE_MAX_ATTRIBUTES > 0
+    erasePending();
+
+    char key[16];
+    makeKey(pClient->getPeerAddress(), key, sizeof(key));
+
+    nvs_handle_t nvs;
+    if(nvs_open(NIMBLE_CPP_GATT_CACHE_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return false;
+    }
+
+    size_t len = 0;
+    std::vector<uint8_t> blob;
+    esp_err_t err = nvs_get_blob(nvs, key, nullptr, &len);
+    if(err == ESP_OK && len >= sizeof(CacheHeader)) {
+        blob.resize(len);
+        err = nvs_get_blob(nvs, key, blob.data(), &len);
+    }
+    nvs_close(nvs);
+
+    if(err != ESP_OK || blob.empty()) {
+        NIMBLE_LOGD(LOG_TAG, "No attributes cached for %s", pClient->getPeerAddress().toString().c_str());
+        return false;
+    }
+
+    CacheHeader header;
+    memcpy(&header, blob.data(), sizeof(header));
+    if(header.version != NIMBLE_CPP_GATT_CACHE_VERSION ||
+       len != sizeof(CacheHeader) + header.count * sizeof(CacheEntry))
+    {
+        NIMBLE_LOGW(LOG_TAG, "Cached attributes of %s unusable", pClient->getPeerAddress().toString().c_str());
+        erase(pClient->getPeerAddress());
+        return false;
+    }
+
+    if(header.hasHash != (hash != nullptr) ||
+       (hash != nullptr && memcmp(header.hash, hash, NIMBLE_CPP_GATT_DB_HASH_LEN) != 0))
+    {
+        NIMBLE_LOGI(LOG_TAG, "Attributes of %s changed", pClient->getPeerAddress().toString().c_str());
+        erase(pClient->getPeerAddress());
+        return false;
+    }
+
+    NimBLERemoteService*        pService = nullptr;
+    NimBLERemoteCharacteristic* pChr     = nullptr;
+    bool                        valid    = true;
+
+    for(uint8_t i = 0; i < header.count && valid; i++) {
+        CacheEntry entry;
+        memcpy(&entry, blob.data() + sizeof(CacheHeader) + i * sizeof(CacheEntry), sizeof(entry));
+
+        switch(entry.kind) {
+            case ENTRY_SERVICE: {
+                ble_gatt_svc svc;
+                valid = loadUUID(&entry, &svc.uuid);
+                svc.start_handle = entry.handle;
+                svc.end_handle   = entry.handle2;
+                if(valid) {
+                    pService = new NimBLERemoteService(pClient, &svc);
+                    pClient->m_servicesVector.push_back(pService);
+                    pChr = nullptr;
+                }
+                break;
+            }
+
+            case ENTRY_CHARACTERISTIC: {
+                ble_gatt_chr chr;
+                valid = pService != nullptr && loadUUID(&entry, &chr.uuid);
+                chr.def_handle = entry.handle2;
+                chr.val_handle = entry.handle;
+                chr.properties = entry.properties;
+                if(valid) {
+                    pChr = new NimBLERemoteCharacteristic(pService, &chr);
+                    pChr->m_endHandle = entry.endHandle;
+                    pService->m_characteristicVector.push_back(pChr);
+                }
+                break;
+            }
+
+            case ENTRY_DESCRIPTOR: {
+                ble_gatt_dsc dsc;
+                valid = pChr != nullptr && loadUUID(&entry, &dsc.uuid);
+                dsc.handle = entry.handle;
+                if(valid) {
+                    pChr->m_descriptorVector.push_back(new NimBLERemoteDescriptor(pChr, &dsc));
+                }
+                break;
+            }
+
+            default:
+                valid = false;
+                break;
+        }
+    }
+
+    pClient->invalidateHandleTable();
+
+    if(!valid) {
+        NIMBLE_LOGW(LOG_TAG, "Cached attributes of %s corrupt", pClient->getPeerAddress().toString().c_str());
+        pClient->deleteServices();
+        erase(pClient->getPeerAddress());
+        return false;
+    }
+
+    // Service Changed may have been indicated while the entry was read.
+    if(isStale(pClient->getPeerAddress())) {
+        NIMBLE_LOGI(LOG_TAG, "Attributes of %s changed", pClient->getPeerAddress().toString().c_str());
+        pClient->deleteServices();
+        return false;
+    }
+
+    NIMBLE_LOGI(LOG_TAG, "Restored %d attributes of %s", header.count,
+                pClient->getPeerAddress().toString().c_str());
+    return true;
+#else
+    return false;
+#endif
+} // load
+
+
+/**
+ * @brief Store the client's attributes as the peer's entry.
+ * @param [in] pClient The connected client.
+ * @param [in] hash The peer's Database Hash, nullptr if it has none.
+ * @details Erases the entries marked stale first, so they can't outlive this one.
+ * @return True if stored, false if there are more attributes than CONFIG_NIMBLE_CPP_GATT_CACHE_MAX_ATTRIBUTES
+ * or NVS failed.
+ */
+bool NimBLEGattCache::save(NimBLEClient* pClient, const uint8_t* hash) {
+#if defined(ESP_PLATFORM) && CONFIG_NIMBLE_CPP_GATT_CACHE_MAX_ATTRIBUTES > 0
+    erasePending();
+
+    std::vector<CacheEntry> entries;
+
+    for(auto &svc : pClient->m_servicesVector) {
+        CacheEntry entry = {};
+        entry.kind    = ENTRY_SERVICE;
+        entry.handle  = svc->getStartHandle();
+        entry.handle2 = svc->getEndHandle();
+        storeUUID(&entry, svc->getUUID());
+        entries.push_back(entry);
+
+        for(auto &chr : svc->m_characteristicVector) {
+            entry            = {};
+            entry.kind       = ENTRY_CHARACTERISTIC;
+            entry.properties = chr->m_charProp;
+            entry.handle     = chr->getHandle();
+            entry.handle2    = chr->getDefHandle();
+            entry.endHandle  = chr->m_endHandle;
+            storeUUID(&entry, chr->getUUID());
+            entries.push_back(entry);
+
+            for(auto &dsc : chr->m_descriptorVector) {
+                entry        = {};
+                entry.kind   = ENTRY_DESCRIPTOR;
+                entry.handle = dsc->getHandle();
+                storeUUID(&entry, dsc->getUUID());
+                entries.push_back(entry);
+            }
+        }
+    }
+
+    if(entries.size() > CONFIG_NIMBLE_CPP_GATT_CACHE_MAX_ATTRIBUTES) {
+        NIMBLE_LOGW(LOG_TAG, "%d attributes is more than the cache holds", entries.size());
+        return false;
+    }
+
+    CacheHeader header = {};
+    header.version = NIMBLE_CPP_GATT_CACHE_VERSION;
+    header.count   = (uint8_t)entries.size();
+    header.hasHash = hash != nullptr;
+    if(hash != nullptr) {
+        memcpy(header.hash, hash, NIMBLE_CPP_GATT_DB_HASH_LEN);
+    }
+
+    std::vector<uint8_t> blob(sizeof(header) + entries.size() * sizeof(CacheEntry));
+    memcpy(blob.data(), &header, sizeof(header));
+    if(!entries.empty()) {
+        memcpy(blob.data() + sizeof(header), entries.data(), entries.size() * sizeof(CacheEntry));
+    }
+
+    char key[16];
+    makeKey(pClient->getPeerAddress(), key, sizeof(key));
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(NIMBLE_CPP_GATT_CACHE_NAMESPACE, NVS_READWRITE, &nvs);
+    if(err == ESP_OK) {
+        err = nvs_set_blob(nvs, key, blob.data(), blob.size());
+        if(err == ESP_OK) {
+            err = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+
+    if(err != ESP_OK) {
+        NIMBLE_LOGE(LOG_TAG, "Could not store attributes; err=%d", err);
+        return false;
+    }
+
+    NIMBLE_LOGI(LOG_TAG, "Cached %d attributes of %s", entries.size(),
+                pClient->getPeerAddress().toString().c_str());
+    return true;
+#else
+    return false;
+#endif
+} // save
+
+
+/**
+ * @brief Erase a peer's entry, if it has one.
+ */
+void NimBLEGattCache::erase(const NimBLEAddress &address) {
+#if defined(ESP_PLATFORM) && CONFIG_NIMBLE_CPP_GATT_CACHE_MAX_ATTRIBUTES > 0
+    char key[16];
+    makeKey(address, key, sizeof(key));
+
+    nvs_handle_t nvs;
+    if(nvs_open(NIMBLE_CPP_GATT_CACHE_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        return;
+    }
+    if(nvs_erase_key(nvs, key) == ESP_OK) {
+        nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+#endif
+} // erase
+
+
+/**
+ * @brief Mark a peer's entry stale, for it to be erased from the application's task.
+ * @details Safe to call from the host task, it doesn't touch NVS.
+ */
+void NimBLEGattCache::markStale(const NimBLEAddress &address) {
+    uint32_t ctx = ble_npl_hw_enter_critical();
+    if(!staleOverflow) {
+        bool found = false;
+        for(uint8_t i = 0; i < staleCount && !found; i++) {
+            found = staleAddresses[i].type == address.getType() &&
+                    memcmp(staleAddresses[i].val, address.getNative(), 6) == 0;
+        }
+        if(!found && staleCount < NIMBLE_MAX_CONNECTIONS) {
+            staleAddresses[staleCount].type = address.getType();
+            memcpy(staleAddresses[staleCount].val, address.getNative(), 6);
+            staleCount++;
+        } else if(!found) {
+            staleOverflow = true;
+        }
+    }
+    ble_npl_hw_exit_critical(ctx);
+} // markStale
+
+
+/**
+ * @brief Check if a peer's entry is marked stale and not yet erased.
+ */
+bool NimBLEGattCache::isStale(const NimBLEAddress &address) {
+    uint32_t ctx = ble_npl_hw_enter_critical();
+    bool stale = staleOverflow;
+    for(uint8_t i = 0; i < staleCount && !stale; i++) {
+        stale = staleAddresses[i].type == address.getType() &&
+                memcmp(staleAddresses[i].val, address.getNative(), 6) == 0;
+    }
+    ble_npl_hw_exit_critical(ctx);
+    return stale;
+} // isStale
+
+
+/**
+ * @brief Erase the entries marked stale by Service Changed indications.
+ * @details Called by load() and save(), and can be called from the application's task to erase them sooner. Not to
+ * be called from the host task, it waits on NVS.
+ */
+void NimBLEGattCache::erasePending() {
+    uint32_t ctx = ble_npl_hw_enter_critical();
+    bool overflow = staleOverflow;
+    uint8_t count = staleCount;
+    ble_addr_t addresses[NIMBLE_MAX_CONNECTIONS];
+    memcpy(addresses, staleAddresses, count * sizeof(ble_addr_t));
+    ble_npl_hw_exit_critical(ctx);
+
+    if(!overflow && count == 0) {
+        return;
+    }
+
+#if defined(ESP_PLATFORM) && CONFIG_NIMBLE_CPP_GATT_CACHE_MAX_ATTRIBUTES > 0
+    if(overflow) {
+        nvs_handle_t nvs;
+        if(nvs_open(NIMBLE_CPP_GATT_CACHE_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK) {
+            if(nvs_erase_all(nvs) == ESP_OK) {
+                nvs_commit(nvs);
+            }
+            nvs_close(nvs);
+        }
+    } else {
+        for(uint8_t i = 0; i < count; i++) {
+            erase(NimBLEAddress(addresses[i]));
+        }
+    }
+#endif
+
+    // Only what was erased is unmarked, a peer marked meanwhile stays stale.
+    ctx = ble_npl_hw_enter_critical();
+    if(overflow) {
+        staleOverflow = false;
+        staleCount    = 0;
+    } else {
+        memmove(staleAddresses, staleAddresses + count, (staleCount - count) * sizeof(ble_addr_t));
+        staleCount -= count;
+    }
+    ble_npl_hw_exit_critical(ctx);
+} // erasePending
+
+#endif /* CONFIG_BT_ENABLED && CONFIG_BT_NIMBLE_ROLE_CENTRAL */
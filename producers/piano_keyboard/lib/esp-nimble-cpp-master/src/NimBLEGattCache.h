@@ -0,0 +1,64 @@
+/*
+ * NimBLEGattCache.h
+ *
+ *  Created: on October 17 2026
+ */
+
+#ifndef COMPONENTS_NIMBLE_GATT_CACHE_H_
+#define COMPONENTS_NIMBLE_GATT_CACHE_H_
+
+#include "nimconfig.h"
+#if defined(CONFIG_BT_ENABLED) && defined(CONFIG_BT_NIMBLE_ROLE_CENTRAL)
+
+#if defined(CONFIG_NIMBLE_CPP_IDF)
+#include "host/ble_hs.h"
+#else
+#include "nimble/nimble/host/include/host/ble_hs.h"
+#endif
+
+/****  FIX COMPILATION ****/
+#undef min
+#undef max
+/**************************/
+
+#include "NimBLEAddress.h"
+
+#if !defined(CONFIG_NIMBLE_CPP_GATT_CACHE_MAX_ATTRIBUTES)
+#    define CONFIG_NIMBLE_CPP_GATT_CACHE_MAX_ATTRIBUTES 32
+#elif CONFIG_NIMBLE_CPP_GATT_CACHE_MAX_ATTRIBUTES < 0 || CONFIG_NIMBLE_CPP_GATT_CACHE_MAX_ATTRIBUTES > 255
+#    error CONFIG_NIMBLE_CPP_GATT_CACHE_MAX_ATTRIBUTES must be 0 to 255
+#endif
+
+/** @brief The length of the Database Hash characteristic's value. */
+#define NIMBLE_CPP_GATT_DB_HASH_LEN 16
+
+class NimBLEClient;
+
+/**
+ * @brief Stores the attributes discovered on a peer in NVS, keyed by its address, to restore them on reconnect.
+ * @details A peer's attributes are valid as long as its Database Hash characteristic reads the same as when they were
+ * stored. For a peer without one, a bond with a subscription to Service Changed stands in: the server has to
+ * indicate it to a bonded client when its attributes change, which erases the entry. NimBLEClient subscribes before
+ * storing such a peer, and doesn't trust an entry without the characteristic. Only stored on ESP platforms,
+ * elsewhere nothing is cached.\n
+ * The indication arrives in the host task, which shouldn't wait on NVS, so it only marks the entry stale. Stale
+ * entries are erased by the next load() or save(), or by erasePending(), from the application's task, and load()
+ * refuses a stale entry until then.
+ */
+class NimBLEGattCache {
+public:
+    static int  readDatabaseHash(NimBLEClient* pClient, uint8_t* hash);
+    static bool load(NimBLEClient* pClient, const uint8_t* hash);
+    static bool save(NimBLEClient* pClient, const uint8_t* hash);
+    static void erase(const NimBLEAddress &address);
+    static void markStale(const NimBLEAddress &address);
+    static void erasePending();
+
+private:
+    static int  onHashReadCB(uint16_t conn_handle, const struct ble_gatt_error *error,
+                             struct ble_gatt_attr *attr, void *arg);
+    static bool isStale(const NimBLEAddress &address);
+};
+
+#endif /* CONFIG_BT_ENABLED && CONFIG_BT_NIMBLE_ROLE_CENTRAL */
+#endif /* COMPONENTS_NIMBLE_GATT_CACHE_H_ */
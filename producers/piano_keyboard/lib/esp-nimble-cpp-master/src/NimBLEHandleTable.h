@@ -0,0 +1,72 @@
+/*
+ * NimBLEHandleTable.h
+ *
+ *  Created: on October 17 2026
+ */
+
+#ifndef COMPONENTS_NIMBLE_HANDLE_TABLE_H_
+#define COMPONENTS_NIMBLE_HANDLE_TABLE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * @brief Flat table from attribute handle to attribute, for constant time lookups of a peer's attributes.
+ * @details Covers the handles from the lowest to the highest one stored, so it only suits the dense handle ranges
+ * of a real GATT database; reset() refuses spans larger than the given limit. The table does not own the
+ * attributes, and has no dependencies on the stack so that it also builds on a host.
+ */
+template<typename T>
+class NimBLEHandleTable {
+public:
+    /**
+     * @brief Empty the table and size it for a range of handles.
+     * @param [in] first The lowest handle that will be stored.
+     * @param [in] last The highest handle that will be stored.
+     * @param [in] maxSpan The largest number of entries to allocate.
+     * @return False, leaving the table empty, if the range is empty or spans more than maxSpan handles.
+     */
+    bool reset(uint16_t first, uint16_t last, size_t maxSpan) {
+        m_table.clear();
+        m_first = first;
+        if(first > last || (size_t)(last - first) + 1 > maxSpan) {
+            return false;
+        }
+
+        m_table.assign((size_t)(last - first) + 1, nullptr);
+        return true;
+    } // reset
+
+
+    /**
+     * @brief Store an attribute, its handle has to be in the range the table was reset for.
+     */
+    void set(uint16_t handle, T* attribute) {
+        m_table[handle - m_first] = attribute;
+    } // set
+
+
+    /**
+     * @brief Get the attribute with a handle.
+     * @return The attribute, or nullptr if there is none.
+     */
+    T* find(uint16_t handle) const {
+        size_t i = (size_t)(uint16_t)(handle - m_first);
+        return i < m_table.size() ? m_table[i] : nullptr;
+    } // find
+
+
+    /**
+     * @brief Remove everything and release the table.
+     */
+    void clear() {
+        std::vector<T*>().swap(m_table);
+    } // clear
+
+private:
+    std::vector<T*> m_table;
+    uint16_t        m_first = 0;
+};
+
+#endif /* COMPONENTS_NIMBLE_HANDLE_TABLE_H_ */
@@ -0,0 +1,71 @@
+/*
+ * NimBLELiteral.h
+ *
+ *  Created: on October 17 2026
+ */
+
+#ifndef COMPONENTS_NIMBLE_LITERAL_H_
+#define COMPONENTS_NIMBLE_LITERAL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Parsing of UUID and address strings at compile time.
+ * @details The functions are constexpr and take the string as an array, so a string of the wrong length does not
+ * match and a wrong character fails to compile when the result initializes a constexpr variable. Has no
+ * dependencies on the stack so that it also builds on a host.
+ */
+class NimBLELiteral {
+public:
+    /**
+     * @brief Get a byte of a UUID string of the form "0000180d-0000-1000-8000-00805f9b34fb".
+     * @param [in] uuid The UUID string.
+     * @param [in] index The byte to get, 0 is the least significant as in ble_uuid128_t.
+     * @return The byte.
+     */
+    static constexpr uint8_t uuidByte(const char (&uuid)[37], size_t index) {
+        return uuidDashes(uuid) ? hexByte(uuid, uuidOffset(15 - index)) : malformed();
+    }
+
+    /**
+     * @brief Get a byte of an address string of the form "a4:c1:38:5d:ef:16".
+     * @param [in] address The address string.
+     * @param [in] index The byte to get, 0 is the least significant as in ble_addr_t.
+     * @return The byte.
+     */
+    static constexpr uint8_t addressByte(const char (&address)[18], size_t index) {
+        return (5 - index == 0 || address[(5 - index) * 3 - 1] == ':') ? hexByte(address, (5 - index) * 3)
+                                                                         : malformed();
+    }
+
+private:
+    /**
+     * @brief Reached only for a malformed string, as a function that isn't constexpr it stops compilation.
+     */
+    static uint8_t malformed() { return 0; }
+
+    static constexpr uint8_t hexDigit(char c) {
+        return c >= '0' && c <= '9' ? c - '0' :
+               c >= 'a' && c <= 'f' ? c - 'a' + 10 :
+               c >= 'A' && c <= 'F' ? c - 'A' + 10 :
+               malformed();
+    }
+
+    static constexpr uint8_t hexByte(const char* s, size_t offset) {
+        return (uint8_t)(hexDigit(s[offset]) << 4 | hexDigit(s[offset + 1]));
+    }
+
+    /**
+     * @brief Get the position in a UUID string of the byte that is index bytes from the most significant.
+     */
+    static constexpr size_t uuidOffset(size_t index) {
+        return index * 2 + (index >= 4) + (index >= 6) + (index >= 8) + (index >= 10);
+    }
+
+    static constexpr bool uuidDashes(const char* uuid) {
+        return uuid[8] == '-' && uuid[13] == '-' && uuid[18] == '-' && uuid[23] == '-';
+    }
+};
+
+#endif /* COMPONENTS_NIMBLE_LITERAL_H_ */
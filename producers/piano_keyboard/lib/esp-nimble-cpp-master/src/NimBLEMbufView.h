@@ -0,0 +1,109 @@
+/*
+ * NimBLEMbufView.h
+ *
+ *  Created: on October 17 2026
+ */
+
+#ifndef COMPONENTS_NIMBLE_MBUF_VIEW_H_
+#define COMPONENTS_NIMBLE_MBUF_VIEW_H_
+
+#include "nimconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+
+#if defined(CONFIG_NIMBLE_CPP_IDF)
+#include "host/ble_hs.h"
+#else
+#include "nimble/nimble/host/include/host/ble_hs.h"
+#endif
+
+/****  FIX COMPILATION ****/
+#undef min
+#undef max
+/**************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief A read-only view of the data in a chain of mbufs, as the stack received it.
+ * @details Only valid for the duration of the callback it is passed to, the stack frees the chain afterwards.
+ * Data that arrived in one buffer can be read in place through data(), otherwise iterate over the segments or
+ * copy them out with copyTo().
+ */
+class NimBLEMbufView {
+friend class NimBLEClient;
+public:
+    /**
+     * @brief A contiguous part of the data.
+     */
+    struct Segment {
+        const uint8_t* data;
+        uint16_t       length;
+    };
+
+    /**
+     * @brief Iterates over the segments of the data, in order.
+     */
+    class Iterator {
+    friend class NimBLEMbufView;
+    public:
+        Segment   operator*()  const { return Segment{m_om->om_data, m_om->om_len}; }
+        Iterator& operator++()       { m_om = SLIST_NEXT(m_om, om_next); return *this; }
+        bool      operator==(const Iterator& other) const { return m_om == other.m_om; }
+        bool      operator!=(const Iterator& other) const { return m_om != other.m_om; }
+
+    private:
+        explicit Iterator(const os_mbuf* om) : m_om(om) {}
+        const os_mbuf* m_om;
+    };
+
+    /** @brief Gets the total length of the data in bytes */
+    size_t         size()         const { return OS_MBUF_PKTLEN(m_om); }
+
+    /** @brief Check if the data is held in a single buffer, and so can be read through data() */
+    bool           isContiguous() const { return SLIST_NEXT(m_om, om_next) == nullptr; }
+
+    /** @brief Gets the first segment of the data, which is all of it if isContiguous() */
+    const uint8_t* data()         const { return m_om->om_data; }
+
+    /** @brief Gets the length of the first segment in bytes */
+    size_t         dataLength()   const { return m_om->om_len; }
+
+    Iterator       begin()        const { return Iterator(m_om); }
+    Iterator       end()          const { return Iterator(nullptr); }
+
+    /**
+     * @brief Copy part of the data into a buffer.
+     * @param [in] buf The buffer to copy into.
+     * @param [in] offset The position in the data to start copying from.
+     * @param [in] length The maximum number of bytes to copy.
+     * @return The number of bytes copied, less than length if the data ends first.
+     */
+    size_t copyTo(uint8_t* buf, size_t offset, size_t length) const {
+        size_t copied = 0;
+        for(const os_mbuf* om = m_om; om != nullptr && copied < length; om = SLIST_NEXT(om, om_next)) {
+            if(offset >= om->om_len) {
+                offset -= om->om_len;
+                continue;
+            }
+
+            size_t chunk = om->om_len - offset;
+            if(chunk > length - copied) {
+                chunk = length - copied;
+            }
+            memcpy(buf + copied, om->om_data + offset, chunk);
+            copied += chunk;
+            offset = 0;
+        }
+        return copied;
+    } // copyTo
+
+private:
+    explicit NimBLEMbufView(const os_mbuf* om) : m_om(om) {}
+
+    const os_mbuf* m_om;
+};
+
+#endif /* CONFIG_BT_ENABLED */
+#endif /* COMPONENTS_NIMBLE_MBUF_VIEW_H_ */
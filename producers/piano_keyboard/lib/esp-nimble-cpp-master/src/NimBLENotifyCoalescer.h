@@ -0,0 +1,142 @@
+/*
+ * NimBLENotifyCoalescer.h
+ *
+ *  Created: on October 17 2026
+ */
+
+#ifndef COMPONENTS_NIMBLE_NOTIFY_COALESCER_H_
+#define COMPONENTS_NIMBLE_NOTIFY_COALESCER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+/**
+ * @brief Packs values into frames of several records, to send them in one notification.
+ * @details A frame is a sequence of records, each a length byte followed by that many bytes of value, so values of
+ * up to 255 bytes can be coalesced. The frame is sized to what one notification can carry. Not thread safe, and has
+ * no dependencies on the stack so that it also builds on a host.
+ */
+class NimBLENotifyCoalescer {
+public:
+    static const size_t MAX_RECORD_LENGTH = 255;
+
+    /**
+     * @brief Set the largest frame, the ATT MTU less 3 for a notification.
+     * @details Shrinking it below the frame held is left to the caller, who should take() the frame first and send
+     * it in pieces cut by fit().
+     */
+    void setCapacity(size_t capacity) {
+        m_capacity = capacity;
+        if(m_frame.size() < capacity) {
+            m_frame.resize(capacity);
+        }
+    } // setCapacity
+
+
+    /**
+     * @brief Check if a value can ever be sent in a frame.
+     */
+    bool accepts(size_t length) const {
+        return length <= MAX_RECORD_LENGTH && length + 1 <= m_capacity;
+    } // accepts
+
+
+    /**
+     * @brief Check if a value fits in what is left of the frame.
+     */
+    bool fits(size_t length) const {
+        return m_length + 1 + length <= m_capacity;
+    } // fits
+
+
+    /**
+     * @brief Check if no other record fits in the frame, not even an empty one.
+     */
+    bool full() const {
+        return m_length + 1 > m_capacity;
+    } // full
+
+
+    /**
+     * @brief Add a value to the frame as a record.
+     * @return False if it doesn't fit.
+     */
+    bool add(const uint8_t* value, size_t length) {
+        if(length > MAX_RECORD_LENGTH || !fits(length)) {
+            return false;
+        }
+
+        m_frame[m_length] = (uint8_t)length;
+        memcpy(&m_frame[m_length + 1], value, length);
+        m_length += 1 + length;
+        m_records++;
+        return true;
+    } // add
+
+
+    /**
+     * @brief Copy the frame out and start a new one.
+     * @param [in] buf Where to copy the frame, with room for the capacity.
+     * @return The length of the frame.
+     */
+    size_t take(uint8_t* buf) {
+        size_t length = m_length;
+        memcpy(buf, m_frame.data(), length);
+        m_length  = 0;
+        m_records = 0;
+        return length;
+    } // take
+
+
+    size_t length()  const { return m_length; }
+    size_t records() const { return m_records; }
+    bool   empty()   const { return m_records == 0; }
+
+
+    /**
+     * @brief Find how much of the start of a frame fits in a notification without cutting a record.
+     * @param [in] frame The frame, or what is left of it.
+     * @param [in] length The length of the frame.
+     * @param [in] capacity The largest notification, the ATT MTU less 3.
+     * @return The length of the whole records that fit, 0 if not even the first one does.
+     */
+    static size_t fit(const uint8_t* frame, size_t length, size_t capacity) {
+        size_t offset = 0;
+        while(offset < length && offset + 1 + frame[offset] <= capacity) {
+            offset += 1 + frame[offset];
+        }
+        return offset < length ? offset : length;
+    } // fit
+
+
+    /**
+     * @brief Read the next record of a received frame.
+     * @param [in] frame The frame.
+     * @param [in] length The length of the frame.
+     * @param [in,out] offset Where the record starts, 0 for the first. Moved to the next record.
+     * @param [out] value Set to the record's value.
+     * @param [out] valueLength Set to the length of the record's value.
+     * @return False at the end of the frame, or if the record is cut short.
+     */
+    static bool next(const uint8_t* frame, size_t length, size_t* offset,
+                     const uint8_t** value, size_t* valueLength) {
+        if(*offset >= length || *offset + 1 + frame[*offset] > length) {
+            return false;
+        }
+
+        *valueLength = frame[*offset];
+        *value       = frame + *offset + 1;
+        *offset     += 1 + *valueLength;
+        return true;
+    } // next
+
+private:
+    std::vector<uint8_t> m_frame;
+    size_t               m_capacity = 0;
+    size_t               m_length   = 0;
+    size_t               m_records  = 0;
+};
+
+#endif /* COMPONENTS_NIMBLE_NOTIFY_COALESCER_H_ */
@@ -58,6 +58,7 @@ static const char* LOG_TAG = "NimBLERemoteCharacteristic";
     m_charProp           = chr->properties;
     m_pRemoteService     = pRemoteService;
     m_notifyCallback     = nullptr;
+    m_notifyViewCallback = nullptr;
 
     NIMBLE_LOGD(LOG_TAG, "<< NimBLERemoteCharacteristic(): %s", m_uuid.toString().c_str());
  } // NimBLERemoteCharacteristic
@@ -595,18 +596,234 @@ int NimBLERemoteCharacteristic::onReadCB(uint16_t conn_handle,
 }
 
 
+/**
+ * @brief Read the value of the remote characteristic without waiting for it.
+ * @details Reads and writes queued with the async functions go out one after another in the order they were
+ * queued, each as soon as the one before completes, so a batch of them costs no task switches in between.
+ * Don't use the blocking functions on the same client while async operations are pending. Deleting the
+ * characteristic, as deleting or rediscovering the client's services does, completes its pending operations with
+ * BLE_HS_ENOENT from the deleting task.
+ * @param [in] onComplete Called from the host task with the value read and 0, or an empty value and the error.
+ * @return false if disconnected or the read could not be started, in which case onComplete is not called.
+ */
+bool NimBLERemoteCharacteristic::readValueAsync(read_complete_callback onComplete) {
+    return queueOp(m_handle, true, nullptr, 0, onComplete, nullptr);
+} // readValueAsync
+
+
+/**
+ * @brief Write the value of the remote characteristic with a response, without waiting for it.
+ * @details Queued as readValueAsync() is. Writes longer than the MTU allows are long writes.
+ * @param [in] data The data to write, which is copied.
+ * @param [in] length The length of the data in bytes.
+ * @param [in] onComplete Called from the host task with 0, or the error.
+ * @return false if disconnected or the write could not be started, in which case onComplete is not called.
+ */
+bool NimBLERemoteCharacteristic::writeValueAsync(const uint8_t* data, size_t length,
+                                                 write_complete_callback onComplete) {
+    return queueOp(m_handle, false, data, length, nullptr, onComplete);
+} // writeValueAsync
+
+
+/**
+ * @brief Subscribe for notifications or indications without waiting for the descriptor write.
+ * @details Queued as readValueAsync() is. The descriptors are retrieved first if they haven't been, which
+ * blocks. If the characteristic has no CCCD the callback is set and onComplete is called with 0 straight away,
+ * otherwise the callback is set once the write is queued, and left as it was if it isn't.
+ * @param [in] notifications If true, subscribe for notifications, false subscribe for indications.
+ * @param [in] notifyCallback A callback to be invoked for a notification.
+ * @param [in] onComplete Called from the host task with 0, or the error.
+ * @return false if disconnected or the write could not be started, in which case onComplete is not called.
+ */
+bool NimBLERemoteCharacteristic::subscribeAsync(bool notifications, notify_callback notifyCallback,
+                                                write_complete_callback onComplete) {
+    NimBLERemoteDescriptor* desc = getDescriptor(NimBLEUUID((uint16_t)0x2902));
+    if(desc == nullptr) {
+        NIMBLE_LOGW(LOG_TAG, "subscribeAsync(): Callback set, CCCD not found");
+        m_notifyCallback     = notifyCallback;
+        m_notifyViewCallback = nullptr;
+        if(onComplete != nullptr) {
+            onComplete(this, 0);
+        }
+        return true;
+    }
+
+    uint16_t val = notifications ? 0x01 : 0x02;
+    if(!queueOp(desc->getHandle(), false, (uint8_t*)&val, 2, nullptr, onComplete)) {
+        return false;
+    }
+
+    m_notifyCallback     = notifyCallback;
+    m_notifyViewCallback = nullptr;
+    return true;
+} // subscribeAsync
+
+
+/**
+ * @brief Create an asynchronous operation and queue it on the client.
+ * @param [in] handle The attribute handle to read or write.
+ * @param [in] read True to read, false to write data.
+ * @param [in] data The data to write.
+ * @param [in] length The length of the data in bytes.
+ * @param [in] onRead Called when a read completes.
+ * @param [in] onWrite Called when a write completes.
+ * @return false if the operation was not queued.
+ */
+bool NimBLERemoteCharacteristic::queueOp(uint16_t handle, bool read, const uint8_t* data, size_t length,
+                                         read_complete_callback onRead, write_complete_callback onWrite) {
+    NimBLEClient* pClient = getRemoteService()->getClient();
+
+    if (!pClient->isConnected()) {
+        NIMBLE_LOGE(LOG_TAG, "Disconnected");
+        return false;
+    }
+
+    if(length > BLE_ATT_ATTR_MAX_LEN) {
+        NIMBLE_LOGE(LOG_TAG, "Write of %u bytes exceeds the max", (unsigned)length);
+        return false;
+    }
+
+    NimBLEGattOp* op    = new NimBLEGattOp();
+    op->pClient         = pClient;
+    op->pCharacteristic = this;
+    op->completed       = false;
+    op->handle          = handle;
+    op->read            = read;
+    op->onRead          = onRead;
+    op->onWrite         = onWrite;
+    if(!read) {
+        op->value.setValue(data, length);
+    }
+
+    return pClient->queueGattOp(op);
+} // queueOp
+
+
+/**
+ * @brief Send the request of an asynchronous operation.
+ * @return 0 on success or the stack's error code.
+ */
+int NimBLERemoteCharacteristic::startOp(NimBLEGattOp* op) {
+    uint16_t conn_id = op->pClient->getConnId();
+
+    if(op->read) {
+        return ble_gattc_read_long(conn_id, op->handle, 0,
+                                   NimBLERemoteCharacteristic::onAsyncReadCB, op);
+    }
+
+    // Longer than we can write in one request, so it must be a long write.
+    if(op->value.size() > ble_att_mtu(conn_id) - 3) {
+        os_mbuf *om = ble_hs_mbuf_from_flat(op->value.data(), op->value.size());
+        return ble_gattc_write_long(conn_id, op->handle, 0, om,
+                                    NimBLERemoteCharacteristic::onAsyncWriteCB, op);
+    }
+
+    return ble_gattc_write_flat(conn_id, op->handle, op->value.data(), op->value.size(),
+                                NimBLERemoteCharacteristic::onAsyncWriteCB, op);
+} // startOp
+
+
+/**
+ * @brief Report the result of an asynchronous operation, storing the value of a successful read.
+ */
+void NimBLERemoteCharacteristic::completeOp(NimBLEGattOp* op, int rc) {
+    NimBLERemoteCharacteristic* characteristic = op->pCharacteristic;
+
+    if(op->read) {
+        if(rc == 0) {
+            op->value.setTimeStamp();
+            characteristic->m_value = op->value;
+            if(op->onRead != nullptr) {
+                op->onRead(characteristic, op->value, rc);
+            }
+        } else if(op->onRead != nullptr) {
+            // A read cancelled while in progress may still be receiving into its own value.
+            op->onRead(characteristic, NimBLEAttValue(), rc);
+        }
+    } else if(op->onWrite != nullptr) {
+        op->onWrite(characteristic, rc);
+    }
+} // completeOp
+
+
+/**
+ * @brief Callback for an asynchronous read, once per part of a long read and once at the end.
+ * @return success == 0 or error code.
+ */
+int NimBLERemoteCharacteristic::onAsyncReadCB(uint16_t conn_handle,
+                const struct ble_gatt_error *error,
+                struct ble_gatt_attr *attr, void *arg)
+{
+    NimBLEGattOp* op = (NimBLEGattOp*)arg;
+    int rc = error->status;
+
+    if(rc == 0 && attr) {
+        uint16_t data_len = OS_MBUF_PKTLEN(attr->om);
+        if((op->value.size() + data_len) > BLE_ATT_ATTR_MAX_LEN) {
+            rc = BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        } else {
+            op->value.append(attr->om->om_data, data_len);
+            return 0;
+        }
+    }
+
+    // Not long-readable is not an error, the first part is all there is.
+    if(rc == BLE_HS_EDONE || rc == BLE_HS_ATT_ERR(BLE_ATT_ERR_ATTR_NOT_LONG)) {
+        rc = 0;
+    }
+
+    NIMBLE_LOGD(LOG_TAG, "Async read complete; rc=%d conn_handle=%d", rc, conn_handle);
+
+    // The characteristic may have been deleted and the operation reported, see NimBLEClient::cancelGattOps().
+    NimBLEClient* pClient = op->pClient;
+    if(pClient->claimGattOp(op)) {
+        completeOp(op, rc);
+    }
+    pClient->nextGattOp();
+
+    // Anything but 0 ends the procedure without another callback.
+    return rc;
+} // onAsyncReadCB
+
+
+/**
+ * @brief Callback for an asynchronous write.
+ * @return success == 0 or error code.
+ */
+int NimBLERemoteCharacteristic::onAsyncWriteCB(uint16_t conn_handle,
+                const struct ble_gatt_error *error,
+                struct ble_gatt_attr *attr, void *arg)
+{
+    NimBLEGattOp* op = (NimBLEGattOp*)arg;
+
+    NIMBLE_LOGD(LOG_TAG, "Async write complete; status=%d conn_handle=%d", error->status, conn_handle);
+
+    NimBLEClient* pClient = op->pClient;
+    if(pClient->claimGattOp(op)) {
+        completeOp(op, error->status);
+    }
+    pClient->nextGattOp();
+
+    return 0;
+} // onAsyncWriteCB
+
+
 /**
  * @brief Subscribe or unsubscribe for notifications or indications.
  * @param [in] val 0x00 to unsubscribe, 0x01 for notifications, 0x02 for indications.
  * @param [in] notifyCallback A callback to be invoked for a notification.
  * @param [in] response If write response required set this to true.
  * If NULL is provided then no callback is performed.
+ * @param [in] notifyViewCallback A callback to be invoked for a notification with a view of the received data,
+ * instead of notifyCallback and without storing the value.
  * @return false if writing to the descriptor failed.
  */
-bool NimBLERemoteCharacteristic::setNotify(uint16_t val, notify_callback notifyCallback, bool response) {
+bool NimBLERemoteCharacteristic::setNotify(uint16_t val, notify_callback notifyCallback, bool response,
+                                           notify_view_callback notifyViewCallback) {
     NIMBLE_LOGD(LOG_TAG, ">> setNotify(): %s, %02x", toString().c_str(), val);
 
-    m_notifyCallback = notifyCallback;
+    m_notifyCallback     = notifyCallback;
+    m_notifyViewCallback = notifyViewCallback;
 
     NimBLERemoteDescriptor* desc = getDescriptor(NimBLEUUID((uint16_t)0x2902));
     if(desc == nullptr) {
@@ -638,6 +855,22 @@ bool NimBLERemoteCharacteristic::subscribe(bool notifications, notify_callback n
 } // subscribe
 
 
+/**
+ * @brief Subscribe for notifications or indications, receiving them without a copy.
+ * @details The callback is given a view of the buffers the stack received the value in, which is only valid until
+ * it returns. The value is not stored, so getValue() and the value timestamp are not updated by these
+ * notifications. Calling subscribe() or unsubscribe() returns to the copying callback.
+ * @param [in] notifications If true, subscribe for notifications, false subscribe for indications.
+ * @param [in] notifyCallback A callback to be invoked for a notification.
+ * @param [in] response If true, require a write response from the descriptor write operation.
+ * @return false if writing to the descriptor failed.
+ */
+bool NimBLERemoteCharacteristic::subscribeView(bool notifications, notify_view_callback notifyCallback,
+                                               bool response) {
+    return setNotify(notifications ? 0x01 : 0x02, nullptr, response, notifyCallback);
+} // subscribeView
+
+
 /**
  * @brief Unsubscribe for notifications or indications.
  * @param [in] response bool if true, require a write response from the descriptor write operation.
@@ -20,11 +20,13 @@
 
 #include "NimBLERemoteService.h"
 #include "NimBLERemoteDescriptor.h"
+#include "NimBLEMbufView.h"
 
 #include <vector>
 #include <functional>
 #include "NimBLELog.h"
 
+class NimBLEClient;
 class NimBLERemoteService;
 class NimBLERemoteDescriptor;
 
@@ -32,6 +34,29 @@ class NimBLERemoteDescriptor;
 typedef std::function<void (NimBLERemoteCharacteristic* pBLERemoteCharacteristic,
                                 uint8_t* pData, size_t length, bool isNotify)> notify_callback;
 
+typedef std::function<void (NimBLERemoteCharacteristic* pBLERemoteCharacteristic,
+                                const NimBLEMbufView& data, bool isNotify)> notify_view_callback;
+
+typedef std::function<void (NimBLERemoteCharacteristic* pBLERemoteCharacteristic,
+                                const NimBLEAttValue& value, int rc)> read_complete_callback;
+
+typedef std::function<void (NimBLERemoteCharacteristic* pBLERemoteCharacteristic, int rc)> write_complete_callback;
+
+/**
+ * @brief An asynchronous read or write, queued on the client until the operations before it complete.
+ */
+struct NimBLEGattOp {
+    NimBLEClient*               pClient;
+    NimBLERemoteCharacteristic* pCharacteristic;
+    uint16_t                    handle;  // the characteristic value's, or a descriptor's
+    bool                        read;
+    NimBLEAttValue              value;   // read into, or written from
+    read_complete_callback      onRead;
+    write_complete_callback     onWrite;
+    bool                        completed; // reported to the callback, which happens only once
+    NimBLEGattOp*               next;
+};
+
 typedef struct {
     const NimBLEUUID *uuid;
     void *task_data;
@@ -74,7 +99,16 @@ public:
     bool                                           subscribe(bool notifications = true,
                                                              notify_callback notifyCallback = nullptr,
                                                              bool response = true);
+    bool                                           subscribeView(bool notifications = true,
+                                                                 notify_view_callback notifyCallback = nullptr,
+                                                                 bool response = true);
     bool                                           unsubscribe(bool response = true);
+    bool                                           readValueAsync(read_complete_callback onComplete);
+    bool                                           writeValueAsync(const uint8_t* data, size_t length,
+                                                                   write_complete_callback onComplete = nullptr);
+    bool                                           subscribeAsync(bool notifications = true,
+                                                                  notify_callback notifyCallback = nullptr,
+                                                                  write_complete_callback onComplete = nullptr);
     bool                                           registerForNotify(notify_callback notifyCallback,
                                                                      bool notifications = true,
                                                                      bool response = true)
@@ -158,10 +192,20 @@ private:
     friend class      NimBLEClient;
     friend class      NimBLERemoteService;
     friend class      NimBLERemoteDescriptor;
+    friend class      NimBLEGattCache;
 
     // Private member functions
-    bool              setNotify(uint16_t val, notify_callback notifyCallback = nullptr, bool response = true);
+    bool              setNotify(uint16_t val, notify_callback notifyCallback = nullptr, bool response = true,
+                                notify_view_callback notifyViewCallback = nullptr);
     bool              retrieveDescriptors(const NimBLEUUID *uuid_filter = nullptr);
+    bool              queueOp(uint16_t handle, bool read, const uint8_t* data, size_t length,
+                              read_complete_callback onRead, write_complete_callback onWrite);
+    static int        startOp(NimBLEGattOp* op);
+    static void       completeOp(NimBLEGattOp* op, int rc);
+    static int        onAsyncReadCB(uint16_t conn_handle, const struct ble_gatt_error *error,
+                                    struct ble_gatt_attr *attr, void *arg);
+    static int        onAsyncWriteCB(uint16_t conn_handle, const struct ble_gatt_error *error,
+                                     struct ble_gatt_attr *attr, void *arg);
     static int        onReadCB(uint16_t conn_handle, const struct ble_gatt_error *error,
                                struct ble_gatt_attr *attr, void *arg);
     static int        onWriteCB(uint16_t conn_handle, const struct ble_gatt_error *error,
@@ -181,6 +225,7 @@ private:
     NimBLERemoteService*    m_pRemoteService;
     NimBLEAttValue          m_value;
     notify_callback         m_notifyCallback;
+    notify_view_callback    m_notifyViewCallback;
 
     // We maintain a vector of descriptors owned by this characteristic.
     std::vector<NimBLERemoteDescriptor*> m_descriptorVector;
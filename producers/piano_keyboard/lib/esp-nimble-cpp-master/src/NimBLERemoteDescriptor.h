@@ -91,6 +91,7 @@ public:
 
 private:
     friend class                NimBLERemoteCharacteristic;
+    friend class                NimBLEGattCache;
 
     NimBLERemoteDescriptor      (NimBLERemoteCharacteristic* pRemoteCharacteristic,
                                 const struct ble_gatt_dsc *dsc);
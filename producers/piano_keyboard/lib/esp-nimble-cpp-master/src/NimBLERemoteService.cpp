@@ -187,6 +187,7 @@ int NimBLERemoteService::characteristicDiscCB(uint16_t conn_handle,
         // Found a service - add it to the vector
         NimBLERemoteCharacteristic* pRemoteCharacteristic = new NimBLERemoteCharacteristic(service, chr);
         service->m_characteristicVector.push_back(pRemoteCharacteristic);
+        service->m_pClient->invalidateHandleTable();
         return 0;
     }
 
@@ -353,10 +354,13 @@ bool NimBLERemoteService::setValue(const NimBLEUUID &characteristicUuid, const s
  */
 void NimBLERemoteService::deleteCharacteristics() {
     NIMBLE_LOGD(LOG_TAG, ">> deleteCharacteristics");
+    m_pClient->cancelGattOps(this);
+
     for(auto &it: m_characteristicVector) {
         delete it;
     }
     m_characteristicVector.clear();
+    m_pClient->invalidateHandleTable();
     NIMBLE_LOGD(LOG_TAG, "<< deleteCharacteristics");
 } // deleteCharacteristics
 
@@ -373,6 +377,7 @@ size_t NimBLERemoteService::deleteCharacteristic(const NimBLEUUID &uuid) {
         if((*it)->getUUID() == uuid) {
             delete *it;
             m_characteristicVector.erase(it);
+            m_pClient->invalidateHandleTable();
             break;
         }
     }
@@ -58,6 +58,7 @@ private:
     // Friends
     friend class NimBLEClient;
     friend class NimBLERemoteCharacteristic;
+    friend class NimBLEGattCache;
 
     // Private methods
     bool                retrieveCharacteristics(const NimBLEUUID *uuid_filter = nullptr);
@@ -21,6 +21,8 @@
 
 #include <string>
 #include <climits>
+#include <algorithm>
+#include <string.h>
 
 static const char* LOG_TAG = "NimBLEScan";
 
@@ -84,35 +86,75 @@ NimBLEScan::~NimBLEScan() {
                 return 0;
             }
 
-            NimBLEAdvertisedDevice* advertisedDevice = nullptr;
-
-            // If we've seen this device before get a pointer to it from the vector
-            for(auto &it: pScan->m_scanResults.m_advertisedDevicesVector) {
+            // If we've seen this device before get a pointer to it from the index.
 #if CONFIG_BT_NIMBLE_EXT_ADV
-                // Same address but different set ID should create a new advertised device.
-                if (it->getAddress() == advertisedAddress && it->getSetId() == disc.sid) {
+            // Same address but different set ID should create a new advertised device.
+            const uint8_t setId = disc.sid;
 #else
-                if (it->getAddress() == advertisedAddress) {
+            const uint8_t setId = 0;
 #endif
-                    advertisedDevice = it;
-                    break;
-                }
-            }
+            uint64_t indexKey = NimBLEScanIndex::makeKey(advertisedAddress.getNative(), setId);
+            NimBLEAdvertisedDevice* advertisedDevice = pScan->m_scanResults.m_advertisedDevicesIndex.find(indexKey);
+            const bool isScanRsp = isLegacyAdv && event_type == BLE_HCI_ADV_RPT_EVTYPE_SCAN_RSP;
+
+            // A scannable advertisement held back by the filter, now that its scan response is here.
+            NimBLEScanPending::Entry* pending = nullptr;
 
             // If we haven't seen this device before; create a new instance and insert it in the vector.
             // Otherwise just update the relevant parameters of the already known device.
-            if (advertisedDevice == nullptr &&
-                (!isLegacyAdv || event_type != BLE_HCI_ADV_RPT_EVTYPE_SCAN_RSP)) {
+            if (advertisedDevice == nullptr) {
+                if (isScanRsp) {
+                    pending = pScan->m_pending.find(disc.addr.val, disc.addr.type, setId);
+                    if (pending == nullptr) {
+                        // Scan response from unknown device
+                        return 0;
+                    }
+
+                    uint8_t combined[NIMBLE_CPP_LEGACY_ADV_DATA_LEN * 2];
+                    uint8_t rspLength = std::min<uint8_t>(disc.length_data, NIMBLE_CPP_LEGACY_ADV_DATA_LEN);
+                    memcpy(combined, pending->data, pending->length);
+                    memcpy(combined + pending->length, disc.data, rspLength);
+                    if (!pScan->m_filter.matches(combined, pending->length + rspLength, disc.rssi)) {
+                        NIMBLE_LOGI(LOG_TAG, "Filtered out on scan response: %s",
+                                    advertisedAddress.toString().c_str());
+                        pScan->m_pending.release(pending);
+                        return 0;
+                    }
+                } else if (!pScan->m_filter.matches(disc.data, disc.length_data, disc.rssi)) {
+                    // Reports from devices we haven't seen are checked against the filter before anything is
+                    // allocated for them. What the filter looks for may be in the scan response instead, so when
+                    // scanning actively a scannable advertisement is held until it can be checked with its scan
+                    // response, unless it already fails on what a scan response can't change.
+                    if (pScan->m_scan_params.passive || !isLegacyAdv ||
+                       (event_type != BLE_HCI_ADV_RPT_EVTYPE_ADV_IND &&
+                        event_type != BLE_HCI_ADV_RPT_EVTYPE_SCAN_IND) ||
+                       !pScan->m_filter.matchesRSSI(disc.rssi)) {
+                        return 0;
+                    }
+                    pScan->m_pending.hold(disc.addr.val, disc.addr.type, setId, event_type,
+                                          disc.data, disc.length_data);
+                    return 0;
+                }
+
                 // Check if we have reach the scan results limit, ignore this one if so.
                 // We still need to store each device when maxResults is 0 to be able to append the scan results
                 if (pScan->m_maxResults > 0 && pScan->m_maxResults < 0xFF &&
                    (pScan->m_scanResults.m_advertisedDevicesVector.size() >= pScan->m_maxResults)) {
+                    if (pending != nullptr) {
+                        pScan->m_pending.release(pending);
+                    }
                     return 0;
                 }
 
                 advertisedDevice = new NimBLEAdvertisedDevice();
                 advertisedDevice->setAddress(advertisedAddress);
-                advertisedDevice->setAdvType(event_type, isLegacyAdv);
+                if (pending != nullptr) {
+                    advertisedDevice->setAdvType(pending->advType, isLegacyAdv);
+                    advertisedDevice->setPayload(pending->data, pending->length, false);
+                    pScan->m_pending.release(pending);
+                } else {
+                    advertisedDevice->setAdvType(event_type, isLegacyAdv);
+                }
 #if CONFIG_BT_NIMBLE_EXT_ADV
                 advertisedDevice->setSetId(disc.sid);
                 advertisedDevice->setPrimaryPhy(disc.prim_phy);
@@ -120,18 +162,15 @@ NimBLEScan::~NimBLEScan() {
                 advertisedDevice->setPeriodicInterval(disc.periodic_adv_itvl);
 #endif
                 pScan->m_scanResults.m_advertisedDevicesVector.push_back(advertisedDevice);
+                pScan->m_scanResults.m_advertisedDevicesIndex.insert(indexKey, advertisedDevice);
                 NIMBLE_LOGI(LOG_TAG, "New advertiser: %s", advertisedAddress.toString().c_str());
-            } else if (advertisedDevice != nullptr) {
-                NIMBLE_LOGI(LOG_TAG, "Updated advertiser: %s", advertisedAddress.toString().c_str());
             } else {
-                // Scan response from unknown device
-                return 0;
+                NIMBLE_LOGI(LOG_TAG, "Updated advertiser: %s", advertisedAddress.toString().c_str());
             }
 
             advertisedDevice->m_timestamp = time(nullptr);
             advertisedDevice->setRSSI(disc.rssi);
-            advertisedDevice->setPayload(disc.data, disc.length_data, (isLegacyAdv &&
-                                         event_type == BLE_HCI_ADV_RPT_EVTYPE_SCAN_RSP));
+            advertisedDevice->setPayload(disc.data, disc.length_data, isScanRsp);
 
             if (pScan->m_pAdvertisedDeviceCallbacks) {
                 // If not active scanning or scan response is not available
@@ -160,6 +199,9 @@ NimBLEScan::~NimBLEScan() {
             NIMBLE_LOGD(LOG_TAG, "discovery complete; reason=%d",
                         event->disc_complete.reason);
 
+            // Advertisements held for a scan response that never came didn't pass the filter.
+            pScan->m_pending.clear();
+
             // If a device advertised with scan reponse available and it was not received
             // the callback would not have been invoked, so do it here.
             if(pScan->m_pAdvertisedDeviceCallbacks) {
@@ -247,6 +289,29 @@ void NimBLEScan::setFilterPolicy(uint8_t filter) {
 } // setFilterPolicy
 
 
+/**
+ * @brief Set a filter that advertising reports have to pass for a device to be created for them.
+ * @param [in] filter The filter, which is copied.
+ * @details Reports are checked on their raw data as they arrive, so reports that don't pass cost no allocations
+ * and never reach the callbacks or the results. With active scanning, a scannable advertisement that only fails on
+ * what its scan response may carry is held in a table of CONFIG_NIMBLE_CPP_SCAN_PENDING_SIZE entries, and a device
+ * is only created if the advertisement and the scan response together pass.
+ * This is on top of the controller's filter policy.\n
+ * Should not be called while a scan is in progress.
+ */
+void NimBLEScan::setFilter(const NimBLEScanFilter &filter) {
+    m_filter = filter;
+} // setFilter
+
+
+/**
+ * @brief Remove the filter set with setFilter(), after which every report creates a device.
+ */
+void NimBLEScan::clearFilter() {
+    m_filter.clear();
+} // clearFilter
+
+
 /**
  * @brief Sets the max number of results to store.
  * @param [in] maxResults The number of results to limit storage to\n
@@ -427,6 +492,7 @@ bool NimBLEScan::stop() {
         return false;
     }
 
+    m_pending.clear();
     if(m_maxResults == 0) {
         clearResults();
     }
@@ -464,6 +530,11 @@ void NimBLEScan::erase(const NimBLEAddress &address) {
 
     for(auto it = m_scanResults.m_advertisedDevicesVector.begin(); it != m_scanResults.m_advertisedDevicesVector.end(); ++it) {
         if((*it)->getAddress() == address) {
+#if CONFIG_BT_NIMBLE_EXT_ADV
+            m_scanResults.m_advertisedDevicesIndex.erase(NimBLEScanIndex::makeKey(address.getNative(), (*it)->getSetId()));
+#else
+            m_scanResults.m_advertisedDevicesIndex.erase(NimBLEScanIndex::makeKey(address.getNative()));
+#endif
             delete *it;
             m_scanResults.m_advertisedDevicesVector.erase(it);
             break;
@@ -509,6 +580,8 @@ void NimBLEScan::clearResults() {
         delete it;
     }
     m_scanResults.m_advertisedDevicesVector.clear();
+    m_scanResults.m_advertisedDevicesIndex.clear();
+    m_pending.clear();
     clearDuplicateCache();
 }
 
@@ -569,6 +642,10 @@ std::vector<NimBLEAdvertisedDevice*>::iterator NimBLEScanResults::end() {
  * @return A pointer to the device at the specified address.
  */
 NimBLEAdvertisedDevice *NimBLEScanResults::getDevice(const NimBLEAddress &address) {
+#if !CONFIG_BT_NIMBLE_EXT_ADV
+    return m_advertisedDevicesIndex.find(NimBLEScanIndex::makeKey(address.getNative()));
+#else
+    // Any set ID will do, so this has to look through them all.
     for(size_t index = 0; index < m_advertisedDevicesVector.size(); index++) {
         if(m_advertisedDevicesVector[index]->getAddress() == address) {
             return m_advertisedDevicesVector[index];
@@ -576,6 +653,7 @@ NimBLEAdvertisedDevice *NimBLEScanResults::getDevice(const NimBLEAddress &addres
     }
 
     return nullptr;
+#endif
 }
 
 #endif /* CONFIG_BT_ENABLED && CONFIG_BT_NIMBLE_ROLE_OBSERVER */
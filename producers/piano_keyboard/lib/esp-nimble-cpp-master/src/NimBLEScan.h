@@ -18,6 +18,9 @@
 #if defined(CONFIG_BT_ENABLED) && defined(CONFIG_BT_NIMBLE_ROLE_OBSERVER)
 
 #include "NimBLEAdvertisedDevice.h"
+#include "NimBLEScanFilter.h"
+#include "NimBLEScanIndex.h"
+#include "NimBLEScanPending.h"
 #include "NimBLEUtils.h"
 
 #if defined(CONFIG_NIMBLE_CPP_IDF)
@@ -53,6 +56,7 @@ public:
 private:
     friend NimBLEScan;
     std::vector<NimBLEAdvertisedDevice*> m_advertisedDevicesVector;
+    NimBLEScanIndex                      m_advertisedDevicesIndex;
 };
 
 /**
@@ -72,6 +76,8 @@ public:
     void                setDuplicateFilter(bool enabled);
     void                setLimitedOnly(bool enabled);
     void                setFilterPolicy(uint8_t filter);
+    void                setFilter(const NimBLEScanFilter &filter);
+    void                clearFilter();
     void                clearDuplicateCache();
     bool                stop();
     void                clearResults();
@@ -97,6 +103,8 @@ private:
     uint32_t                            m_duration;
     ble_task_data_t                     *m_pTaskData;
     uint8_t                             m_maxResults;
+    NimBLEScanFilter                    m_filter;
+    NimBLEScanPending                   m_pending;
 };
 
 #endif /* CONFIG_BT_ENABLED CONFIG_BT_NIMBLE_ROLE_OBSERVER */
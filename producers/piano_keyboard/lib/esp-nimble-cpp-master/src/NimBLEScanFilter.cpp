@@ -0,0 +1,186 @@
+/*
+ * NimBLEScanFilter.cpp
+ *
+ *  Created: on October 17 2026
+ */
+
+#include "nimconfig.h"
+#if defined(CONFIG_BT_ENABLED) && defined(CONFIG_BT_NIMBLE_ROLE_OBSERVER)
+
+#include "NimBLEScanFilter.h"
+
+#if defined(CONFIG_NIMBLE_CPP_IDF)
+#include "host/ble_hs_adv.h"
+#else
+#include "nimble/nimble/host/include/host/ble_hs_adv.h"
+#endif
+
+#include <string.h>
+
+// The Bluetooth base UUID, little endian, that 16 and 32 bit UUIDs fill the upper 4 bytes of.
+static const uint8_t baseUUID[12] = {0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00};
+
+
+/**
+ * @brief Pass reports that advertise this service, or any other one that was added.
+ * @param [in] uuid The service UUID, of any size.
+ */
+void NimBLEScanFilter::addServiceUUID(const NimBLEUUID &uuid) {
+    NimBLEUUID uuid128 = uuid;
+    uuid128.to128();
+
+    std::array<uint8_t, 16> value;
+    memcpy(value.data(), uuid128.getNative()->u128.value, 16);
+    m_serviceUUIDs.push_back(value);
+} // addServiceUUID
+
+
+/**
+ * @brief Pass reports with manufacturer data from this company, or any other one that was added.
+ * @param [in] companyId The Bluetooth SIG company identifier, the first 2 bytes of the manufacturer data.
+ */
+void NimBLEScanFilter::addManufacturerId(uint16_t companyId) {
+    m_companyIds.push_back(companyId);
+} // addManufacturerId
+
+
+/**
+ * @brief Pass reports with a complete or shortened name that starts with this.
+ * @param [in] prefix The start of the name, an empty string removes the condition.
+ */
+void NimBLEScanFilter::setNamePrefix(const std::string &prefix) {
+    m_namePrefix = prefix;
+} // setNamePrefix
+
+
+/**
+ * @brief Pass only reports received at this signal strength or stronger.
+ * @param [in] rssi The minimum RSSI in dBm.
+ */
+void NimBLEScanFilter::setMinRSSI(int8_t rssi) {
+    m_minRSSI = rssi;
+} // setMinRSSI
+
+
+/**
+ * @brief Remove all conditions, after which everything passes.
+ */
+void NimBLEScanFilter::clear() {
+    m_serviceUUIDs.clear();
+    m_companyIds.clear();
+    m_namePrefix.clear();
+    m_minRSSI = -128;
+} // clear
+
+
+/**
+ * @brief Check a service UUID from a report against the ones the filter passes.
+ * @param [in] uuid The UUID as it is in the report, little endian.
+ * @param [in] size The size of the UUID in bytes, 2, 4 or 16.
+ */
+bool NimBLEScanFilter::matchesServiceUUID(const uint8_t *uuid, uint8_t size) const {
+    for(auto &it : m_serviceUUIDs) {
+        if(size == 16) {
+            if(memcmp(it.data(), uuid, 16) == 0) {
+                return true;
+            }
+        } else if(memcmp(it.data(), baseUUID, 12) == 0 &&
+                  memcmp(it.data() + 12, uuid, size) == 0 &&
+                  (size == 4 || (it[14] == 0 && it[15] == 0))) {
+            return true;
+        }
+    }
+
+    return false;
+} // matchesServiceUUID
+
+
+/**
+ * @brief Check whether a report passes the filter, from its raw data.
+ * @param [in] payload The advertisement data of the report.
+ * @param [in] length The length of the data in bytes.
+ * @param [in] rssi The signal strength the report was received at.
+ * @return True if the report passes.
+ */
+bool NimBLEScanFilter::matches(const uint8_t *payload, uint8_t length, int8_t rssi) const {
+    if(!matchesRSSI(rssi)) {
+        return false;
+    }
+
+    bool serviceMatch = m_serviceUUIDs.empty();
+    bool companyMatch = m_companyIds.empty();
+    bool nameMatch    = m_namePrefix.empty();
+    if(serviceMatch && companyMatch && nameMatch) {
+        return true;
+    }
+
+    size_t pos = 0;
+    while(pos + 1 < length) {
+        uint8_t fieldLength = payload[pos];
+        if(fieldLength == 0 || pos + 1 + fieldLength > length) {
+            break;
+        }
+
+        uint8_t        type    = payload[pos + 1];
+        const uint8_t *value   = payload + pos + 2;
+        uint8_t        valueLength = fieldLength - 1;
+
+        switch(type) {
+            case BLE_HS_ADV_TYPE_INCOMP_UUIDS16:
+            case BLE_HS_ADV_TYPE_COMP_UUIDS16:
+            case BLE_HS_ADV_TYPE_INCOMP_UUIDS32:
+            case BLE_HS_ADV_TYPE_COMP_UUIDS32:
+            case BLE_HS_ADV_TYPE_INCOMP_UUIDS128:
+            case BLE_HS_ADV_TYPE_COMP_UUIDS128: {
+                uint8_t size = type < BLE_HS_ADV_TYPE_INCOMP_UUIDS32 ? 2 :
+                               type < BLE_HS_ADV_TYPE_INCOMP_UUIDS128 ? 4 : 16;
+                for(uint8_t i = 0; !serviceMatch && i + size <= valueLength; i += size) {
+                    serviceMatch = matchesServiceUUID(value + i, size);
+                }
+                break;
+            }
+
+            case BLE_HS_ADV_TYPE_MFG_DATA:
+                if(!companyMatch && valueLength >= 2) {
+                    uint16_t companyId = value[0] | value[1] << 8;
+                    for(auto &it : m_companyIds) {
+                        if(it == companyId) {
+                            companyMatch = true;
+                            break;
+                        }
+                    }
+                }
+                break;
+
+            case BLE_HS_ADV_TYPE_COMP_NAME:
+            case BLE_HS_ADV_TYPE_INCOMP_NAME:
+                if(!nameMatch && valueLength >= m_namePrefix.length()) {
+                    nameMatch = memcmp(value, m_namePrefix.data(), m_namePrefix.length()) == 0;
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        if(serviceMatch && companyMatch && nameMatch) {
+            return true;
+        }
+
+        pos += 1 + fieldLength;
+    }
+
+    return false;
+} // matches
+
+
+/**
+ * @brief Check the part of the filter a scan response can't change.
+ * @param [in] rssi The signal strength the report was received at.
+ * @return True if the RSSI is at least the minimum.
+ */
+bool NimBLEScanFilter::matchesRSSI(int8_t rssi) const {
+    return rssi >= m_minRSSI;
+} // matchesRSSI
+
+#endif /* CONFIG_BT_ENABLED CONFIG_BT_NIMBLE_ROLE_OBSERVER */
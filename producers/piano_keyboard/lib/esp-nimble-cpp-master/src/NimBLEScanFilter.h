@@ -0,0 +1,48 @@
+/*
+ * NimBLEScanFilter.h
+ *
+ *  Created: on October 17 2026
+ */
+
+#ifndef COMPONENTS_NIMBLE_SCAN_FILTER_H_
+#define COMPONENTS_NIMBLE_SCAN_FILTER_H_
+
+#include "nimconfig.h"
+#if defined(CONFIG_BT_ENABLED) && defined(CONFIG_BT_NIMBLE_ROLE_OBSERVER)
+
+#include "NimBLEUUID.h"
+
+#include <array>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A filter applied to the raw data of advertising reports before a device is created for them.
+ * @details A report passes if its RSSI is at least the minimum, and, for each of the service UUIDs, manufacturer
+ * IDs and name prefix that are set, it advertises one of them. A filter with nothing set passes everything.\n
+ * The filter only decides whether a device is created: the scan response of a device that passed is added to it
+ * without being filtered. When scanning actively, a scannable advertisement with a high enough RSSI that doesn't
+ * pass is held, without a device, until its scan response arrives, and a device is created only if the
+ * advertisement and the scan response together pass.
+ */
+class NimBLEScanFilter {
+public:
+    void        addServiceUUID(const NimBLEUUID &uuid);
+    void        addManufacturerId(uint16_t companyId);
+    void        setNamePrefix(const std::string &prefix);
+    void        setMinRSSI(int8_t rssi);
+    void        clear();
+    bool        matches(const uint8_t *payload, uint8_t length, int8_t rssi) const;
+    bool        matchesRSSI(int8_t rssi) const;
+
+private:
+    bool        matchesServiceUUID(const uint8_t *uuid, uint8_t size) const;
+
+    std::vector<std::array<uint8_t, 16>> m_serviceUUIDs; // little endian 128 bit
+    std::vector<uint16_t>                m_companyIds;
+    std::string                          m_namePrefix;
+    int8_t                               m_minRSSI = -128;
+};
+
+#endif /* CONFIG_BT_ENABLED CONFIG_BT_NIMBLE_ROLE_OBSERVER */
+#endif /* COMPONENTS_NIMBLE_SCAN_FILTER_H_ */
@@ -0,0 +1,146 @@
+/*
+ * NimBLEScanIndex.cpp
+ *
+ *  Created: on October 17 2026
+ */
+
+#include "NimBLEScanIndex.h"
+
+#define NIMBLE_SCAN_INDEX_MIN_BITS 4
+
+
+/**
+ * @brief Pack an advertiser's identity into an index key.
+ * @param [in] address The 6 address bytes, in the order NimBLEAddress::getNative() returns them.
+ * @param [in] setId The advertising set ID, extended advertisers can run several sets from one address.
+ * @return The key.
+ */
+/*STATIC*/uint64_t NimBLEScanIndex::makeKey(const uint8_t* address, uint8_t setId) {
+    uint64_t key = setId;
+    for(int i = 5; i >= 0; i--) {
+        key = (key << 8) | address[i];
+    }
+    return key;
+} // makeKey
+
+
+/**
+ * @brief Get the slot a key hashes to.
+ * @details Fibonacci hashing, which spreads the sequential addresses devices of one vendor tend to have.
+ */
+size_t NimBLEScanIndex::home(uint64_t key) const {
+    return (key * 0x9E3779B97F4A7C15ULL) >> (64 - m_bits);
+} // home
+
+
+/**
+ * @brief Find the device stored under a key.
+ * @param [in] key The key from makeKey().
+ * @return A pointer to the device, or nullptr if there is none.
+ */
+NimBLEAdvertisedDevice* NimBLEScanIndex::find(uint64_t key) const {
+    if(m_count == 0) {
+        return nullptr;
+    }
+
+    size_t mask = m_slots.size() - 1;
+    for(size_t i = home(key); m_slots[i].device != nullptr; i = (i + 1) & mask) {
+        if(m_slots[i].key == key) {
+            return m_slots[i].device;
+        }
+    }
+    return nullptr;
+} // find
+
+
+/**
+ * @brief Store a device under a key that isn't in the index yet.
+ * @param [in] key The key from makeKey().
+ * @param [in] device The device, must not be nullptr.
+ */
+void NimBLEScanIndex::insert(uint64_t key, NimBLEAdvertisedDevice* device) {
+    if((m_count + 1) * 2 > m_slots.size()) {
+        grow();
+    }
+
+    size_t mask = m_slots.size() - 1;
+    size_t i = home(key);
+    while(m_slots[i].device != nullptr) {
+        i = (i + 1) & mask;
+    }
+    m_slots[i] = {key, device};
+    m_count++;
+} // insert
+
+
+/**
+ * @brief Remove a key from the index, if it is there.
+ * @param [in] key The key from makeKey().
+ */
+void NimBLEScanIndex::erase(uint64_t key) {
+    if(m_count == 0) {
+        return;
+    }
+
+    size_t mask = m_slots.size() - 1;
+    size_t hole = home(key);
+    while(m_slots[hole].key != key || m_slots[hole].device == nullptr) {
+        if(m_slots[hole].device == nullptr) {
+            return;
+        }
+        hole = (hole + 1) & mask;
+    }
+
+    // Pull back every later entry of the run that may not be probed past the hole.
+    for(size_t i = (hole + 1) & mask; m_slots[i].device != nullptr; i = (i + 1) & mask) {
+        size_t h = home(m_slots[i].key);
+        // The entry can move if its home slot is not cyclically within (hole, i].
+        if(((i - h) & mask) >= ((i - hole) & mask)) {
+            m_slots[hole] = m_slots[i];
+            hole = i;
+        }
+    }
+    m_slots[hole] = {0, nullptr};
+    m_count--;
+} // erase
+
+
+/**
+ * @brief Remove everything and release the table.
+ */
+void NimBLEScanIndex::clear() {
+    std::vector<Slot>().swap(m_slots);
+    m_count = 0;
+    m_bits = 0;
+} // clear
+
+
+/**
+ * @brief Get the number of devices in the index.
+ */
+size_t NimBLEScanIndex::size() const {
+    return m_count;
+} // size
+
+
+/**
+ * @brief Double the table, or allocate the first one, and rehash everything into it.
+ */
+void NimBLEScanIndex::grow() {
+    std::vector<Slot> old;
+    old.swap(m_slots);
+
+    m_bits = m_bits == 0 ? NIMBLE_SCAN_INDEX_MIN_BITS : m_bits + 1;
+    m_slots.assign((size_t)1 << m_bits, Slot{0, nullptr});
+
+    size_t mask = m_slots.size() - 1;
+    for(const Slot& slot : old) {
+        if(slot.device != nullptr) {
+            size_t i = home(slot.key);
+            while(m_slots[i].device != nullptr) {
+                i = (i + 1) & mask;
+            }
+            m_slots[i] = slot;
+        }
+    }
+} // grow
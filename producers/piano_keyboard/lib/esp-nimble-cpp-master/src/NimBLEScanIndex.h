@@ -0,0 +1,47 @@
+/*
+ * NimBLEScanIndex.h
+ *
+ *  Created: on October 17 2026
+ */
+
+#ifndef COMPONENTS_NIMBLE_SCAN_INDEX_H_
+#define COMPONENTS_NIMBLE_SCAN_INDEX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class NimBLEAdvertisedDevice;
+
+/**
+ * @brief Hash index from advertiser to its entry in the scan results.
+ * @details Open addressing with linear probing, kept at most half full, and backward-shift deletion so that
+ * no tombstones build up while advertisers come and go. Lookups stay constant time however many advertisers
+ * are in range. The index does not own the devices, and has no dependencies on the stack so that it also
+ * builds on a host.
+ */
+class NimBLEScanIndex {
+public:
+    static uint64_t         makeKey(const uint8_t* address, uint8_t setId = 0);
+
+    NimBLEAdvertisedDevice* find(uint64_t key) const;
+    void                    insert(uint64_t key, NimBLEAdvertisedDevice* device);
+    void                    erase(uint64_t key);
+    void                    clear();
+    size_t                  size() const;
+
+private:
+    struct Slot {
+        uint64_t                key;
+        NimBLEAdvertisedDevice* device; // nullptr for an empty slot
+    };
+
+    size_t                  home(uint64_t key) const;
+    void                    grow();
+
+    std::vector<Slot>       m_slots;
+    size_t                  m_count = 0;
+    uint8_t                 m_bits = 0;
+};
+
+#endif /* COMPONENTS_NIMBLE_SCAN_INDEX_H_ */
@@ -0,0 +1,97 @@
+/*
+ * NimBLEScanPending.cpp
+ *
+ *  Created: on October 17 2026
+ */
+
+#include "NimBLEScanPending.h"
+
+#include <string.h>
+
+
+/**
+ * @brief Hold a scannable advertisement until its scan response arrives.
+ * @param [in] address The 6 address bytes of the advertiser.
+ * @param [in] addressType The type of the address.
+ * @param [in] setId The advertising set ID.
+ * @param [in] advType The event type of the advertisement.
+ * @param [in] data The advertisement data.
+ * @param [in] length The length of the data, anything past NIMBLE_CPP_LEGACY_ADV_DATA_LEN is dropped.
+ * @return The entry, replacing what an earlier advertisement of the same advertiser left.
+ */
+NimBLEScanPending::Entry* NimBLEScanPending::hold(const uint8_t* address, uint8_t addressType, uint8_t setId,
+                                                  uint8_t advType, const uint8_t* data, uint8_t length) {
+    Entry* entry = find(address, addressType, setId);
+    if(entry == nullptr) {
+        entry = &m_entries[0];
+        for(auto &it : m_entries) {
+            if(!it.used) {
+                entry = &it;
+                break;
+            }
+            if(it.heldAt - entry->heldAt > UINT32_MAX / 2) {
+                entry = &it;
+            }
+        }
+
+        memcpy(entry->address, address, sizeof(entry->address));
+        entry->addressType = addressType;
+        entry->setId       = setId;
+        entry->used        = true;
+    }
+
+    entry->advType = advType;
+    entry->length  = length < NIMBLE_CPP_LEGACY_ADV_DATA_LEN ? length : NIMBLE_CPP_LEGACY_ADV_DATA_LEN;
+    memcpy(entry->data, data, entry->length);
+    entry->heldAt  = m_holds++;
+    return entry;
+} // hold
+
+
+/**
+ * @brief Find the advertisement held for an advertiser.
+ * @param [in] address The 6 address bytes of the advertiser.
+ * @param [in] addressType The type of the address.
+ * @param [in] setId The advertising set ID.
+ * @return The entry, or nullptr if none is held.
+ */
+NimBLEScanPending::Entry* NimBLEScanPending::find(const uint8_t* address, uint8_t addressType, uint8_t setId) {
+    for(auto &it : m_entries) {
+        if(it.used && it.addressType == addressType && it.setId == setId &&
+           memcmp(it.address, address, sizeof(it.address)) == 0) {
+            return &it;
+        }
+    }
+    return nullptr;
+} // find
+
+
+/**
+ * @brief Free an entry once its scan response has been checked.
+ * @param [in] entry The entry from hold() or find().
+ */
+void NimBLEScanPending::release(Entry* entry) {
+    entry->used = false;
+} // release
+
+
+/**
+ * @brief Free every entry, when a scan ends.
+ */
+void NimBLEScanPending::clear() {
+    for(auto &it : m_entries) {
+        it.used = false;
+    }
+} // clear
+
+
+/**
+ * @brief Get the number of advertisements held.
+ */
+size_t NimBLEScanPending::size() const {
+    size_t count = 0;
+    for(auto &it : m_entries) {
+        count += it.used;
+    }
+    return count;
+} // size
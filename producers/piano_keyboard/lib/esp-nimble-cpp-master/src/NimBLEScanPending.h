@@ -0,0 +1,55 @@
+/*
+ * NimBLEScanPending.h
+ *
+ *  Created: on October 17 2026
+ */
+
+#ifndef COMPONENTS_NIMBLE_SCAN_PENDING_H_
+#define COMPONENTS_NIMBLE_SCAN_PENDING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if !defined(CONFIG_NIMBLE_CPP_SCAN_PENDING_SIZE)
+#    define CONFIG_NIMBLE_CPP_SCAN_PENDING_SIZE 8
+#elif CONFIG_NIMBLE_CPP_SCAN_PENDING_SIZE < 1 || CONFIG_NIMBLE_CPP_SCAN_PENDING_SIZE > 255
+#    error CONFIG_NIMBLE_CPP_SCAN_PENDING_SIZE must be 1 to 255
+#endif
+
+/** @brief The most advertisement data a legacy advertising report carries. */
+#define NIMBLE_CPP_LEGACY_ADV_DATA_LEN 31
+
+/**
+ * @brief Scannable advertisements that didn't pass the scan filter on their own, held until their scan response
+ * can be checked along with them.
+ * @details A fixed table, so advertisers that never pass cost no allocations however many are in range. An
+ * advertiser is told apart by its address, address type and advertising set ID. When the table is full, the entry
+ * held longest without a new advertisement makes room. Has no dependencies on the stack so that it also builds on a
+ * host.
+ */
+class NimBLEScanPending {
+public:
+    struct Entry {
+        uint8_t  address[6];  // in the order NimBLEAddress::getNative() returns them
+        uint8_t  addressType;
+        uint8_t  setId;
+        uint8_t  advType;     // the event type of the advertisement
+        uint8_t  length;
+        bool     used;
+        uint32_t heldAt;      // when it was last held, in calls to hold()
+        uint8_t  data[NIMBLE_CPP_LEGACY_ADV_DATA_LEN];
+    };
+
+    Entry*       hold(const uint8_t* address, uint8_t addressType, uint8_t setId, uint8_t advType,
+                      const uint8_t* data, uint8_t length);
+    Entry*       find(const uint8_t* address, uint8_t addressType, uint8_t setId);
+    void         release(Entry* entry);
+    void         clear();
+    size_t       size() const;
+
+private:
+    Entry        m_entries[CONFIG_NIMBLE_CPP_SCAN_PENDING_SIZE] = {};
+    uint32_t     m_holds = 0;
+};
+
+#endif /* COMPONENTS_NIMBLE_SCAN_PENDING_H_ */
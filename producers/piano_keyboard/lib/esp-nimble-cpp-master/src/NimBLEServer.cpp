@@ -391,6 +391,10 @@ int NimBLEServer::handleGapEvent(struct ble_gap_event *event, void *arg) {
                                                           event->disconnect.conn.conn_handle),
                                                           server->m_connectedPeersVec.end());
 
+            for(auto &it : server->m_notifyChrVec) {
+                it->m_subscribers.remove(event->disconnect.conn.conn_handle);
+            }
+
             if(server->m_svcChanged) {
                 server->resetGATT();
             }
@@ -444,6 +448,10 @@ int NimBLEServer::handleGapEvent(struct ble_gap_event *event, void *arg) {
                 return 0;
             }
 
+            for(auto &it : server->m_notifyChrVec) {
+                it->m_subscribers.setMTU(event->mtu.conn_handle, event->mtu.value);
+            }
+
             server->m_pServerCallbacks->onMTUChange(event->mtu.value, &desc);
             return 0;
         } // BLE_GAP_EVENT_MTU
@@ -530,6 +538,10 @@ int NimBLEServer::handleGapEvent(struct ble_gap_event *event, void *arg) {
             if(rc != 0) {
                 return BLE_ATT_ERR_INVALID_HANDLE;
             }
+
+            for(auto &it : server->m_notifyChrVec) {
+                it->m_subscribers.setEncrypted(event->enc_change.conn_handle, desc.sec_state.encrypted);
+            }
             // Compatibility only - Do not use, should be removed the in future
             if(NimBLEDevice::m_securityCallbacks != nullptr) {
                 NimBLEDevice::m_securityCallbacks->onAuthenticationComplete(&desc);
@@ -0,0 +1,121 @@
+/*
+ * NimBLESubscriberList.h
+ *
+ *  Created: on October 17 2026
+ */
+
+#ifndef COMPONENTS_NIMBLE_SUBSCRIBER_LIST_H_
+#define COMPONENTS_NIMBLE_SUBSCRIBER_LIST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * @brief A client subscribed to a characteristic, with the connection state a notification to it depends on.
+ */
+struct NimBLESubscriber {
+    uint16_t connHandle;
+    uint16_t subValue;   // NIMBLE_SUB_NOTIFY and/or NIMBLE_SUB_INDICATE
+    uint16_t mtu;        // the ATT MTU of the connection
+    bool     encrypted;
+};
+
+/**
+ * @brief The clients subscribed to a characteristic.
+ * @details Keeps the MTU and encryption of each subscriber's connection as of the last update, so that sending a
+ * notification to all of them needs no lookups in the stack. The owner updates them on the MTU and encryption
+ * change events of the connection. Has no dependencies on the stack so that it also builds on a host.
+ */
+class NimBLESubscriberList {
+public:
+    typedef std::vector<NimBLESubscriber>::const_iterator const_iterator;
+
+    /**
+     * @brief Add, update or remove the subscription of a connection.
+     * @param [in] connHandle The connection.
+     * @param [in] subValue The subscription, 0 removes the subscriber.
+     * @param [in] mtu The ATT MTU of the connection.
+     * @param [in] encrypted If the connection is encrypted.
+     */
+    void set(uint16_t connHandle, uint16_t subValue, uint16_t mtu, bool encrypted) {
+        if(subValue == 0) {
+            remove(connHandle);
+            return;
+        }
+
+        NimBLESubscriber* sub = find(connHandle);
+        if(sub == nullptr) {
+            m_subscribers.push_back(NimBLESubscriber{connHandle, subValue, mtu, encrypted});
+            return;
+        }
+        sub->subValue  = subValue;
+        sub->mtu       = mtu;
+        sub->encrypted = encrypted;
+    } // set
+
+
+    /**
+     * @brief Remove the subscription of a connection, if it has one.
+     */
+    void remove(uint16_t connHandle) {
+        for(size_t i = 0; i < m_subscribers.size(); i++) {
+            if(m_subscribers[i].connHandle == connHandle) {
+                m_subscribers.erase(m_subscribers.begin() + i);
+                return;
+            }
+        }
+    } // remove
+
+
+    /**
+     * @brief Update the MTU of a connection.
+     * @return False if the connection is not subscribed.
+     */
+    bool setMTU(uint16_t connHandle, uint16_t mtu) {
+        NimBLESubscriber* sub = find(connHandle);
+        if(sub == nullptr) {
+            return false;
+        }
+        sub->mtu = mtu;
+        return true;
+    } // setMTU
+
+
+    /**
+     * @brief Update the encryption of a connection.
+     * @return False if the connection is not subscribed.
+     */
+    bool setEncrypted(uint16_t connHandle, bool encrypted) {
+        NimBLESubscriber* sub = find(connHandle);
+        if(sub == nullptr) {
+            return false;
+        }
+        sub->encrypted = encrypted;
+        return true;
+    } // setEncrypted
+
+
+    /**
+     * @brief Get the subscription of a connection.
+     * @return The subscriber, or nullptr if the connection is not subscribed.
+     */
+    NimBLESubscriber* find(uint16_t connHandle) {
+        for(NimBLESubscriber& sub : m_subscribers) {
+            if(sub.connHandle == connHandle) {
+                return &sub;
+            }
+        }
+        return nullptr;
+    } // find
+
+
+    size_t         size()  const { return m_subscribers.size(); }
+    const_iterator begin() const { return m_subscribers.begin(); }
+    const_iterator end()   const { return m_subscribers.end(); }
+
+private:
+    std::vector<NimBLESubscriber> m_subscribers;
+};
+
+#endif /* COMPONENTS_NIMBLE_SUBSCRIBER_LIST_H_ */
@@ -296,39 +296,63 @@ std::string NimBLEUUID::toString() const {
 } // toString
 
 
+/**
+ * @brief Get the 128 bit form of this UUID as two little endian halves.
+ * @details 16 and 32 bit UUIDs are placed in the Bluetooth base UUID, so a UUID has the same halves whichever
+ * width it is stored in.
+ * @param [out] low Bytes 0-7 of the 128 bit UUID.
+ * @param [out] high Bytes 8-15 of the 128 bit UUID.
+ */
+void NimBLEUUID::get128(uint64_t* low, uint64_t* high) const {
+    switch(m_uuid.u.type) {
+        case BLE_UUID_TYPE_16:
+            *low  = 0x800000805f9b34fb;
+            *high = ((uint64_t)m_uuid.u16.value << 32) | 0x00001000;
+            break;
+        case BLE_UUID_TYPE_32:
+            *low  = 0x800000805f9b34fb;
+            *high = ((uint64_t)m_uuid.u32.value << 32) | 0x00001000;
+            break;
+        default:
+            memcpy(low, m_uuid.u128.value, 8);
+            memcpy(high, m_uuid.u128.value + 8, 8);
+            break;
+    }
+} // get128
+
+
+/**
+ * @brief Get a hash of this UUID.
+ * @details Equal UUIDs hash the same whatever width they are stored in.
+ * @return The hash of the UUID, 0 for an unset UUID.
+ */
+size_t NimBLEUUID::hash() const {
+    if(!m_valueSet) {
+        return 0;
+    }
+
+    uint64_t low, high;
+    get128(&low, &high);
+    // Most UUIDs in use share the base UUID and differ only in the high half.
+    uint64_t h = (high ^ (low * 0x9e3779b97f4a7c15)) * 0x9e3779b97f4a7c15;
+    return (size_t)(h ^ (h >> 32));
+} // hash
+
+
 /**
  * @brief Convienience operator to check if this UUID is equal to another.
+ * @details UUIDs of different widths are equal if they are the same 128 bit UUID.
  */
 bool NimBLEUUID::operator ==(const NimBLEUUID & rhs) const {
     if(m_valueSet && rhs.m_valueSet) {
-        if(m_uuid.u.type != rhs.m_uuid.u.type) {
-            uint8_t uuidBase[16] = {
-                0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80,
-                0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
-            };
-
-            if(m_uuid.u.type == BLE_UUID_TYPE_128){
-                if(rhs.m_uuid.u.type == BLE_UUID_TYPE_16){
-                    memcpy(uuidBase+12, &rhs.m_uuid.u16.value, 2);
-                } else if (rhs.m_uuid.u.type == BLE_UUID_TYPE_32){
-                    memcpy(uuidBase+12, &rhs.m_uuid.u32.value, 4);
-                }
-                return memcmp(m_uuid.u128.value,uuidBase,16) == 0;
-
-            } else if(rhs.m_uuid.u.type == BLE_UUID_TYPE_128) {
-                if(m_uuid.u.type == BLE_UUID_TYPE_16){
-                    memcpy(uuidBase+12, &m_uuid.u16.value, 2);
-                } else if (m_uuid.u.type == BLE_UUID_TYPE_32){
-                    memcpy(uuidBase+12, &m_uuid.u32.value, 4);
-                }
-                return memcmp(rhs.m_uuid.u128.value,uuidBase,16) == 0;
-
-            } else {
-                return false;
-            }
+        if(m_uuid.u.type == BLE_UUID_TYPE_16 && rhs.m_uuid.u.type == BLE_UUID_TYPE_16) {
+            return m_uuid.u16.value == rhs.m_uuid.u16.value;
         }
 
-        return ble_uuid_cmp(&m_uuid.u, &rhs.m_uuid.u) == 0;
+        uint64_t low, high, rhsLow, rhsHigh;
+        get128(&low, &high);
+        rhs.get128(&rhsLow, &rhsHigh);
+        return low == rhsLow && high == rhsHigh;
     }
 
     return m_valueSet == rhs.m_valueSet;
@@ -343,6 +367,22 @@ bool NimBLEUUID::operator !=(const NimBLEUUID & rhs) const {
 }
 
 
+/**
+ * @brief Order UUIDs by their 128 bit form, for UUID keyed ordered containers.
+ * @details The order is consistent with operator ==, unset UUIDs come first.
+ */
+bool NimBLEUUID::operator <(const NimBLEUUID & rhs) const {
+    if(!m_valueSet || !rhs.m_valueSet) {
+        return !m_valueSet && rhs.m_valueSet;
+    }
+
+    uint64_t low, high, rhsLow, rhsHigh;
+    get128(&low, &high);
+    rhs.get128(&rhsLow, &rhsHigh);
+    return high != rhsHigh ? high < rhsHigh : low < rhsLow;
+}
+
+
 /**
  * @brief Convienience operator to convert this UUID to string representation.
  * @details This allows passing NimBLEUUID to functions
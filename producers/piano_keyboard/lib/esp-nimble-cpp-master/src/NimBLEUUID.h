@@ -29,7 +29,10 @@
 #undef max
 /**************************/
 
+#include "NimBLELiteral.h"
+
 #include <string>
+#include <functional>
 
 /**
  * @brief A model of a %BLE UUID.
@@ -51,14 +54,50 @@ public:
     const NimBLEUUID&     to16();
     std::string           toString() const;
     static NimBLEUUID     fromString(const std::string &uuid);
+    size_t                hash() const;
 
     bool operator ==(const NimBLEUUID & rhs) const;
     bool operator !=(const NimBLEUUID & rhs) const;
+    bool operator <(const NimBLEUUID & rhs) const;
     operator std::string() const;
 
+    /**
+     * @brief Parse a 128 bit UUID string at compile time.
+     * @details Use it to initialize a constexpr ble_uuid128_t, which is then stored in flash, and construct a
+     * NimBLEUUID from a pointer to that. A malformed string fails to compile.\n
+     * <tt>static constexpr ble_uuid128_t serviceUUID = NimBLEUUID::literal128("beb5483e-36e1-4688-b7f5-ea07361b26a8");</tt>
+     * @param [in] uuid The UUID string, of the form "0000180d-0000-1000-8000-00805f9b34fb".
+     * @return The native UUID.
+     */
+    static constexpr ble_uuid128_t literal128(const char (&uuid)[37]) {
+        return ble_uuid128_t{{BLE_UUID_TYPE_128}, {
+            NimBLELiteral::uuidByte(uuid, 0),  NimBLELiteral::uuidByte(uuid, 1),
+            NimBLELiteral::uuidByte(uuid, 2),  NimBLELiteral::uuidByte(uuid, 3),
+            NimBLELiteral::uuidByte(uuid, 4),  NimBLELiteral::uuidByte(uuid, 5),
+            NimBLELiteral::uuidByte(uuid, 6),  NimBLELiteral::uuidByte(uuid, 7),
+            NimBLELiteral::uuidByte(uuid, 8),  NimBLELiteral::uuidByte(uuid, 9),
+            NimBLELiteral::uuidByte(uuid, 10), NimBLELiteral::uuidByte(uuid, 11),
+            NimBLELiteral::uuidByte(uuid, 12), NimBLELiteral::uuidByte(uuid, 13),
+            NimBLELiteral::uuidByte(uuid, 14), NimBLELiteral::uuidByte(uuid, 15)}};
+    }
+
 private:
+    void           get128(uint64_t* low, uint64_t* high) const;
+
     ble_uuid_any_t m_uuid;
     bool           m_valueSet = false;
 }; // NimBLEUUID
+
+
+namespace std {
+/**
+ * @brief Hash a NimBLEUUID, for UUID keyed unordered containers.
+ */
+template<>
+struct hash<NimBLEUUID> {
+    size_t operator()(const NimBLEUUID &uuid) const { return uuid.hash(); }
+};
+} // namespace std
+
 #endif /* CONFIG_BT_ENABLED */
 #endif /* COMPONENTS_NIMBLEUUID_H_ */
@@ -55,6 +55,30 @@
  */
 #define CONFIG_NIMBLE_CPP_ATT_VALUE_INIT_LENGTH 20
 
+/** @brief Un-comment to change the size (bytes) of values stored inside an attribute value rather than on the heap.\n
+ *  Every attribute value grows by this many bytes. Set to 0 to store every value on the heap.\n
+ *  Default value is 20. Range: 0 : 512 (BLE_ATT_ATTR_MAX_LEN)
+ */
+#define CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH 20
+
+/** @brief Un-comment to change the number of scan results allocated from a fixed pool rather than the heap.\n
+ *  Devices beyond this number are allocated on the heap. Set to 0 to allocate every device on the heap.\n
+ *  Default value is 16. Range: 0 : 255
+ */
+#define CONFIG_NIMBLE_CPP_ADV_DEVICE_POOL_SIZE 16
+
+/** @brief Un-comment to change the number of scannable advertisements held while their scan response is awaited.\n
+ *  Only used with a scan filter and active scanning, for advertisements that don't pass the filter on their own.\n
+ *  Default value is 8. Range: 1 : 255
+ */
+#define CONFIG_NIMBLE_CPP_SCAN_PENDING_SIZE 8
+
+/** @brief Un-comment to change the number of attributes stored in NVS per peer by NimBLEClient::saveAttributes().\n
+ *  A peer with more discovered attributes is not cached. Set to 0 to disable the cache.\n
+ *  Default value is 32. Range: 0 : 255
+ */
+#define CONFIG_NIMBLE_CPP_GATT_CACHE_MAX_ATTRIBUTES 32
+
 /** @brief Un-comment to change the default MTU size */
 #define CONFIG_BT_NIMBLE_ATT_PREFERRED_MTU 255
 
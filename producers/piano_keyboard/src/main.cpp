@@ -5,22 +5,37 @@
 #include <string.h>
 #include <sys/param.h>
 
+#include <atomic>
+
 #include "NimBLEDevice.h"
+#include "ble_midi.h"
+#include "boot_timeline.h"
 #include "driver/gpio.h"
 #include "esp_bt.h"
+#include "esp_heap_caps.h"
 #include "esp_hidh.h"
 #include "esp_log.h"
 #include "esp_netif.h"
+#include "esp_random.h"
 #include "esp_system.h"
 #include "esp_wifi.h"
+#include "event_codec.h"
+#include "event_log.h"
+#include "flash_log.h"
+#include "flash_log_partition.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 #include "freertos/task.h"
+#include "key_batch.h"
+#include "latency_histogram.h"
 #include "lwip/err.h"
 #include "lwip/sockets.h"
 #include "lwip/sys.h"
 #include "mqtt_client.h"
 #include "nvs_flash.h"
+#include "producer_event.h"
+#include "producer_runtime.h"
+#include "wifi_fast_connect.h"
 
 #define LED_BUILTIN GPIO_NUM_1
 
@@ -33,16 +48,39 @@ esp_netif_t* sta_netif = NULL;
 #define WIFI_CONNECTED_BIT BIT0
 #define WIFI_FAIL_BIT BIT1
 
+// bring-up steps wait on these instead of on fixed delays or on each other's call order
+static EventGroupHandle_t s_boot_event_group;
+
+#define BOOT_STORAGE_READY_BIT BIT0  // event log mounted, or known to be missing
+#define BOOT_PIANO_FOUND_BIT BIT1    // a scan found the piano, cleared by the bluetooth task
+
+enum {
+    BOOT_NVS,
+    BOOT_STORAGE,
+    BOOT_BLE,
+    BOOT_GOT_IP,
+    BOOT_MQTT,
+    BOOT_PIANO_FOUND,
+    BOOT_PIANO_SUBSCRIBED,
+    BOOT_FIRST_KEY,
+    BOOT_FIRST_PUBLISH,
+    BOOT_PHASES,
+};
+
+static const char* const boot_phase_names[BOOT_PHASES] = {
+    "nvs", "storage", "ble", "got_ip", "mqtt", "piano_found", "subscribed", "first_key", "first_publish",
+};
+
+// published once on `DEVICE_ID/boot` with the first event
+static boot_timeline<BOOT_PHASES> boot_phases(boot_phase_names);
+
+static void boot_mark(size_t phase) { boot_phases.mark(phase, esp_timer_get_time()); }
+
 #define MAX_RETRY 3
 static int s_retry_num = 0;
 
-unsigned long last_blink = 0;
-bool on = false;
-
 esp_mqtt_client_handle_t mqtt_client;
-
-#define MQTT_EVENT_ID_LENGTH 128
-char mqtt_event_id[MQTT_EVENT_ID_LENGTH];
+static volatile bool mqtt_connected = false;
 
 #define MQTT_TOPIC_LENGTH 256
 #define MQTT_BODY_LENGTH 1024
@@ -53,8 +91,42 @@ char mqtt_body[MQTT_BODY_LENGTH];
 char mqtt_topic_debug[MQTT_TOPIC_LENGTH];
 char mqtt_body_debug[MQTT_BODY_LENGTH];
 
+// filled by the bluetooth host task, drained by the publisher task
+static producer_event_ring_t key_events;
+
+// time from notification receipt to each later stage, drained every METRICS_PERIOD_MS
+static latency_histogram latency_decode;
+static latency_histogram latency_enqueue;
+static latency_histogram latency_publish;
+
+char mqtt_topic_metrics[MQTT_TOPIC_LENGTH];
+char mqtt_body_metrics[MQTT_BODY_LENGTH];
+// set by the metrics timer once mqtt_body_metrics holds a summary, cleared by the publisher task once it's sent
+static std::atomic<bool> metrics_ready{false};
+
+// scan result allocation counters as of the last metrics publish, for per-second rates
+static NimBLEAdvertisedDeviceAllocStats last_alloc_stats = {};
+static int64_t last_alloc_stats_us = 0;
+
+char mqtt_topic_boot[MQTT_TOPIC_LENGTH];
+char mqtt_body_boot[MQTT_BODY_LENGTH];
+static bool boot_reported = false;
+
+// events published while the broker is unreachable, owned by the publisher task
+static flash_log event_log;
+static bool event_log_mounted = false;
+static uint8_t event_log_record[EVENT_LOG_RECORD_MAX_LENGTH];
+// stored with every event, so that only this boot's stamps are used for latencies after a replay
+static uint32_t event_log_boot_id = 0;
+// set by the publisher task when the replay waits on the broker's acknowledgements, cleared by the next one
+static std::atomic<bool> replay_waiting{false};
+
 BLEScan* pBLEScan;
-static BLEUUID serviceUUID(PIANO_UUID);
+// parsed at compile time into flash
+static constexpr ble_uuid128_t piano_uuid = NimBLEUUID::literal128(PIANO_UUID);
+static constexpr ble_uuid128_t midi_uuid = NimBLEUUID::literal128(BLE_MIDI_CHARACTERISTIC_UUID);
+static BLEUUID serviceUUID(&piano_uuid);
+static BLEUUID charUUID(&midi_uuid);
 
 static bool do_connect_ble = false;
 static bool connected_ble = false;
@@ -62,27 +134,52 @@ static bool do_scan = true;
 static BLERemoteCharacteristic* pRemoteCharacteristic;
 static BLEAdvertisedDevice* piano_device;
 
-unsigned long last_uptime_ping = 0;
-
 // /configurations ------------------------------------------------
 
 #define BLINK true
 
-#define BLINK_PRIORITY 1
-#define SENSOR_PRIORITY 2
+#define BLINK_PERIOD_MS 500
+
+#define PUBLISHER_PRIORITY 2
 
 // 0 - at most once (unreliable)
 // 1 - at least once (requires indempotency) (DEFAULT)
 // 2 - exactly once (slow)
 #define MQTT_QOS 1
 
+// key events arriving within this many milliseconds of the first one are published together as one message on
+// `DEVICE_ID/keys` instead of one message each on `DEVICE_ID/key`; 0 disables batching
+#define KEY_BATCH_WINDOW_MS 0
+#define KEY_BATCH_MAX_RECORDS 32
+
+// false - text bodies on `DEVICE_ID/<event>`, e.g. "60 up"
+// true - binary event_codec frames on `DEVICE_ID/bin/<event>`
+#define EVENT_FORMAT_BINARY false
+
+// how often latency histograms are published on `DEVICE_ID/metrics`
+#define METRICS_PERIOD_MS 10000
+
+// data partition that holds events while the broker is unreachable, see partitions.csv
+#define EVENT_LOG_PARTITION "evlog"
+// stored events published per publisher wakeup once the broker is back, live events go out in between
+#define EVENT_LOG_REPLAY_BURST 8
+// stored events are only published while the MQTT client holds fewer bytes than this that the broker hasn't
+// acknowledged yet, so the replay goes as fast as the broker keeps up without filling the client's outbox
+#define EVENT_LOG_REPLAY_OUTBOX_BYTES 2048
+
+// connect to the access point and address of the last boot without scanning or DHCP, see wifi_fast_connect.h
+#define WIFI_FAST_CONNECT true
+
 // configurations -------------------------------------------------
 
 static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
         esp_wifi_connect();
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        if (s_retry_num < MAX_RETRY) {
+        if (fast_connect_disconnected(sta_netif)) {
+            // the cached access point is gone, scanning for it isn't a retry
+            esp_wifi_connect();
+        } else if (s_retry_num < MAX_RETRY) {
             esp_wifi_connect();
             s_retry_num++;
         } else {
@@ -90,6 +187,8 @@ static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_
         }
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*)event_data;
+        fast_connect_got_ip(sta_netif, event);
+        boot_mark(BOOT_GOT_IP);
         s_retry_num = 0;
         xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
     }
@@ -101,7 +200,7 @@ static void wifi_init() {
     ESP_ERROR_CHECK(esp_netif_init());
 
     ESP_ERROR_CHECK(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
+    sta_netif = esp_netif_create_default_wifi_sta();
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -119,18 +218,58 @@ static void wifi_init() {
 
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    if (WIFI_FAST_CONNECT) {
+        fast_connect_begin(sta_netif);
+    }
     ESP_ERROR_CHECK(esp_wifi_start());
 
     connected = true;
 }
 
+static void mqtt_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
+    if (event_id == MQTT_EVENT_CONNECTED) {
+        mqtt_connected = true;
+        boot_mark(BOOT_MQTT);
+        // start replaying whatever was stored during the outage
+        runtime_notify_publisher();
+    } else if (event_id == MQTT_EVENT_DISCONNECTED) {
+        mqtt_connected = false;
+    } else if (event_id == MQTT_EVENT_PUBLISHED) {
+        // the acknowledgement made room in the outbox for more stored events
+        if (replay_waiting.exchange(false)) {
+            runtime_notify_publisher();
+        }
+    }
+}
+
+/**
+ * @brief Create the client, it's started once there is an IP address
+ */
 static void mqtt_init() {
     esp_mqtt_client_config_t mqtt_cfg = {};
     memset((void*)&mqtt_cfg, 0, sizeof(esp_mqtt_client_config_t));
     mqtt_cfg.uri = MQTT_ADDRESS;
 
     mqtt_client = esp_mqtt_client_init(&mqtt_cfg);
-    esp_mqtt_client_start(mqtt_client);
+    esp_mqtt_client_register_event(mqtt_client, MQTT_EVENT_ANY, mqtt_event_handler, NULL);
+}
+
+static void event_log_init() {
+    flash_log_io_t io;
+    if (flash_log_partition_io(EVENT_LOG_PARTITION, &io) != ESP_OK) {
+        printf("no %s partition, events during outages will be lost\n", EVENT_LOG_PARTITION);
+    } else {
+        event_log_boot_id = esp_random();
+        int err = event_log.mount(io);
+        if (err != FLASH_LOG_OK) {
+            printf("failed to mount the event log: %d\n", err);
+        } else {
+            event_log_mounted = true;
+        }
+    }
+
+    boot_mark(BOOT_STORAGE);
+    xEventGroupSetBits(s_boot_event_group, BOOT_STORAGE_READY_BIT);
 }
 
 void mqtt_send_debug(const char* fmt, ...) {
@@ -140,6 +279,12 @@ void mqtt_send_debug(const char* fmt, ...) {
     vsnprintf(mqtt_body_debug, MQTT_BODY_LENGTH, fmt, aptr);
     va_end(aptr);
 
+    // bluetooth comes up alongside the network, so early messages only make it to the serial console
+    if (!mqtt_connected) {
+        printf("%s\n", mqtt_body_debug);
+        return;
+    }
+
     snprintf(mqtt_topic_debug, MQTT_TOPIC_LENGTH, "%s/debug", DEVICE_ID);
     esp_mqtt_client_publish(mqtt_client, mqtt_topic_debug, mqtt_body_debug, 0, MQTT_QOS, 0);
 }
@@ -183,29 +328,118 @@ class BluetoothAdvertisedDeviceCallbacks : public BLEAdvertisedDeviceCallbacks {
             piano_device = advertisedDevice;
             do_connect_ble = true;
             do_scan = false;
+            boot_mark(BOOT_PIANO_FOUND);
+            xEventGroupSetBits(s_boot_event_group, BOOT_PIANO_FOUND_BIT);
         }
     }
 };
 
-static void notifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic, uint8_t* pData, size_t length,
+/**
+ * @brief Turn a decoded MIDI message into an event to publish
+ *
+ * @return false for messages the piano doesn't report
+ */
+static bool midi_to_event(const ble_midi_event_t* midi, producer_event_t* event) {
+    switch (midi->type) {
+        case BLE_MIDI_NOTE_ON:
+        case BLE_MIDI_NOTE_OFF:
+            event->kind = EVENT_KEY;
+            snprintf(event->event_id, EVENT_ID_LENGTH, "key");
+            event->key.key = midi->data1;
+            event->key.state = midi->type == BLE_MIDI_NOTE_ON ? KEY_DOWN : KEY_UP;
+            event->key.velocity = midi->data2;
+            return true;
+        case BLE_MIDI_SUSTAIN:
+        case BLE_MIDI_CONTROL_CHANGE:
+            event->kind = EVENT_CONTROL;
+            snprintf(event->event_id, EVENT_ID_LENGTH, midi->type == BLE_MIDI_SUSTAIN ? "sustain" : "control");
+            event->control.controller = midi->data1;
+            event->control.value = midi->data2;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/** @brief A BLE-MIDI packet is one ATT value, which is at most this long */
+#define MIDI_PACKET_MAX_LENGTH 512
+
+// only the bluetooth host task touches it, packets split over several buffers are gathered here
+static uint8_t midi_packet[MIDI_PACKET_MAX_LENGTH];
+
+// runs in the bluetooth host task, which is the only producer of `key_events`
+static void notifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic, const NimBLEMbufView& data,
                            bool isNotify) {
-    printf("Notify callback for characteristic %s of data length %d data: %s\n",
-           pBLERemoteCharacteristic->getUUID().toString().c_str(), length, (char*)pData);
+    int64_t received_us = esp_timer_get_time();
+    boot_phases.mark(BOOT_FIRST_KEY, received_us);
+
+    // decode straight out of the stack's buffer, which almost always holds the whole packet
+    const uint8_t* pData = data.data();
+    size_t length = data.dataLength();
+    if (!data.isContiguous()) {
+        length = data.copyTo(midi_packet, 0, sizeof(midi_packet));
+        pData = midi_packet;
+    }
+
+    ble_midi_parser parser(pData, length);
+    ble_midi_event_t midi;
+    producer_event_t event;
+    bool pushed = false;
+    while (parser.next(&midi)) {
+        int64_t decoded_us = esp_timer_get_time();
+        if (!midi_to_event(&midi, &event)) {
+            continue;
+        }
+
+        // messages later in the packet happened later by their offset from the first one
+        event.timestamp_us =
+            received_us + ble_midi_elapsed_ms(parser.first_timestamp_ms(), midi.timestamp_ms) * 1000LL;
+        event.stamps.received_us = received_us;
+        event.stamps.decoded_us = decoded_us;
+
+        // the ring copies the event in, so the enqueue stage can only be recorded here, once the push went through
+        if (key_events.push(event)) {
+            latency_enqueue.record(esp_timer_get_time() - received_us);
+            pushed = true;
+        }
+    }
+
+    if (pushed) {
+        runtime_notify_publisher();
+    }
 }
 
 bool connectToServer() {
     mqtt_send_debug("Forming a connection to %s\n", piano_device->getAddress().toString().c_str());
 
-    BLEClient* pClient = BLEDevice::createClient();
-    mqtt_send_debug(" - Created client\n");
+    // the library holds a fixed number of clients, so reconnects reuse the one the piano dropped
+    BLEClient* pClient = BLEDevice::getDisconnectedClient();
+    if (pClient == nullptr) {
+        pClient = BLEDevice::createClient();
+        if (pClient == nullptr) {
+            mqtt_send_debug("Failed to create a client\n");
+            return false;
+        }
+        mqtt_send_debug(" - Created client\n");
 
-    pClient->setClientCallbacks(new BluetoothCallbacks());
+        pClient->setClientCallbacks(new BluetoothCallbacks());
+    }
+
+    // a key press waits for the next connection event, so connect at the shortest interval BLE-MIDI allows
+    pClient->applyProfile(BLEClient::LOW_LATENCY);
 
     // Connect to the remove BLE Server.
     pClient->connect(piano_device);  // if you pass BLEAdvertisedDevice instead of address, it will be recognized type
                                      // of peer device address (public or private)
     mqtt_send_debug(" - Connected to server\n");
 
+    // the attributes stored on the last connection, if still current, so finding the service, characteristic and
+    // descriptor below takes no discovery and subscribing is the only request before notes flow
+    bool restored = pClient->restoreAttributes();
+    if (restored) {
+        mqtt_send_debug(" - Restored attributes\n");
+    }
+
     int num_services = piano_device->getServiceDataCount();
     mqtt_send_debug("number of service UUIDs: %d", num_services);
     for (int i = 0; i < num_services; i++) {
@@ -221,14 +455,14 @@ bool connectToServer() {
     }
     mqtt_send_debug(" - Found our service\n");
 
-    /* // Obtain a reference to the characteristic in the service of the remote BLE server.
+    // Obtain a reference to the MIDI characteristic in the service of the remote BLE server.
     pRemoteCharacteristic = pRemoteService->getCharacteristic(charUUID);
     if (pRemoteCharacteristic == nullptr) {
-        printf("Failed to find our characteristic UUID: %s\n", charUUID.toString().c_str());
+        mqtt_send_debug("Failed to find our characteristic UUID: %s\n", charUUID.toString().c_str());
         pClient->disconnect();
         return false;
     }
-    mqtt_send_debug(" - Found our characteristic\n"); */
+    mqtt_send_debug(" - Found our characteristic\n");
 
     /* // Read the value of the characteristic.
     if (pRemoteCharacteristic->canRead()) {
@@ -238,16 +472,48 @@ bool connectToServer() {
     /** registerForNotify() has been deprecated and replaced with subscribe() / unsubscribe().
      *  Subscribe parameter defaults are: notifications=true, notifyCallback=nullptr, response=false.
      *  Unsubscribe parameter defaults are: response=false.
+     *  subscribeView() takes the same parameters, but its callback reads the stack's buffers instead of a copy.
      */
-    /* if (pRemoteCharacteristic->canNotify()) {
-        // pRemoteCharacteristic->registerForNotify(notifyCallback);
-        pRemoteCharacteristic->subscribe(true, notifyCallback);
-    } */
+    if (!pRemoteCharacteristic->canNotify() || !pRemoteCharacteristic->subscribeView(true, notifyCallback)) {
+        mqtt_send_debug("Failed to subscribe to MIDI notifications\n");
+        pClient->disconnect();
+        return false;
+    }
+    mqtt_send_debug(" - Subscribed to MIDI notifications\n");
+    boot_mark(BOOT_PIANO_SUBSCRIBED);
+
+    if (!restored && pClient->saveAttributes()) {
+        mqtt_send_debug(" - Saved attributes\n");
+    }
+
+    // the 2M PHY and long packets can only be asked for once connected, after subscribing so notes aren't held up
+    if (pClient->applyProfile(BLEClient::LOW_LATENCY)) {
+        NimBLEConnInfo info = pClient->getConnInfo();
+        mqtt_send_debug(" - Connection interval %u x 1.25 ms on the %s PHY\n", info.getConnInterval(),
+                        info.getTxPhy() == BLE_GAP_LE_PHY_2M ? "2M" : "1M");
+    }
 
     return true;
 }
 
 void connectTask(void* parameter) {
+    // the controller and host take a while to come up, this runs alongside the wifi bring-up
+    mqtt_send_debug("initializing bluetooth");
+    BLEDevice::init("");
+    pBLEScan = BLEDevice::getScan();
+    pBLEScan->setAdvertisedDeviceCallbacks(new BluetoothAdvertisedDeviceCallbacks());
+    pBLEScan->setActiveScan(true);
+    pBLEScan->setInterval(100);
+    pBLEScan->setWindow(80);
+
+    // everything else in range is dropped without a device being created for it; since the scan is active, a
+    // scannable advertisement without the service waits in a small fixed table for its scan response, so a piano
+    // that only lists the service there still passes
+    NimBLEScanFilter scan_filter;
+    scan_filter.addServiceUUID(serviceUUID);
+    pBLEScan->setFilter(scan_filter);
+    boot_mark(BOOT_BLE);
+
     while (true) {
         // If the flag "do_connect_ble" is true then we have scanned for and found the desired
         // BLE Server with which we wish to connect.  Now we connect to it.  Once we are
@@ -261,104 +527,310 @@ void connectTask(void* parameter) {
             do_connect_ble = false;
         }
 
-        // If we are connected to a peer BLE Server, update the characteristic each time we are reached
-        // with the current time since boot.
-        if (connected_ble) {
-            char buf[256];
-            snprintf(buf, 256, "Time since boot: %lu", (unsigned long)(esp_timer_get_time() / 1000000ULL));
-
-            // Set the characteristic's value to be the array of bytes that is actually a string.
-            /*** Note: write value now returns true if successful, false otherwise - try again or disconnect ***/
-            pRemoteCharacteristic->writeValue((uint8_t*)buf, strlen(buf), false);
-        } else if (do_scan) {
+        // Once connected, key events arrive through notifyCallback on their own.
+        if (!connected_ble && do_scan) {
             mqtt_send_debug("scanning...");
             pBLEScan->start(1);  // this is just eample to start scan after disconnect, most likely there is
                                  //  better way to do it in arduino
         }
 
-        vTaskDelay(2000 / portTICK_PERIOD_MS);  // Delay a second between loops.
+        // connect as soon as a scan finds the piano, otherwise check again in a while
+        xEventGroupWaitBits(s_boot_event_group, BOOT_PIANO_FOUND_BIT, pdTRUE, pdFALSE, 2000 / portTICK_PERIOD_MS);
     }
 
     vTaskDelete(NULL);
 }
 
-static void bt_init() {
-    mqtt_send_debug("initializing bluetooth");
-    BLEDevice::init("");
-    pBLEScan = BLEDevice::getScan();
-    pBLEScan->setAdvertisedDeviceCallbacks(new BluetoothAdvertisedDeviceCallbacks());
-    pBLEScan->setActiveScan(true);
-    pBLEScan->setInterval(100);
-    pBLEScan->setWindow(80);
-    xTaskCreate(connectTask, "bluetooth", 10240, NULL, 2, NULL);
+static void bt_init() { xTaskCreate(connectTask, "bluetooth", 10240, NULL, 2, NULL); }
+
+static key_batch<KEY_BATCH_MAX_RECORDS> key_batcher(KEY_BATCH_WINDOW_MS * 1000);
+
+// room for a frame header in front, for when the batch goes out as a binary frame
+static uint8_t mqtt_body_batch[EVENT_FRAME_HEADER_SIZE + key_batch<KEY_BATCH_MAX_RECORDS>::MAX_BODY_LENGTH];
+static uint8_t mqtt_body_binary[EVENT_FRAME_MAX_LENGTH];
+static uint32_t event_seq = 0;
+
+// notification receipt time of every event in the current batch, for the publish latency
+static int64_t batch_received_us[KEY_BATCH_MAX_RECORDS];
+
+void record_latency(const event_stamps_t* stamps, int64_t published_us) {
+    if (stamps->received_us == 0) {
+        return;
+    }
+
+    latency_decode.record(stamps->decoded_us - stamps->received_us);
+    latency_publish.record(published_us - stamps->received_us);
 }
 
-void blink_loop() {
-    int64_t cur_millis = esp_timer_get_time() / 1000;
-    if (cur_millis - last_blink >= 500) {
-        last_blink = cur_millis;
-        if (on) {
-            gpio_set_level(LED_BUILTIN, 0);
-        } else {
-            gpio_set_level(LED_BUILTIN, 1);
-        }
+int format_latency(char* buf, size_t len, const char* stage, latency_histogram* histogram) {
+    latency_summary_t summary;
+    histogram->drain(&summary);
+
+    return snprintf(buf, len, "\"%s\":{\"n\":%u,\"p50\":%u,\"p90\":%u,\"p99\":%u,\"max\":%u}", stage,
+                    summary.count, summary.p50_us, summary.p90_us, summary.p99_us, summary.max_us);
+}
+
+/**
+ * @brief Write how many scan results were allocated per second since the last call, how many of those missed the
+ * device pool and went to the heap, and how fragmented the heap is: the share of free bytes outside the largest block
+ */
+int format_scan_allocs(char* buf, size_t len) {
+    NimBLEAdvertisedDeviceAllocStats stats = BLEAdvertisedDevice::getAllocStats();
+    int64_t now_us = esp_timer_get_time();
+    float seconds = (now_us - last_alloc_stats_us) / 1e6f;
+
+    float allocs_per_s = (stats.poolAllocs + stats.heapAllocs - last_alloc_stats.poolAllocs -
+                          last_alloc_stats.heapAllocs) / seconds;
+    float heap_allocs_per_s = (stats.heapAllocs - last_alloc_stats.heapAllocs) / seconds;
+    last_alloc_stats = stats;
+    last_alloc_stats_us = now_us;
+
+    size_t free_bytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t largest_free = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    unsigned fragmentation = free_bytes > 0 ? 100 - largest_free * 100 / free_bytes : 0;
+
+    return snprintf(buf, len,
+                    "\"scan\":{\"allocs_per_s\":%.1f,\"heap_allocs_per_s\":%.1f,\"pool_in_use\":%u,"
+                    "\"pool_high_water\":%u},\"heap\":{\"free\":%u,\"largest_free\":%u,\"fragmentation_pct\":%u}",
+                    allocs_per_s, heap_allocs_per_s, stats.inUse, stats.highWater, (unsigned)free_bytes,
+                    (unsigned)largest_free, fragmentation);
+}
 
-        on = !on;
+/**
+ * @brief Summarize the latency of every stage since the last summary, in microseconds from notification receipt, e.g.
+ * {"decode":{"n":12,"p50":23,"p90":31,"p99":47,"max":52},"enqueue":{...},"publish":{...}}, followed by the scan
+ * allocation and heap figures of format_scan_allocs(), and hand it to the publisher task
+ *
+ * Runs on the esp_timer task, which the runtime timers, the key batch windows and the blink share, so it doesn't
+ * publish itself: that takes the MQTT client's lock and may wait on the socket.
+ */
+void summarize_metrics(void* arg) {
+    if (metrics_ready.load(std::memory_order_acquire)) {
+        // the last summary hasn't gone out yet, this window carries on into the next one
+        return;
     }
+
+    char* p = mqtt_body_metrics;
+    char* end = mqtt_body_metrics + MQTT_BODY_LENGTH;
+
+    p += snprintf(p, end - p, "{");
+    p += format_latency(p, end - p, "decode", &latency_decode);
+    p += snprintf(p, end - p, ",");
+    p += format_latency(p, end - p, "enqueue", &latency_enqueue);
+    p += snprintf(p, end - p, ",");
+    p += format_latency(p, end - p, "publish", &latency_publish);
+    p += snprintf(p, end - p, ",");
+    p += format_scan_allocs(p, end - p);
+    snprintf(p, end - p, "}");
+
+    metrics_ready.store(true, std::memory_order_release);
+    runtime_notify_publisher();
 }
 
-void blink_loop_task(void* param) {
-    while (true) {
-        blink_loop();
+/**
+ * @brief Publish the summary summarize_metrics() left on `DEVICE_ID/metrics`, if there is one
+ */
+void publish_metrics() {
+    if (!metrics_ready.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    snprintf(mqtt_topic_metrics, MQTT_TOPIC_LENGTH, "%s/metrics", DEVICE_ID);
+    esp_mqtt_client_publish(mqtt_client, mqtt_topic_metrics, mqtt_body_metrics, 0, MQTT_QOS, 0);
+    metrics_ready.store(false, std::memory_order_release);
+}
+
+/**
+ * @brief Publish how long it took from boot to the first event, and to every bring-up phase before it, once, on
+ * `DEVICE_ID/boot`, e.g. {"wifi":"cached","got_ip_ms":112,"first_publish_ms":2931,"timeline":{"nvs":4,...}}
+ */
+void report_boot(int64_t first_publish_us) {
+    fast_connect_stats_t wifi;
+    fast_connect_get_stats(&wifi);
+    boot_phases.mark(BOOT_FIRST_PUBLISH, first_publish_us);
+
+    char* p = mqtt_body_boot;
+    char* end = mqtt_body_boot + MQTT_BODY_LENGTH;
+    p += snprintf(p, end - p, "{\"wifi\":\"%s\",\"got_ip_ms\":%lld,\"first_publish_ms\":%lld,\"timeline\":",
+                  wifi.directed ? "cached" : wifi.fell_back ? "fallback" : "scan", (long long)(wifi.got_ip_us / 1000),
+                  (long long)(first_publish_us / 1000));
+    p += boot_phases.format(p, end - p);
+    snprintf(p, end - p, "}");
+    snprintf(mqtt_topic_boot, MQTT_TOPIC_LENGTH, "%s/boot", DEVICE_ID);
+    esp_mqtt_client_publish(mqtt_client, mqtt_topic_boot, mqtt_body_boot, 0, MQTT_QOS, 0);
+
+    boot_reported = true;
+}
 
-        vTaskDelay(pdMS_TO_TICKS(1));
+/**
+ * @return message id from esp_mqtt_client_publish, -1 on failure
+ */
+int publish_event(const producer_event_t* event) {
+    int msg_id;
+    if (EVENT_FORMAT_BINARY) {
+        snprintf(mqtt_topic, MQTT_TOPIC_LENGTH, "%s/%s/%s", DEVICE_ID, EVENT_BINARY_TOPIC_SEGMENT, event->event_id);
+        size_t len = event_encode(event, event_seq++, mqtt_body_binary, EVENT_FRAME_MAX_LENGTH);
+        msg_id = esp_mqtt_client_publish(mqtt_client, mqtt_topic, (const char*)mqtt_body_binary, len, MQTT_QOS, 0);
+    } else {
+        snprintf(mqtt_topic, MQTT_TOPIC_LENGTH, "%s/%s", DEVICE_ID, event->event_id);
+        format_event_body(event, mqtt_body, MQTT_BODY_LENGTH);
+        msg_id = esp_mqtt_client_publish(mqtt_client, mqtt_topic, mqtt_body, 0, MQTT_QOS, 0);
     }
+
+    if (msg_id < 0) {
+        return msg_id;
+    }
+
+    int64_t published_us = esp_timer_get_time();
+    record_latency(&event->stamps, published_us);
+    if (!boot_reported) {
+        report_boot(published_us);
+    }
+
+    return msg_id;
 }
 
 /**
- * @brief Perform the check of whatever event source the module uses, and if an event should be published, sets the
- * `mqtt_event_id` and `mqtt_body` strings appropriately
+ * @brief Whether events have to go to the event log rather than out, only while the broker is unreachable
  *
- * @return whether the module should publish an event
+ * Once it's back, live events go straight out while replay_events() catches up on the stored ones alongside them, so
+ * stored events can reach the broker after newer ones; their timestamps tell the order.
  */
-bool check_sensor() {
-    int64_t cur_millis = esp_timer_get_time() / 1000;
-    if (cur_millis - last_uptime_ping >= 1000) {
-        last_uptime_ping = cur_millis;
+bool store_events() { return event_log_mounted && !mqtt_connected; }
 
-        sprintf(mqtt_event_id, "uptime");
-        sprintf(mqtt_body, "%llu", cur_millis);
+void store_event(const producer_event_t* event) {
+    size_t len = event_log_encode(event, event_log_boot_id, event_log_record, EVENT_LOG_RECORD_MAX_LENGTH);
+    if (len > 0) {
+        event_log.append(event_log_record, len);
+    }
+}
 
-        return true;
+/**
+ * @brief Publish up to EVENT_LOG_REPLAY_BURST stored events, oldest first, while the outbox has room for them
+ *
+ * With events left, a full burst wakes the publisher again straight away, so live events that came in meanwhile go
+ * out before the next burst, and a full outbox has the broker's next acknowledgement wake it.
+ */
+void replay_events() {
+    if (!event_log_mounted || !mqtt_connected) {
+        return;
+    }
+
+    for (int i = 0; i < EVENT_LOG_REPLAY_BURST && !event_log.empty(); i++) {
+        // flagged before checking, so that an acknowledgement in between still wakes the publisher
+        replay_waiting.store(true);
+        if (esp_mqtt_client_get_outbox_size(mqtt_client) >= EVENT_LOG_REPLAY_OUTBOX_BYTES) {
+            return;
+        }
+        replay_waiting.store(false);
+
+        size_t len;
+        if (event_log.peek(event_log_record, EVENT_LOG_RECORD_MAX_LENGTH, &len) != FLASH_LOG_OK) {
+            return;
+        }
+
+        producer_event_t event;
+        // records that don't decode are dropped rather than retried forever
+        if (event_log_decode(event_log_record, len, event_log_boot_id, &event) && publish_event(&event) < 0) {
+            // the broker went away again, reconnecting wakes the publisher
+            return;
+        }
+        event_log.consume();
     }
 
-    return false;
+    if (!event_log.empty()) {
+        runtime_notify_publisher();
+    }
 }
 
-void sensor_loop() {
-    if (check_sensor()) {
-        sprintf(mqtt_topic, "%s/%s", DEVICE_ID, mqtt_event_id);
-        // esp_mqtt_client_publish(mqtt_client, mqtt_topic, mqtt_body, 0, MQTT_QOS, 0);
+void publish_key_batch() {
+    int64_t timestamp_us = key_batcher.base_us();
+    size_t count = key_batcher.count();
+    size_t len = key_batcher.encode(mqtt_body_batch + EVENT_FRAME_HEADER_SIZE);
+
+    int msg_id;
+    if (EVENT_FORMAT_BINARY) {
+        snprintf(mqtt_topic, MQTT_TOPIC_LENGTH, "%s/%s/keys", DEVICE_ID, EVENT_BINARY_TOPIC_SEGMENT);
+        event_write_header(mqtt_body_batch, EVENT_PAYLOAD_KEY_BATCH, len, event_seq++, timestamp_us);
+        msg_id = esp_mqtt_client_publish(mqtt_client, mqtt_topic, (const char*)mqtt_body_batch,
+                                         EVENT_FRAME_HEADER_SIZE + len, MQTT_QOS, 0);
+    } else {
+        snprintf(mqtt_topic, MQTT_TOPIC_LENGTH, "%s/keys", DEVICE_ID);
+        msg_id = esp_mqtt_client_publish(mqtt_client, mqtt_topic, (const char*)mqtt_body_batch + EVENT_FRAME_HEADER_SIZE,
+                                         len, MQTT_QOS, 0);
+    }
+
+    int64_t published_us = esp_timer_get_time();
+    for (size_t i = 0; i < count; i++) {
+        latency_publish.record(published_us - batch_received_us[i]);
+    }
+    if (!boot_reported && msg_id >= 0) {
+        report_boot(published_us);
     }
 }
 
-void sensor_loop_task(void* param) {
+void batch_key_event(const producer_event_t* event) {
+    if (!key_batcher.add(event->timestamp_us, event->key)) {
+        publish_key_batch();
+        key_batcher.add(event->timestamp_us, event->key);
+    }
+
+    // the publish stage is recorded once the batch goes out
+    latency_decode.record(event->stamps.decoded_us - event->stamps.received_us);
+    batch_received_us[key_batcher.count() - 1] = event->stamps.received_us;
+
+    if (key_batcher.full()) {
+        publish_key_batch();
+    }
+}
+
+void publisher_loop() {
+    producer_event_t event;
+    while (key_events.pop(&event)) {
+        if (store_events()) {
+            store_event(&event);
+        } else if (KEY_BATCH_WINDOW_MS > 0 && event.kind == EVENT_KEY) {
+            batch_key_event(&event);
+        } else if (publish_event(&event) < 0 && event_log_mounted) {
+            // the broker went away since the check, keep it for the replay
+            store_event(&event);
+        }
+    }
+
+    if (key_batcher.due(esp_timer_get_time())) {
+        publish_key_batch();
+    } else if (!key_batcher.empty()) {
+        // the window is far shorter than a tick, so the publisher can't just wait on a timeout for it
+        runtime_wake_publisher_at(key_batcher.deadline_us());
+    }
+
+    replay_events();
+    publish_metrics();
+}
+
+void publisher_loop_task(void* param) {
+    // events may have to be stored from the first one on
+    xEventGroupWaitBits(s_boot_event_group, BOOT_STORAGE_READY_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+
     while (true) {
-        sensor_loop();
+        runtime_wait_for_work(portMAX_DELAY);
 
-        vTaskDelay(pdMS_TO_TICKS(1));
+        publisher_loop();
     }
 }
 
 extern "C" void app_main();
 void app_main(void) {
-    // Initialize NVS
+    s_boot_event_group = xEventGroupCreate();
+
+    // Initialize NVS, both radios need it
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_ERROR_CHECK(nvs_flash_erase());
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    boot_mark(BOOT_NVS);
 
     // led
     if (BLINK) {
@@ -371,20 +843,36 @@ void app_main(void) {
         gpio_config(&io_conf);
     }
 
-    // network
+    // publisher loop, woken up by the bluetooth callbacks as soon as there is something to publish; it holds off until
+    // the event log is mounted
+    TaskHandle_t publisher_task;
+    xTaskCreate(publisher_loop_task, "publisher", 10240, NULL, PUBLISHER_PRIORITY, &publisher_task);
+    ESP_ERROR_CHECK(runtime_init(publisher_task));
+
+    // bluetooth, brought up and scanning in its own task
+    bt_init();
+
+    // network, associates in the background
     wifi_init();
     mqtt_init();
 
-    // bluetooth
-    bt_init();
+    // storage, mounted while the radios come up
+    event_log_init();
 
-    // blink loop
+    // blink
     if (BLINK) {
-        xTaskCreate(blink_loop_task, "blink", 10240, NULL, BLINK_PRIORITY, NULL);
+        ESP_ERROR_CHECK(runtime_start_blink(LED_BUILTIN, BLINK_PERIOD_MS * 1000));
     }
 
-    // sensor loop
-    xTaskCreate(sensor_loop_task, "sensor", 10240, NULL, SENSOR_PRIORITY, NULL);
+    // metrics
+    esp_timer_create_args_t metrics_timer_args = {};
+    metrics_timer_args.callback = summarize_metrics;
+    metrics_timer_args.name = "metrics";
+    esp_timer_handle_t metrics_timer;
+    ESP_ERROR_CHECK(esp_timer_create(&metrics_timer_args, &metrics_timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(metrics_timer, METRICS_PERIOD_MS * 1000));
 
-    vTaskDelay(1);
+    // a connect attempt before there is an IP address fails and costs a whole reconnect timeout
+    xEventGroupWaitBits(s_wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT, pdFALSE, pdFALSE, portMAX_DELAY);
+    esp_mqtt_client_start(mqtt_client);
 }
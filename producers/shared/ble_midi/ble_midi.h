@@ -0,0 +1,255 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * BLE-MIDI packet layout (MIDI over Bluetooth Low Energy spec):
+ *
+ *   header     1tHHHHHH   H: upper 6 bits of a 13-bit millisecond timestamp
+ *   timestamp  1LLLLLLL   L: lower 7 bits, precedes every message that doesn't use running status
+ *   message    a regular MIDI message; with running status the status byte is omitted, and so may be the timestamp
+ *
+ * When a timestamp's lower bits are smaller than those of the previous one in the same packet, the upper bits
+ * have rolled over. System exclusive messages end with a timestamp followed by 0xF7, and may continue across
+ * packets, in which case the continuation packet has data right after the header. Real-time messages may be
+ * interleaved with system exclusive data, each behind its own timestamp.
+ */
+#define BLE_MIDI_SERVICE_UUID "03b80e5a-ede8-4b33-a751-6ce34ec4c700"
+#define BLE_MIDI_CHARACTERISTIC_UUID "7772e5db-3868-4112-a1a9-f2669d106bf3"
+
+#define BLE_MIDI_TIMESTAMP_MASK 0x1FFF
+
+#define BLE_MIDI_CC_SUSTAIN 64
+
+typedef enum : uint8_t {
+    BLE_MIDI_NOTE_OFF,  // also a note on with zero velocity
+    BLE_MIDI_NOTE_ON,
+    BLE_MIDI_SUSTAIN,  // control change 64
+    BLE_MIDI_CONTROL_CHANGE,
+    BLE_MIDI_OTHER,  // any other channel or system message, see `status`
+} ble_midi_event_type_t;
+
+typedef struct {
+    uint16_t timestamp_ms;  // 13 bits, wraps every 8192 ms
+    ble_midi_event_type_t type;
+    uint8_t status;
+    uint8_t channel;  // 0-15, channel messages only
+    uint8_t data1;    // note or controller number
+    uint8_t data2;    // velocity or controller value
+} ble_midi_event_t;
+
+/**
+ * @brief Milliseconds from timestamp `from` to timestamp `to`, accounting for the 13-bit wraparound
+ */
+static inline uint16_t ble_midi_elapsed_ms(uint16_t from, uint16_t to) {
+    return (uint16_t)((to - from) & BLE_MIDI_TIMESTAMP_MASK);
+}
+
+/**
+ * @brief Decodes the messages of one BLE-MIDI packet straight out of the notification buffer, without copying it
+ *
+ * Every read is bounds checked against `len`, so any byte sequence is safe to feed it; a malformed packet just ends
+ * the iteration early.
+ */
+class ble_midi_parser {
+   public:
+    ble_midi_parser(const uint8_t* data, size_t len) : m_p(data), m_end(data + len) {
+        if (len == 0 || (data[0] & 0xC0) != 0x80) {
+            m_p = m_end;
+            return;
+        }
+
+        m_ts_high = data[0] & 0x3F;
+        m_p++;
+
+        // data straight after the header continues a system exclusive message from the previous packet
+        if (m_p < m_end && !(*m_p & 0x80)) {
+            m_in_sysex = true;
+        }
+    }
+
+    /**
+     * @brief Decode the next message
+     *
+     * @return false once the packet is exhausted, or at the first malformed message
+     */
+    bool next(ble_midi_event_t* event) {
+        while (m_p < m_end) {
+            if (m_in_sysex) {
+                uint8_t realtime;
+                if (skip_sysex(&realtime)) {
+                    return emit(event, realtime, 0, 0);
+                }
+                continue;
+            }
+
+            uint8_t b = *m_p;
+            if (b & 0x80) {
+                // timestamp, then either a status byte or running status data
+                set_timestamp_low(b & 0x7F);
+                m_p++;
+                if (m_p == m_end) {
+                    return false;
+                }
+
+                b = *m_p;
+                if (b & 0x80) {
+                    m_p++;
+                    if (b == 0xF0) {
+                        m_in_sysex = true;
+                        m_running_status = 0;
+                        continue;
+                    }
+                    if (b >= 0xF8) {
+                        // real-time messages don't touch running status
+                        return emit(event, b, 0, 0);
+                    }
+                    if (b >= 0xF0) {
+                        m_running_status = 0;
+                    } else {
+                        m_running_status = b;
+                    }
+                    return read_message(event, b);
+                }
+            }
+
+            // running status, with or without a fresh timestamp in front
+            if (m_running_status == 0) {
+                m_p = m_end;
+                return false;
+            }
+            return read_message(event, m_running_status);
+        }
+
+        return false;
+    }
+
+    /** @brief Timestamp of the first message in the packet, once `next` has been called at least once */
+    uint16_t first_timestamp_ms() const { return m_first_ts; }
+
+   private:
+    static int data_length(uint8_t status) {
+        if (status < 0xF0) {
+            uint8_t kind = status & 0xF0;
+            return (kind == 0xC0 || kind == 0xD0) ? 1 : 2;
+        }
+        switch (status) {
+            case 0xF1:
+            case 0xF3:
+                return 1;
+            case 0xF2:
+                return 2;
+            default:
+                return 0;
+        }
+    }
+
+    void set_timestamp_low(uint8_t low) {
+        if (m_have_ts && low < m_ts_low) {
+            m_ts_high = (m_ts_high + 1) & 0x3F;
+        }
+        m_ts_low = low;
+        m_ts = (uint16_t)((m_ts_high << 7) | low);
+        if (!m_have_ts) {
+            m_first_ts = m_ts;
+            m_have_ts = true;
+        }
+    }
+
+    bool read_message(ble_midi_event_t* event, uint8_t status) {
+        int n = data_length(status);
+        if (m_end - m_p < n) {
+            m_p = m_end;
+            return false;
+        }
+
+        uint8_t data[2] = {0, 0};
+        for (int i = 0; i < n; i++) {
+            if (m_p[i] & 0x80) {
+                m_p = m_end;
+                return false;
+            }
+            data[i] = m_p[i];
+        }
+        m_p += n;
+
+        return emit(event, status, data[0], data[1]);
+    }
+
+    bool emit(ble_midi_event_t* event, uint8_t status, uint8_t data1, uint8_t data2) {
+        event->timestamp_ms = m_ts;
+        event->status = status;
+        event->channel = status < 0xF0 ? (status & 0x0F) : 0;
+        event->data1 = data1;
+        event->data2 = data2;
+
+        switch (status & 0xF0) {
+            case 0x80:
+                event->type = BLE_MIDI_NOTE_OFF;
+                break;
+            case 0x90:
+                event->type = data2 == 0 ? BLE_MIDI_NOTE_OFF : BLE_MIDI_NOTE_ON;
+                break;
+            case 0xB0:
+                event->type = data1 == BLE_MIDI_CC_SUSTAIN ? BLE_MIDI_SUSTAIN : BLE_MIDI_CONTROL_CHANGE;
+                break;
+            default:
+                event->type = BLE_MIDI_OTHER;
+                break;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Skip system exclusive data, up to its end or the next real-time message interleaved with it
+     *
+     * @return true with `realtime` set if it stopped at a real-time message, which the message carries on after
+     */
+    bool skip_sysex(uint8_t* realtime) {
+        while (m_p < m_end) {
+            if (!(*m_p & 0x80)) {
+                m_p++;
+                continue;
+            }
+
+            // a timestamp, followed by the end of the message, a real-time message, or a status byte that cuts the
+            // message short
+            if (m_end - m_p < 2) {
+                m_p = m_end;
+                return false;
+            }
+            uint8_t b = m_p[1];
+            if ((b & 0x80) && b != 0xF7 && b < 0xF8) {
+                // left for next() to read as the message that follows
+                m_in_sysex = false;
+                return false;
+            }
+
+            set_timestamp_low(*m_p & 0x7F);
+            m_p += 2;
+            if (b == 0xF7) {
+                m_in_sysex = false;
+                return false;
+            }
+            if (b >= 0xF8) {
+                *realtime = b;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const uint8_t* m_p;
+    const uint8_t* m_end;
+
+    uint8_t m_ts_high = 0;
+    uint8_t m_ts_low = 0;
+    uint16_t m_ts = 0;
+    uint16_t m_first_ts = 0;
+    bool m_have_ts = false;
+
+    uint8_t m_running_status = 0;
+    bool m_in_sysex = false;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+
+/**
+ * @brief When each bring-up phase of a producer first completed, for measuring and cutting cold-start time
+ *
+ * Phases may be marked from any task; only the first mark of each phase counts, so a later reconnect doesn't move it.
+ *
+ * @tparam N number of phases
+ */
+template <size_t N>
+class boot_timeline {
+   public:
+    /** @param names name of every phase, in the order of their indices */
+    explicit boot_timeline(const char* const (&names)[N]) : m_names(names) {}
+
+    /** @brief Record that `phase` completed at `now_us`, unless it already had */
+    void mark(size_t phase, int64_t now_us) {
+        int64_t unmarked = 0;
+        // 0 means unmarked, so a mark at exactly 0 moves to 1 microsecond
+        m_at[phase].compare_exchange_strong(unmarked, now_us > 0 ? now_us : 1, std::memory_order_relaxed);
+    }
+
+    /** @brief When `phase` completed, 0 if it hasn't yet */
+    int64_t at(size_t phase) const { return m_at[phase].load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Write the marked phases as a JSON object of milliseconds since boot, e.g. {"nvs":4,"got_ip":1502}
+     *
+     * @return number of characters written, as snprintf
+     */
+    int format(char* buf, size_t len) const {
+        int n = snprintf(buf, len, "{");
+        bool first = true;
+        for (size_t i = 0; i < N; i++) {
+            int64_t at_us = at(i);
+            if (at_us == 0) {
+                continue;
+            }
+            n += snprintf(buf + (n < (int)len ? n : len), n < (int)len ? len - n : 0, "%s\"%s\":%lld",
+                          first ? "" : ",", m_names[i], (long long)(at_us / 1000));
+            first = false;
+        }
+        n += snprintf(buf + (n < (int)len ? n : len), n < (int)len ? len - n : 0, "}");
+
+        return n;
+    }
+
+   private:
+    const char* const* m_names;
+    std::atomic<int64_t> m_at[N] = {};
+};
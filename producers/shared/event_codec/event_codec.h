@@ -0,0 +1,181 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "producer_event.h"
+
+/*
+ * Binary event frame, all integers little-endian:
+ *
+ *   offset 0   uint8   format version, EVENT_CODEC_VERSION
+ *   offset 1   uint8   payload type, event_payload_t
+ *   offset 2   uint16  payload length in bytes
+ *   offset 4   uint32  per-device sequence number, incremented for every frame published
+ *   offset 8   int64   event timestamp, microseconds since boot
+ *   offset 16  payload
+ *
+ * Payloads by type:
+ *   EVENT_PAYLOAD_TEXT       the text body, not null terminated
+ *   EVENT_PAYLOAD_KEY        uint8 key, uint8 state, uint8 velocity
+ *   EVENT_PAYLOAD_KEY_BATCH  a key batch, see key_batch.h
+ *   EVENT_PAYLOAD_CONTROL    uint8 controller, uint8 value
+ *
+ * Decoders must reject frames with a version they don't know, and skip payload types they don't know.
+ *
+ * Producers publish binary frames on `DEVICE_ID/bin/<event>` and text bodies on `DEVICE_ID/<event>`, so the two
+ * formats can coexist on one broker.
+ */
+#define EVENT_CODEC_VERSION 1
+
+#define EVENT_FRAME_HEADER_SIZE 16
+#define EVENT_FRAME_MAX_LENGTH (EVENT_FRAME_HEADER_SIZE + EVENT_BODY_LENGTH)
+
+#define EVENT_BINARY_TOPIC_SEGMENT "bin"
+
+typedef enum : uint8_t {
+    EVENT_PAYLOAD_TEXT = 0,
+    EVENT_PAYLOAD_KEY = 1,
+    EVENT_PAYLOAD_KEY_BATCH = 2,
+    EVENT_PAYLOAD_CONTROL = 3,
+} event_payload_t;
+
+typedef struct {
+    uint8_t version;
+    uint8_t type;
+    uint16_t length;
+    uint32_t seq;
+    int64_t timestamp_us;
+    const uint8_t* payload;  // points into the decoded buffer, nothing is copied
+} event_frame_t;
+
+static inline void event_codec_put_le(uint8_t* p, uint64_t v, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static inline uint64_t event_codec_get_le(const uint8_t* p, size_t n) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; i++) {
+        v |= (uint64_t)p[i] << (8 * i);
+    }
+    return v;
+}
+
+/**
+ * @brief Write a frame header into the first `EVENT_FRAME_HEADER_SIZE` bytes of `buf`, for payloads that were already
+ * written in place right after it
+ */
+static inline void event_write_header(uint8_t* buf, uint8_t type, uint16_t length, uint32_t seq,
+                                      int64_t timestamp_us) {
+    buf[0] = EVENT_CODEC_VERSION;
+    buf[1] = type;
+    event_codec_put_le(buf + 2, length, 2);
+    event_codec_put_le(buf + 4, seq, 4);
+    event_codec_put_le(buf + 8, (uint64_t)timestamp_us, 8);
+}
+
+/**
+ * @brief Encode `event` as a binary frame
+ *
+ * @return number of bytes written, 0 if `len` is too small
+ */
+static inline size_t event_encode(const producer_event_t* event, uint32_t seq, uint8_t* buf, size_t len) {
+    uint8_t type;
+    size_t payload_len;
+    switch (event->kind) {
+        case EVENT_KEY:
+            type = EVENT_PAYLOAD_KEY;
+            payload_len = 3;
+            break;
+        case EVENT_CONTROL:
+            type = EVENT_PAYLOAD_CONTROL;
+            payload_len = 2;
+            break;
+        case EVENT_TEXT:
+        default:
+            type = EVENT_PAYLOAD_TEXT;
+            payload_len = strnlen(event->body, EVENT_BODY_LENGTH);
+            break;
+    }
+
+    if (len < EVENT_FRAME_HEADER_SIZE + payload_len) {
+        return 0;
+    }
+
+    uint8_t* payload = buf + EVENT_FRAME_HEADER_SIZE;
+    if (type == EVENT_PAYLOAD_KEY) {
+        payload[0] = event->key.key;
+        payload[1] = event->key.state;
+        payload[2] = event->key.velocity;
+    } else if (type == EVENT_PAYLOAD_CONTROL) {
+        payload[0] = event->control.controller;
+        payload[1] = event->control.value;
+    } else {
+        memcpy(payload, event->body, payload_len);
+    }
+
+    event_write_header(buf, type, (uint16_t)payload_len, seq, event->timestamp_us);
+
+    return EVENT_FRAME_HEADER_SIZE + payload_len;
+}
+
+/**
+ * @brief Parse the frame at the start of `buf`
+ *
+ * @return false if `buf` doesn't hold a complete frame of a known version
+ */
+static inline bool event_decode(const uint8_t* buf, size_t len, event_frame_t* frame) {
+    if (len < EVENT_FRAME_HEADER_SIZE || buf[0] != EVENT_CODEC_VERSION) {
+        return false;
+    }
+
+    frame->version = buf[0];
+    frame->type = buf[1];
+    frame->length = (uint16_t)event_codec_get_le(buf + 2, 2);
+    frame->seq = (uint32_t)event_codec_get_le(buf + 4, 4);
+    frame->timestamp_us = (int64_t)event_codec_get_le(buf + 8, 8);
+    frame->payload = buf + EVENT_FRAME_HEADER_SIZE;
+
+    return len - EVENT_FRAME_HEADER_SIZE >= frame->length;
+}
+
+/**
+ * @brief Turn a decoded single-event frame back into a `producer_event_t`, `event_id` is left untouched
+ *
+ * @return false for payload types that don't map onto a single event
+ */
+static inline bool event_from_frame(const event_frame_t* frame, producer_event_t* event) {
+    event->timestamp_us = frame->timestamp_us;
+
+    switch (frame->type) {
+        case EVENT_PAYLOAD_KEY:
+            if (frame->length < 3) {
+                return false;
+            }
+            event->kind = EVENT_KEY;
+            event->key.key = frame->payload[0];
+            event->key.state = frame->payload[1];
+            event->key.velocity = frame->payload[2];
+            return true;
+        case EVENT_PAYLOAD_CONTROL:
+            if (frame->length < 2) {
+                return false;
+            }
+            event->kind = EVENT_CONTROL;
+            event->control.controller = frame->payload[0];
+            event->control.value = frame->payload[1];
+            return true;
+        case EVENT_PAYLOAD_TEXT: {
+            size_t n = frame->length < EVENT_BODY_LENGTH - 1 ? frame->length : EVENT_BODY_LENGTH - 1;
+            event->kind = EVENT_TEXT;
+            memcpy(event->body, frame->payload, n);
+            event->body[n] = '\0';
+            return true;
+        }
+        default:
+            return false;
+    }
+}
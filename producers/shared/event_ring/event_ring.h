@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+/**
+ * @brief Fixed-capacity, allocation-free single-producer single-consumer ring
+ *
+ * Exactly one task may call `push` and exactly one (other) task may call `pop`. Neither side ever blocks: a push into
+ * a full ring is dropped and counted, so a slow consumer can never stall the producer. Has no platform dependencies,
+ * so it builds the same on the ESP32 and on a Linux host.
+ *
+ * @tparam T item type, copied in and out by value
+ * @tparam N capacity, must be a power of two
+ */
+template <typename T, size_t N>
+class event_ring {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "event_ring capacity must be a power of two");
+
+   public:
+    /**
+     * @brief Append an item, producer side only
+     *
+     * @return false if the ring was full and the item was dropped
+     */
+    bool push(const T& item) {
+        uint32_t head = m_head.load(std::memory_order_relaxed);
+        uint32_t tail = m_tail.load(std::memory_order_acquire);
+        if (head - tail >= N) {
+            m_drops.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        m_items[head & (N - 1)] = item;
+        m_head.store(head + 1, std::memory_order_release);
+
+        // only the producer writes the high-water mark, so a plain compare is enough
+        uint32_t depth = head + 1 - tail;
+        if (depth > m_high_water.load(std::memory_order_relaxed)) {
+            m_high_water.store(depth, std::memory_order_relaxed);
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Take the oldest item, consumer side only
+     *
+     * @return false if the ring was empty
+     */
+    bool pop(T* item) {
+        uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        uint32_t head = m_head.load(std::memory_order_acquire);
+        if (head == tail) {
+            return false;
+        }
+
+        *item = m_items[tail & (N - 1)];
+        m_tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /** @brief Number of items currently queued, exact only when called from the producer or the consumer */
+    size_t depth() const {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    /** @brief Largest depth seen since construction */
+    size_t high_water() const { return m_high_water.load(std::memory_order_relaxed); }
+
+    /** @brief Number of items rejected because the ring was full */
+    uint32_t drops() const { return m_drops.load(std::memory_order_relaxed); }
+
+    static constexpr size_t capacity() { return N; }
+
+   private:
+    T m_items[N];
+
+    // producer and consumer indices live on separate cache lines so they don't bounce between cores
+    alignas(64) std::atomic<uint32_t> m_head{0};
+    std::atomic<uint32_t> m_high_water{0};
+    std::atomic<uint32_t> m_drops{0};
+
+    alignas(64) std::atomic<uint32_t> m_tail{0};
+};
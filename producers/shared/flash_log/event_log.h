@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "event_codec.h"
+#include "producer_event.h"
+
+/*
+ * Layout of an event stored in a flash_log record:
+ *
+ *   offset 0  uint8   length of the event id
+ *   offset 1  event id, not null terminated
+ *   then      the event as an event_codec frame
+ *   then      uint32  boot id of the boot that stored it, little-endian
+ *             int64   stamps.received_us, little-endian
+ *             int64   stamps.decoded_us, little-endian
+ *
+ * Records stored before the stamps were kept end with the frame.
+ */
+#define EVENT_LOG_STAMPS_LENGTH (4 + 8 + 8)
+#define EVENT_LOG_RECORD_MAX_LENGTH (1 + EVENT_ID_LENGTH + EVENT_FRAME_MAX_LENGTH + EVENT_LOG_STAMPS_LENGTH)
+
+/**
+ * @brief Store `event` along with its stage stamps; `boot_id` tells this boot's records from those of earlier ones,
+ * whose stamps are on another esp_timer time base
+ *
+ * @return number of bytes written, 0 if `cap` is too small
+ */
+static inline size_t event_log_encode(const producer_event_t* event, uint32_t boot_id, uint8_t* buf, size_t cap) {
+    size_t id_len = strnlen(event->event_id, EVENT_ID_LENGTH - 1);
+    if (cap < 1 + id_len + EVENT_LOG_STAMPS_LENGTH) {
+        return 0;
+    }
+
+    buf[0] = (uint8_t)id_len;
+    memcpy(buf + 1, event->event_id, id_len);
+
+    // the sequence number is assigned when the event is actually published
+    size_t frame_len = event_encode(event, 0, buf + 1 + id_len, cap - 1 - id_len - EVENT_LOG_STAMPS_LENGTH);
+    if (frame_len == 0) {
+        return 0;
+    }
+
+    uint8_t* stamps = buf + 1 + id_len + frame_len;
+    event_codec_put_le(stamps, boot_id, 4);
+    event_codec_put_le(stamps + 4, (uint64_t)event->stamps.received_us, 8);
+    event_codec_put_le(stamps + 12, (uint64_t)event->stamps.decoded_us, 8);
+
+    return 1 + id_len + frame_len + EVENT_LOG_STAMPS_LENGTH;
+}
+
+/**
+ * @brief Decode a stored event; its stage stamps are only kept if it was stored with `boot_id`, otherwise they are
+ * cleared, since they refer to a previous boot
+ */
+static inline bool event_log_decode(const uint8_t* buf, size_t len, uint32_t boot_id, producer_event_t* event) {
+    if (len < 1 || buf[0] >= EVENT_ID_LENGTH || len < 1 + (size_t)buf[0]) {
+        return false;
+    }
+
+    size_t id_len = buf[0];
+    event_frame_t frame;
+    if (!event_decode(buf + 1 + id_len, len - 1 - id_len, &frame) || !event_from_frame(&frame, event)) {
+        return false;
+    }
+
+    memcpy(event->event_id, buf + 1, id_len);
+    event->event_id[id_len] = '\0';
+    memset(&event->stamps, 0, sizeof(event->stamps));
+
+    size_t stamps_at = 1 + id_len + EVENT_FRAME_HEADER_SIZE + frame.length;
+    if (len - stamps_at >= EVENT_LOG_STAMPS_LENGTH && event_codec_get_le(buf + stamps_at, 4) == boot_id) {
+        event->stamps.received_us = (int64_t)event_codec_get_le(buf + stamps_at + 4, 8);
+        event->stamps.decoded_us = (int64_t)event_codec_get_le(buf + stamps_at + 12, 8);
+    }
+
+    return true;
+}
@@ -0,0 +1,420 @@
+#include "flash_log.h"
+
+#include <string.h>
+
+static void put_le(uint8_t* p, uint32_t v, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint32_t get_le(const uint8_t* p, size_t n) {
+    uint32_t v = 0;
+    for (size_t i = 0; i < n; i++) {
+        v |= (uint32_t)p[i] << (8 * i);
+    }
+    return v;
+}
+
+uint8_t flash_log::crc8(const uint8_t* data, size_t len) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+int flash_log::read_sector_seq(size_t sector, uint32_t* seq) {
+    uint8_t header[FLASH_LOG_SECTOR_HEADER_SIZE];
+    if (m_io.read(m_io.ctx, sector * FLASH_LOG_SECTOR_SIZE, header, sizeof(header)) != 0) {
+        return FLASH_LOG_ERR_IO;
+    }
+
+    if (get_le(header, 4) != FLASH_LOG_MAGIC || header[4] != FLASH_LOG_VERSION) {
+        return FLASH_LOG_ERR_INVALID;
+    }
+
+    *seq = get_le(header + 8, 4);
+    return FLASH_LOG_OK;
+}
+
+/**
+ * @return FLASH_LOG_EMPTY at the end of the sector's records
+ */
+int flash_log::read_record(size_t sector, size_t offset, record_header* header) {
+    if (offset + FLASH_LOG_RECORD_HEADER_SIZE > sector_end(sector)) {
+        return FLASH_LOG_EMPTY;
+    }
+
+    uint8_t raw[FLASH_LOG_RECORD_HEADER_SIZE];
+    if (m_io.read(m_io.ctx, sector * FLASH_LOG_SECTOR_SIZE + offset, raw, sizeof(raw)) != 0) {
+        return FLASH_LOG_ERR_IO;
+    }
+
+    header->length = (uint16_t)get_le(raw, 2);
+    header->state = raw[2];
+    header->crc = raw[3];
+
+    // an erased length is the end of the written part, anything else that doesn't fit is garbage we can't step over
+    if (header->length == 0xFFFF || offset + record_size(header->length) > FLASH_LOG_SECTOR_SIZE) {
+        return FLASH_LOG_EMPTY;
+    }
+
+    return FLASH_LOG_OK;
+}
+
+size_t flash_log::sector_end(size_t sector) const {
+    return sector == m_head_sector ? m_head_offset : FLASH_LOG_SECTOR_SIZE;
+}
+
+/**
+ * @brief Find the first committed record at or after `sector`/`offset`, stopping at the write position
+ */
+int flash_log::find_committed(size_t* sector, size_t* offset, bool* found) {
+    size_t s = *sector;
+    size_t off = *offset;
+
+    for (size_t visited = 0; visited <= m_sector_count; visited++) {
+        record_header header;
+        int err;
+        while ((err = read_record(s, off, &header)) == FLASH_LOG_OK) {
+            if (header.state == FLASH_LOG_RECORD_COMMITTED) {
+                *sector = s;
+                *offset = off;
+                *found = true;
+                return FLASH_LOG_OK;
+            }
+            off += record_size(header.length);
+        }
+        if (err != FLASH_LOG_EMPTY) {
+            return err;
+        }
+
+        if (s == m_head_sector) {
+            break;
+        }
+
+        // sectors that were never written in this pass hold no records
+        s = (s + 1) % m_sector_count;
+        uint32_t seq;
+        off = read_sector_seq(s, &seq) == FLASH_LOG_OK ? FLASH_LOG_SECTOR_HEADER_SIZE : FLASH_LOG_SECTOR_SIZE;
+    }
+
+    *found = false;
+    return FLASH_LOG_OK;
+}
+
+int flash_log::count_committed(size_t sector, uint32_t* count) {
+    *count = 0;
+
+    uint32_t seq;
+    if (read_sector_seq(sector, &seq) != FLASH_LOG_OK) {
+        return FLASH_LOG_OK;
+    }
+
+    size_t off = FLASH_LOG_SECTOR_HEADER_SIZE;
+    record_header header;
+    int err;
+    while ((err = read_record(sector, off, &header)) == FLASH_LOG_OK) {
+        if (header.state == FLASH_LOG_RECORD_COMMITTED) {
+            (*count)++;
+        }
+        off += record_size(header.length);
+    }
+
+    return err == FLASH_LOG_EMPTY ? FLASH_LOG_OK : err;
+}
+
+int flash_log::start_sector(size_t sector) {
+    if (m_io.erase_sector(m_io.ctx, sector * FLASH_LOG_SECTOR_SIZE) != 0) {
+        return FLASH_LOG_ERR_IO;
+    }
+
+    uint8_t header[FLASH_LOG_SECTOR_HEADER_SIZE];
+    memset(header, 0xFF, sizeof(header));
+    put_le(header, FLASH_LOG_MAGIC, 4);
+    header[4] = FLASH_LOG_VERSION;
+    put_le(header + 8, m_head_seq + 1, 4);
+    if (m_io.write(m_io.ctx, sector * FLASH_LOG_SECTOR_SIZE, header, sizeof(header)) != 0) {
+        return FLASH_LOG_ERR_IO;
+    }
+
+    m_head_seq++;
+    m_head_sector = sector;
+    m_head_offset = FLASH_LOG_SECTOR_HEADER_SIZE;
+
+    return FLASH_LOG_OK;
+}
+
+int flash_log::mount(const flash_log_io_t& io) {
+    m_io = io;
+    m_sector_count = io.size / FLASH_LOG_SECTOR_SIZE;
+    m_pending = 0;
+    m_stats = {};
+
+    if (m_sector_count < 2) {
+        return FLASH_LOG_ERR_INVALID;
+    }
+
+    // the newest sector is where writing continues
+    bool any = false;
+    for (size_t s = 0; s < m_sector_count; s++) {
+        uint32_t seq;
+        int err = read_sector_seq(s, &seq);
+        if (err == FLASH_LOG_ERR_IO) {
+            return err;
+        }
+        if (err == FLASH_LOG_OK && (!any || seq > m_head_seq)) {
+            any = true;
+            m_head_seq = seq;
+            m_head_sector = s;
+        }
+    }
+
+    if (!any) {
+        m_head_seq = 0;
+        int err = start_sector(0);
+        if (err != FLASH_LOG_OK) {
+            return err;
+        }
+
+        m_tail_sector = m_head_sector;
+        m_tail_offset = m_head_offset;
+        return FLASH_LOG_OK;
+    }
+
+    // find the end of the newest sector's records, read_record stops at sector_end so lift it while scanning
+    m_head_offset = FLASH_LOG_SECTOR_SIZE;
+    size_t off = FLASH_LOG_SECTOR_HEADER_SIZE;
+    record_header header;
+    int err;
+    while ((err = read_record(m_head_sector, off, &header)) == FLASH_LOG_OK) {
+        off += record_size(header.length);
+    }
+    if (err != FLASH_LOG_EMPTY) {
+        return err;
+    }
+    m_head_offset = off;
+
+    // a length that isn't erased but doesn't fit either is garbage that can't be written over, so move on
+    uint8_t raw[2];
+    if (off + FLASH_LOG_RECORD_HEADER_SIZE <= FLASH_LOG_SECTOR_SIZE) {
+        if (m_io.read(m_io.ctx, m_head_sector * FLASH_LOG_SECTOR_SIZE + off, raw, sizeof(raw)) != 0) {
+            return FLASH_LOG_ERR_IO;
+        }
+        if (get_le(raw, 2) != 0xFFFF) {
+            m_head_offset = FLASH_LOG_SECTOR_SIZE;
+        }
+    }
+
+    // the oldest unreplayed record is the first committed one after the newest sector, going around the ring
+    for (size_t i = 1; i <= m_sector_count; i++) {
+        uint32_t count;
+        err = count_committed((m_head_sector + i) % m_sector_count, &count);
+        if (err != FLASH_LOG_OK) {
+            return err;
+        }
+        m_pending += count;
+    }
+
+    m_tail_sector = (m_head_sector + 1) % m_sector_count;
+    uint32_t seq;
+    m_tail_offset =
+        read_sector_seq(m_tail_sector, &seq) == FLASH_LOG_OK ? FLASH_LOG_SECTOR_HEADER_SIZE : FLASH_LOG_SECTOR_SIZE;
+
+    bool found;
+    err = find_committed(&m_tail_sector, &m_tail_offset, &found);
+    if (err != FLASH_LOG_OK) {
+        return err;
+    }
+    if (!found) {
+        m_tail_sector = m_head_sector;
+        m_tail_offset = m_head_offset;
+    }
+
+    return FLASH_LOG_OK;
+}
+
+int flash_log::append(const uint8_t* data, size_t len) {
+    if (len > FLASH_LOG_MAX_RECORD_LENGTH) {
+        return FLASH_LOG_ERR_INVALID;
+    }
+
+    size_t size = record_size(len);
+    if (m_head_offset + size > FLASH_LOG_SECTOR_SIZE) {
+        size_t next = (m_head_sector + 1) % m_sector_count;
+
+        // wrapping onto records that were never replayed, the oldest ones give way
+        uint32_t lost = 0;
+        int err = count_committed(next, &lost);
+        if (err != FLASH_LOG_OK) {
+            return err;
+        }
+        m_pending -= lost;
+        m_stats.dropped += lost;
+
+        err = start_sector(next);
+        if (err != FLASH_LOG_OK) {
+            return err;
+        }
+
+        if (lost > 0) {
+            m_tail_sector = (next + 1) % m_sector_count;
+            uint32_t seq;
+            m_tail_offset = read_sector_seq(m_tail_sector, &seq) == FLASH_LOG_OK ? FLASH_LOG_SECTOR_HEADER_SIZE
+                                                                                 : FLASH_LOG_SECTOR_SIZE;
+            bool found;
+            err = find_committed(&m_tail_sector, &m_tail_offset, &found);
+            if (err != FLASH_LOG_OK) {
+                return err;
+            }
+            if (!found) {
+                m_tail_sector = m_head_sector;
+                m_tail_offset = m_head_offset;
+            }
+        }
+    }
+
+    size_t base = m_head_sector * FLASH_LOG_SECTOR_SIZE + m_head_offset;
+
+    uint8_t header[FLASH_LOG_RECORD_HEADER_SIZE];
+    put_le(header, (uint32_t)len, 2);
+    header[2] = FLASH_LOG_RECORD_ERASED;
+    header[3] = crc8(data, len);
+    if (m_io.write(m_io.ctx, base, header, sizeof(header)) != 0 ||
+        m_io.write(m_io.ctx, base + FLASH_LOG_RECORD_HEADER_SIZE, data, len) != 0) {
+        return FLASH_LOG_ERR_IO;
+    }
+
+    uint8_t state = FLASH_LOG_RECORD_COMMITTED;
+    if (m_io.write(m_io.ctx, base + 2, &state, 1) != 0) {
+        return FLASH_LOG_ERR_IO;
+    }
+
+    if (m_pending == 0) {
+        m_tail_sector = m_head_sector;
+        m_tail_offset = m_head_offset;
+    }
+
+    m_head_offset += size;
+    m_pending++;
+    m_stats.appended++;
+
+    return FLASH_LOG_OK;
+}
+
+int flash_log::peek(uint8_t* buf, size_t cap, size_t* len) {
+    while (m_pending > 0) {
+        record_header header;
+        int err = read_record(m_tail_sector, m_tail_offset, &header);
+        if (err != FLASH_LOG_OK) {
+            return err == FLASH_LOG_EMPTY ? FLASH_LOG_ERR_INVALID : err;
+        }
+        if (header.length > cap) {
+            return FLASH_LOG_ERR_INVALID;
+        }
+
+        size_t base = m_tail_sector * FLASH_LOG_SECTOR_SIZE + m_tail_offset;
+        if (m_io.read(m_io.ctx, base + FLASH_LOG_RECORD_HEADER_SIZE, buf, header.length) != 0) {
+            return FLASH_LOG_ERR_IO;
+        }
+
+        if (crc8(buf, header.length) == header.crc) {
+            *len = header.length;
+            return FLASH_LOG_OK;
+        }
+
+        m_stats.corrupt++;
+        err = skip();
+        if (err != FLASH_LOG_OK) {
+            return err;
+        }
+    }
+
+    return FLASH_LOG_EMPTY;
+}
+
+int flash_log::consume() {
+    if (m_pending == 0) {
+        return FLASH_LOG_EMPTY;
+    }
+
+    int err = skip();
+    if (err == FLASH_LOG_OK) {
+        m_stats.replayed++;
+    }
+
+    return err;
+}
+
+/**
+ * @brief Mark the record at the replay position consumed and move on to the next committed one
+ */
+int flash_log::skip() {
+    record_header header;
+    int err = read_record(m_tail_sector, m_tail_offset, &header);
+    if (err != FLASH_LOG_OK) {
+        return err == FLASH_LOG_EMPTY ? FLASH_LOG_ERR_INVALID : err;
+    }
+
+    uint8_t state = FLASH_LOG_RECORD_CONSUMED;
+    size_t base = m_tail_sector * FLASH_LOG_SECTOR_SIZE + m_tail_offset;
+    if (m_io.write(m_io.ctx, base + 2, &state, 1) != 0) {
+        return FLASH_LOG_ERR_IO;
+    }
+
+    m_pending--;
+
+    m_tail_offset += record_size(header.length);
+    bool found = false;
+    if (m_pending > 0) {
+        err = find_committed(&m_tail_sector, &m_tail_offset, &found);
+        if (err != FLASH_LOG_OK) {
+            return err;
+        }
+    }
+    if (!found) {
+        m_tail_sector = m_head_sector;
+        m_tail_offset = m_head_offset;
+    }
+
+    return FLASH_LOG_OK;
+}
+
+int flash_log::walk(flash_log_visitor_t visitor, void* ctx) {
+    uint8_t payload[FLASH_LOG_MAX_RECORD_LENGTH];
+
+    for (size_t i = 1; i <= m_sector_count; i++) {
+        size_t s = (m_head_sector + i) % m_sector_count;
+
+        uint32_t seq;
+        if (read_sector_seq(s, &seq) != FLASH_LOG_OK) {
+            continue;
+        }
+
+        size_t off = FLASH_LOG_SECTOR_HEADER_SIZE;
+        record_header header;
+        int err;
+        while ((err = read_record(s, off, &header)) == FLASH_LOG_OK) {
+            size_t base = s * FLASH_LOG_SECTOR_SIZE + off;
+            if (m_io.read(m_io.ctx, base + FLASH_LOG_RECORD_HEADER_SIZE, payload, header.length) != 0) {
+                return FLASH_LOG_ERR_IO;
+            }
+
+            uint8_t state = crc8(payload, header.length) == header.crc ? header.state : FLASH_LOG_RECORD_ERASED;
+            if (!visitor(ctx, seq, off, state, payload, header.length)) {
+                return FLASH_LOG_OK;
+            }
+
+            off += record_size(header.length);
+        }
+        if (err != FLASH_LOG_EMPTY) {
+            return err;
+        }
+    }
+
+    return FLASH_LOG_OK;
+}
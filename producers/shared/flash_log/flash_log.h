@@ -0,0 +1,138 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Append-only ring log of variable-length records over raw NOR flash, all integers little-endian.
+ *
+ * The log area is split into FLASH_LOG_SECTOR_SIZE sectors that are written strictly in order, wrapping around at the
+ * end, so every sector is erased equally often. Each sector starts with a header:
+ *
+ *   offset 0   uint32  FLASH_LOG_MAGIC
+ *   offset 4   uint8   FLASH_LOG_VERSION
+ *   offset 5   3 bytes reserved, 0xFF
+ *   offset 8   uint32  sector sequence number, one higher than the sector written before it
+ *   offset 12  4 bytes reserved, 0xFF
+ *
+ * followed by records, each padded to a multiple of 4 bytes:
+ *
+ *   offset 0   uint16  payload length, 0xFFFF (erased) marks the end of the sector
+ *   offset 2   uint8   state, see FLASH_LOG_RECORD_*
+ *   offset 3   uint8   CRC-8 (poly 0x07) of the payload
+ *   offset 4   payload
+ *
+ * A record is written with its state left erased, and only then marked committed, so a write torn by a reset is
+ * never replayed. Replaying a record clears more state bits to mark it consumed; flash bits only ever go from 1 to 0
+ * between erases, so neither step needs an erase. When the log wraps onto a sector that still holds records that
+ * weren't replayed, those records are dropped to make room.
+ */
+#define FLASH_LOG_SECTOR_SIZE 4096
+#define FLASH_LOG_MAGIC 0x474C5645  // "EVLG"
+#define FLASH_LOG_VERSION 1
+
+#define FLASH_LOG_SECTOR_HEADER_SIZE 16
+#define FLASH_LOG_RECORD_HEADER_SIZE 4
+#define FLASH_LOG_MAX_RECORD_LENGTH (FLASH_LOG_SECTOR_SIZE - FLASH_LOG_SECTOR_HEADER_SIZE - FLASH_LOG_RECORD_HEADER_SIZE)
+
+#define FLASH_LOG_RECORD_ERASED 0xFF
+#define FLASH_LOG_RECORD_COMMITTED 0xFE
+#define FLASH_LOG_RECORD_CONSUMED 0xFC
+
+#define FLASH_LOG_OK 0
+#define FLASH_LOG_EMPTY 1
+#define FLASH_LOG_ERR_IO -1
+#define FLASH_LOG_ERR_INVALID -2
+
+/**
+ * @brief Raw storage underneath a log, an esp_partition on the device or a memory buffer or file on a host
+ *
+ * Every function returns 0 on success. `size` must be a multiple of FLASH_LOG_SECTOR_SIZE, and writes must behave
+ * like NOR flash: they can only clear bits.
+ */
+typedef struct {
+    void* ctx;
+    size_t size;
+    int (*read)(void* ctx, size_t offset, void* dst, size_t len);
+    int (*write)(void* ctx, size_t offset, const void* src, size_t len);
+    int (*erase_sector)(void* ctx, size_t offset);
+} flash_log_io_t;
+
+typedef struct {
+    uint32_t appended;
+    uint32_t replayed;
+    uint32_t dropped;  // overwritten before they were replayed
+    uint32_t corrupt;  // skipped because their CRC didn't match
+} flash_log_stats_t;
+
+/**
+ * @brief Called by `flash_log::walk` for every record, oldest first; torn records and records whose CRC doesn't match
+ * are reported with state FLASH_LOG_RECORD_ERASED
+ *
+ * @return false to stop walking
+ */
+typedef bool (*flash_log_visitor_t)(void* ctx, uint32_t sector_seq, size_t offset, uint8_t state,
+                                    const uint8_t* payload, size_t len);
+
+/**
+ * @brief Store-and-forward log; not thread safe, meant to be owned by a single task
+ */
+class flash_log {
+   public:
+    /**
+     * @brief Attach to `io`, recovering the write and replay positions, or formatting it if it holds no log yet
+     */
+    int mount(const flash_log_io_t& io);
+
+    /** @brief Append a record of at most FLASH_LOG_MAX_RECORD_LENGTH bytes */
+    int append(const uint8_t* data, size_t len);
+
+    /**
+     * @brief Read the oldest record that hasn't been replayed yet, without consuming it
+     *
+     * @return FLASH_LOG_EMPTY if there is none
+     */
+    int peek(uint8_t* buf, size_t cap, size_t* len);
+
+    /** @brief Mark the record returned by the last `peek` as replayed */
+    int consume();
+
+    /** @brief Visit every record still in the log, replayed or not, without modifying anything */
+    int walk(flash_log_visitor_t visitor, void* ctx);
+
+    bool empty() const { return m_pending == 0; }
+    uint32_t pending() const { return m_pending; }
+    const flash_log_stats_t& stats() const { return m_stats; }
+
+    static uint8_t crc8(const uint8_t* data, size_t len);
+
+   private:
+    struct record_header {
+        uint16_t length;
+        uint8_t state;
+        uint8_t crc;
+    };
+
+    static size_t record_size(size_t len) { return (FLASH_LOG_RECORD_HEADER_SIZE + len + 3) & ~(size_t)3; }
+
+    int read_sector_seq(size_t sector, uint32_t* seq);
+    int read_record(size_t sector, size_t offset, record_header* header);
+    size_t sector_end(size_t sector) const;
+    int find_committed(size_t* sector, size_t* offset, bool* found);
+    int count_committed(size_t sector, uint32_t* count);
+    int start_sector(size_t sector);
+    int skip();
+
+    flash_log_io_t m_io = {};
+    size_t m_sector_count = 0;
+
+    size_t m_head_sector = 0;
+    size_t m_head_offset = 0;
+    uint32_t m_head_seq = 0;
+
+    size_t m_tail_sector = 0;
+    size_t m_tail_offset = 0;
+
+    uint32_t m_pending = 0;
+    flash_log_stats_t m_stats = {};
+};
@@ -0,0 +1,31 @@
+#include "flash_log_partition.h"
+
+#include "esp_partition.h"
+
+static int partition_read(void* ctx, size_t offset, void* dst, size_t len) {
+    return esp_partition_read((const esp_partition_t*)ctx, offset, dst, len);
+}
+
+static int partition_write(void* ctx, size_t offset, const void* src, size_t len) {
+    return esp_partition_write((const esp_partition_t*)ctx, offset, src, len);
+}
+
+static int partition_erase_sector(void* ctx, size_t offset) {
+    return esp_partition_erase_range((const esp_partition_t*)ctx, offset, FLASH_LOG_SECTOR_SIZE);
+}
+
+esp_err_t flash_log_partition_io(const char* label, flash_log_io_t* io) {
+    const esp_partition_t* partition =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (partition == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    io->ctx = (void*)partition;
+    io->size = partition->size - partition->size % FLASH_LOG_SECTOR_SIZE;
+    io->read = partition_read;
+    io->write = partition_write;
+    io->erase_sector = partition_erase_sector;
+
+    return ESP_OK;
+}
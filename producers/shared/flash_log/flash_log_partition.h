@@ -0,0 +1,9 @@
+#pragma once
+
+#include "esp_err.h"
+#include "flash_log.h"
+
+/**
+ * @brief Back a flash_log with the data partition labelled `label` from the partition table
+ */
+esp_err_t flash_log_partition_io(const char* label, flash_log_io_t* io);
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "producer_event.h"
+
+/*
+ * Wire format of a batch, all integers little-endian:
+ *
+ *   offset 0  int64   timestamp of the first record, microseconds since boot
+ *   offset 8  records, 5 bytes each:
+ *               uint16  microseconds since the first record
+ *               uint8   key (MIDI note number)
+ *               uint8   state (KEY_UP / KEY_DOWN)
+ *               uint8   velocity
+ */
+#define KEY_BATCH_HEADER_SIZE 8
+#define KEY_BATCH_RECORD_SIZE 5
+
+// largest offset a record can carry, a batch is cut early rather than overflow it
+#define KEY_BATCH_MAX_DELTA_US 0xFFFF
+
+/**
+ * @brief Gathers key events for a fixed time window, or until `N` have been collected, so that they can go out as a
+ * single message instead of one message each
+ *
+ * Not thread safe, meant to be owned by the publisher task.
+ *
+ * @tparam N maximum number of records in a batch
+ */
+template <size_t N>
+class key_batch {
+   public:
+    static constexpr size_t MAX_BODY_LENGTH = KEY_BATCH_HEADER_SIZE + N * KEY_BATCH_RECORD_SIZE;
+
+    explicit key_batch(int64_t window_us)
+        : m_window_us(window_us < KEY_BATCH_MAX_DELTA_US ? window_us : KEY_BATCH_MAX_DELTA_US) {}
+
+    /**
+     * @brief Add a key event to the batch
+     *
+     * @return false if the batch is full, or the event is too far from the first record, in which case the batch has
+     * to be encoded before trying again
+     */
+    bool add(int64_t timestamp_us, const key_event_t& key) {
+        if (m_count == 0) {
+            m_base_us = timestamp_us;
+        } else if (m_count == N || timestamp_us - m_base_us > KEY_BATCH_MAX_DELTA_US || timestamp_us < m_base_us) {
+            return false;
+        }
+
+        m_records[m_count].delta_us = (uint16_t)(timestamp_us - m_base_us);
+        m_records[m_count].key = key;
+        m_count++;
+
+        return true;
+    }
+
+    bool empty() const { return m_count == 0; }
+    bool full() const { return m_count == N; }
+    size_t count() const { return m_count; }
+
+    /** @brief Timestamp of the first record in the current batch */
+    int64_t base_us() const { return m_base_us; }
+
+    /** @brief Time at which the current batch has to go out, only meaningful when not empty */
+    int64_t deadline_us() const { return m_base_us + m_window_us; }
+
+    /** @brief Whether the window of the current batch has elapsed */
+    bool due(int64_t now_us) const { return m_count > 0 && now_us >= deadline_us(); }
+
+    /**
+     * @brief Write the batch in wire format into `buf`, which must hold `MAX_BODY_LENGTH` bytes, and start a new batch
+     *
+     * @return number of bytes written
+     */
+    size_t encode(uint8_t* buf) {
+        put_le(buf, (uint64_t)m_base_us, 8);
+
+        uint8_t* p = buf + KEY_BATCH_HEADER_SIZE;
+        for (size_t i = 0; i < m_count; i++) {
+            put_le(p, m_records[i].delta_us, 2);
+            p[2] = m_records[i].key.key;
+            p[3] = m_records[i].key.state;
+            p[4] = m_records[i].key.velocity;
+            p += KEY_BATCH_RECORD_SIZE;
+        }
+
+        size_t len = p - buf;
+        m_count = 0;
+
+        return len;
+    }
+
+   private:
+    static void put_le(uint8_t* p, uint64_t v, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            p[i] = (uint8_t)(v >> (8 * i));
+        }
+    }
+
+    struct record {
+        uint16_t delta_us;
+        key_event_t key;
+    };
+
+    int64_t m_window_us;
+    int64_t m_base_us = 0;
+    size_t m_count = 0;
+    record m_records[N];
+};
+
+/**
+ * @brief Read record `i` back out of a batch in wire format, for consumers of the batched topic
+ *
+ * @return false if `buf` is too short to hold record `i`
+ */
+static inline bool key_batch_read(const uint8_t* buf, size_t len, size_t i, int64_t* timestamp_us, key_event_t* key) {
+    if (len < KEY_BATCH_HEADER_SIZE + (i + 1) * KEY_BATCH_RECORD_SIZE) {
+        return false;
+    }
+
+    uint64_t base = 0;
+    for (size_t b = 0; b < 8; b++) {
+        base |= (uint64_t)buf[b] << (8 * b);
+    }
+
+    const uint8_t* p = buf + KEY_BATCH_HEADER_SIZE + i * KEY_BATCH_RECORD_SIZE;
+    *timestamp_us = (int64_t)base + (p[0] | (p[1] << 8));
+    key->key = p[2];
+    key->state = p[3];
+    key->velocity = p[4];
+
+    return true;
+}
+
+/** @brief Number of records in a batch of `len` bytes */
+static inline size_t key_batch_count(size_t len) {
+    return len < KEY_BATCH_HEADER_SIZE ? 0 : (len - KEY_BATCH_HEADER_SIZE) / KEY_BATCH_RECORD_SIZE;
+}
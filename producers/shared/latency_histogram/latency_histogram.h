@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+
+/*
+ * Log-linear (HDR-style) bucketing: values below 2^LATENCY_HISTOGRAM_SUB_BITS get a bucket each, above that every
+ * power of two is split into 2^(LATENCY_HISTOGRAM_SUB_BITS - 1) equal buckets, which bounds the relative error of a
+ * reported percentile to 1 / 2^(LATENCY_HISTOGRAM_SUB_BITS - 1), 12.5% at the default. Any uint32 value fits.
+ */
+#define LATENCY_HISTOGRAM_SUB_BITS 4
+#define LATENCY_HISTOGRAM_HALF (1 << (LATENCY_HISTOGRAM_SUB_BITS - 1))
+#define LATENCY_HISTOGRAM_BUCKETS ((32 - LATENCY_HISTOGRAM_SUB_BITS + 2) * LATENCY_HISTOGRAM_HALF)
+
+typedef struct {
+    uint32_t count;
+    uint32_t p50_us;
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} latency_summary_t;
+
+/**
+ * @brief Fixed-size latency histogram; `record` is wait-free and may be called from any number of tasks while another
+ * one drains it
+ */
+class latency_histogram {
+   public:
+    void record(int64_t value_us) {
+        uint32_t v = value_us < 0 ? 0 : value_us > UINT32_MAX ? UINT32_MAX : (uint32_t)value_us;
+
+        m_buckets[bucket_of(v)].fetch_add(1, std::memory_order_relaxed);
+
+        uint32_t max = m_max.load(std::memory_order_relaxed);
+        while (v > max && !m_max.compare_exchange_weak(max, v, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * @brief Summarize everything recorded since the last drain and start over
+     *
+     * Values recorded while draining land in either this window or the next one, none are lost.
+     */
+    void drain(latency_summary_t* summary) {
+        uint32_t counts[LATENCY_HISTOGRAM_BUCKETS];
+        uint32_t total = 0;
+        for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+            counts[i] = m_buckets[i].exchange(0, std::memory_order_relaxed);
+            total += counts[i];
+        }
+
+        summary->count = total;
+        summary->max_us = m_max.exchange(0, std::memory_order_relaxed);
+        // a bucket's top can lie above anything actually recorded in it
+        summary->p50_us = std::min(percentile(counts, total, 50), summary->max_us);
+        summary->p90_us = std::min(percentile(counts, total, 90), summary->max_us);
+        summary->p99_us = std::min(percentile(counts, total, 99), summary->max_us);
+    }
+
+    static size_t bucket_of(uint32_t v) {
+        if (v < (1u << LATENCY_HISTOGRAM_SUB_BITS)) {
+            return v;
+        }
+
+        int msb = 31 - __builtin_clz(v);
+        int shift = msb - (LATENCY_HISTOGRAM_SUB_BITS - 1);
+        return shift * LATENCY_HISTOGRAM_HALF + (v >> shift);
+    }
+
+    /** @brief Largest value that falls into bucket `i` */
+    static uint32_t bucket_top(size_t i) {
+        if (i < (1u << LATENCY_HISTOGRAM_SUB_BITS)) {
+            return i;
+        }
+
+        int shift = i / LATENCY_HISTOGRAM_HALF - 1;
+        uint64_t bottom = (uint64_t)(i - shift * LATENCY_HISTOGRAM_HALF) << shift;
+        uint64_t top = bottom + (1ull << shift) - 1;
+        return top > UINT32_MAX ? UINT32_MAX : (uint32_t)top;
+    }
+
+   private:
+    static uint32_t percentile(const uint32_t* counts, uint32_t total, uint32_t pct) {
+        if (total == 0) {
+            return 0;
+        }
+
+        uint64_t rank = ((uint64_t)total * pct + 99) / 100;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return bucket_top(i);
+            }
+        }
+
+        return bucket_top(LATENCY_HISTOGRAM_BUCKETS - 1);
+    }
+
+    std::atomic<uint32_t> m_buckets[LATENCY_HISTOGRAM_BUCKETS] = {};
+    std::atomic<uint32_t> m_max{0};
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "event_ring.h"
+
+#define EVENT_ID_LENGTH 32
+#define EVENT_BODY_LENGTH 96
+
+// must be a power of two
+#define EVENT_RING_CAPACITY 64
+
+typedef enum : uint8_t {
+    EVENT_TEXT = 0,     // preformatted `body`
+    EVENT_KEY = 1,      // piano key transition in `key`
+    EVENT_CONTROL = 2,  // MIDI control change in `control`, e.g. the sustain pedal
+} event_kind_t;
+
+#define KEY_UP 0
+#define KEY_DOWN 1
+
+typedef struct {
+    uint8_t key;  // MIDI note number, 60 is middle C
+    uint8_t state;
+    uint8_t velocity;
+} key_event_t;
+
+typedef struct {
+    uint8_t controller;  // MIDI controller number, 64 is the sustain pedal
+    uint8_t value;
+} control_event_t;
+
+/**
+ * @brief When an event passed through each stage on its way to the publisher, all esp_timer_get_time() microseconds;
+ * 0 for stages the event's source doesn't have
+ */
+typedef struct {
+    int64_t received_us;  // raw data arrived, e.g. a bluetooth notification
+    int64_t decoded_us;   // raw data turned into this event
+} event_stamps_t;
+
+/**
+ * @brief A single event waiting to be published, published to topic `DEVICE_ID/event_id`
+ */
+typedef struct {
+    int64_t timestamp_us;
+    event_stamps_t stamps;
+    event_kind_t kind;
+    char event_id[EVENT_ID_LENGTH];
+    union {
+        char body[EVENT_BODY_LENGTH];
+        key_event_t key;
+        control_event_t control;
+    };
+} producer_event_t;
+
+typedef event_ring<producer_event_t, EVENT_RING_CAPACITY> producer_event_ring_t;
+
+/**
+ * @brief Write the text message body for `event`, e.g. "60 up" for a key event or "64 127" for a control change
+ *
+ * @return number of characters written, as snprintf
+ */
+static inline int format_event_body(const producer_event_t* event, char* buf, size_t len) {
+    switch (event->kind) {
+        case EVENT_KEY:
+            return snprintf(buf, len, "%u %s", event->key.key, event->key.state == KEY_DOWN ? "down" : "up");
+        case EVENT_CONTROL:
+            return snprintf(buf, len, "%u %u", event->control.controller, event->control.value);
+        case EVENT_TEXT:
+        default:
+            return snprintf(buf, len, "%s", event->body);
+    }
+}
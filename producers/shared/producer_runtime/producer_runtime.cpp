@@ -0,0 +1,209 @@
+#include "producer_runtime.h"
+
+#include <atomic>
+
+#include "esp_timer.h"
+
+typedef struct {
+    const char* name;
+    sensor_check_t check;
+    producer_event_ring_t* ring;
+    esp_timer_handle_t timer;  // timer sensors only
+    TaskHandle_t task;         // gpio sensors only
+} sensor_t;
+
+static TaskHandle_t s_publisher = NULL;
+static esp_timer_handle_t s_publisher_timer = NULL;
+static std::atomic<int64_t> s_publisher_wake_at{INT64_MAX};  // INT64_MAX while the timer isn't armed
+
+static sensor_t s_sensors[RUNTIME_MAX_SENSORS];
+static int s_sensor_count = 0;
+static bool s_isr_service_installed = false;
+
+static esp_timer_handle_t s_blink_timer = NULL;
+static gpio_num_t s_blink_pin;
+static bool s_blink_on = false;
+
+static std::atomic<uint32_t> s_publisher_wakeups{0};
+static std::atomic<uint32_t> s_timer_wakeups{0};
+static std::atomic<uint32_t> s_gpio_wakeups{0};
+static std::atomic<uint32_t> s_notify_wakeups{0};
+
+static void run_sensor(sensor_t* sensor) {
+    int64_t woke_us = esp_timer_get_time();
+
+    producer_event_t event;
+    if (sensor->check(&event)) {
+        event.stamps.received_us = woke_us;
+        event.stamps.decoded_us = esp_timer_get_time();
+
+        // never blocks: if the publisher has fallen behind the event is dropped and counted by the ring
+        sensor->ring->push(event);
+        xTaskNotifyGive(s_publisher);
+    }
+}
+
+static void publisher_timer_callback(void* arg) {
+    s_publisher_wake_at.store(INT64_MAX, std::memory_order_relaxed);
+    xTaskNotifyGive(s_publisher);
+}
+
+static void timer_sensor_callback(void* arg) {
+    s_timer_wakeups.fetch_add(1, std::memory_order_relaxed);
+    run_sensor((sensor_t*)arg);
+}
+
+static void IRAM_ATTR gpio_sensor_isr(void* arg) {
+    sensor_t* sensor = (sensor_t*)arg;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(sensor->task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void gpio_sensor_task(void* param) {
+    sensor_t* sensor = (sensor_t*)param;
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        s_gpio_wakeups.fetch_add(1, std::memory_order_relaxed);
+        run_sensor(sensor);
+    }
+}
+
+static void blink_timer_callback(void* arg) {
+    s_blink_on = !s_blink_on;
+    gpio_set_level(s_blink_pin, s_blink_on ? 1 : 0);
+}
+
+static sensor_t* new_sensor(const char* name, sensor_check_t check, producer_event_ring_t* ring) {
+    if (s_publisher == NULL || s_sensor_count == RUNTIME_MAX_SENSORS) {
+        return NULL;
+    }
+
+    sensor_t* sensor = &s_sensors[s_sensor_count++];
+    sensor->name = name;
+    sensor->check = check;
+    sensor->ring = ring;
+    sensor->timer = NULL;
+    sensor->task = NULL;
+
+    return sensor;
+}
+
+esp_err_t runtime_init(TaskHandle_t publisher) {
+    if (publisher == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_publisher = publisher;
+
+    esp_timer_create_args_t args = {};
+    args.callback = publisher_timer_callback;
+    args.name = "publisher";
+
+    return esp_timer_create(&args, &s_publisher_timer);
+}
+
+esp_err_t runtime_add_timer_sensor(const char* name, uint64_t period_us, sensor_check_t check,
+                                   producer_event_ring_t* ring) {
+    sensor_t* sensor = new_sensor(name, check, ring);
+    if (sensor == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_timer_create_args_t args = {};
+    args.callback = timer_sensor_callback;
+    args.arg = sensor;
+    args.name = name;
+
+    esp_err_t err = esp_timer_create(&args, &sensor->timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    return esp_timer_start_periodic(sensor->timer, period_us);
+}
+
+esp_err_t runtime_add_gpio_sensor(const char* name, gpio_num_t pin, gpio_int_type_t edge, sensor_check_t check,
+                                  producer_event_ring_t* ring) {
+    sensor_t* sensor = new_sensor(name, check, ring);
+    if (sensor == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (xTaskCreate(gpio_sensor_task, name, 4096, sensor, RUNTIME_GPIO_SENSOR_PRIORITY, &sensor->task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (!s_isr_service_installed) {
+        esp_err_t err = gpio_install_isr_service(0);
+        if (err != ESP_OK) {
+            return err;
+        }
+        s_isr_service_installed = true;
+    }
+
+    gpio_config_t io_conf = {};
+    io_conf.intr_type = edge;
+    io_conf.mode = GPIO_MODE_INPUT;
+    io_conf.pin_bit_mask = 1ULL << pin;
+    io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    io_conf.pull_up_en = GPIO_PULLUP_DISABLE;
+    esp_err_t err = gpio_config(&io_conf);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    return gpio_isr_handler_add(pin, gpio_sensor_isr, sensor);
+}
+
+esp_err_t runtime_start_blink(gpio_num_t pin, uint64_t period_us) {
+    s_blink_pin = pin;
+
+    esp_timer_create_args_t args = {};
+    args.callback = blink_timer_callback;
+    args.name = "blink";
+
+    esp_err_t err = esp_timer_create(&args, &s_blink_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    return esp_timer_start_periodic(s_blink_timer, period_us);
+}
+
+void runtime_notify_publisher() {
+    // sources may come up before the publisher does
+    if (s_publisher == NULL) {
+        return;
+    }
+
+    s_notify_wakeups.fetch_add(1, std::memory_order_relaxed);
+    xTaskNotifyGive(s_publisher);
+}
+
+void runtime_wake_publisher_at(int64_t at_us) {
+    if (at_us >= s_publisher_wake_at.load(std::memory_order_relaxed)) {
+        return;
+    }
+    s_publisher_wake_at.store(at_us, std::memory_order_relaxed);
+
+    int64_t delay_us = at_us - esp_timer_get_time();
+
+    // a one-shot timer can't be restarted while it's armed
+    esp_timer_stop(s_publisher_timer);
+    esp_timer_start_once(s_publisher_timer, delay_us > 0 ? delay_us : 0);
+}
+
+bool runtime_wait_for_work(TickType_t timeout) {
+    bool notified = ulTaskNotifyTake(pdTRUE, timeout) > 0;
+    s_publisher_wakeups.fetch_add(1, std::memory_order_relaxed);
+
+    return notified;
+}
+
+void runtime_get_stats(runtime_stats_t* stats) {
+    stats->publisher_wakeups = s_publisher_wakeups.load(std::memory_order_relaxed);
+    stats->timer_wakeups = s_timer_wakeups.load(std::memory_order_relaxed);
+    stats->gpio_wakeups = s_gpio_wakeups.load(std::memory_order_relaxed);
+    stats->notify_wakeups = s_notify_wakeups.load(std::memory_order_relaxed);
+}
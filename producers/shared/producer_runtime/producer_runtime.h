@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "producer_event.h"
+
+// maximum number of timer and gpio sensors combined
+#define RUNTIME_MAX_SENSORS 8
+
+#define RUNTIME_GPIO_SENSOR_PRIORITY 3
+
+/**
+ * @brief Called whenever a sensor's wake source fires; fills in `event` if there is something to publish
+ *
+ * @return whether `event` should be published
+ */
+typedef bool (*sensor_check_t)(producer_event_t* event);
+
+typedef struct {
+    uint32_t publisher_wakeups;
+    uint32_t timer_wakeups;
+    uint32_t gpio_wakeups;
+    uint32_t notify_wakeups;  // explicit runtime_notify_publisher calls, e.g. from bluetooth callbacks
+} runtime_stats_t;
+
+/**
+ * @brief Set up the runtime; every sensor delivers its events to `publisher` through direct-to-task notifications, so
+ * it must be created before any sensor is added
+ */
+esp_err_t runtime_init(TaskHandle_t publisher);
+
+/**
+ * @brief Run `check` every `period_us` from the esp_timer task, pushing its events into `ring`
+ *
+ * All timer sensors share the esp_timer task, so they may share a ring with each other, but not with anything else.
+ */
+esp_err_t runtime_add_timer_sensor(const char* name, uint64_t period_us, sensor_check_t check,
+                                   producer_event_ring_t* ring);
+
+/**
+ * @brief Run `check` on every `edge` interrupt of `pin`, pushing its events into `ring`
+ *
+ * The interrupt only wakes a dedicated task that does the actual check, so `check` is free to do anything a task
+ * can. That task is the sole producer of `ring`.
+ */
+esp_err_t runtime_add_gpio_sensor(const char* name, gpio_num_t pin, gpio_int_type_t edge, sensor_check_t check,
+                                  producer_event_ring_t* ring);
+
+/**
+ * @brief Toggle `pin` every `period_us` from an esp_timer, in place of a polling blink task
+ */
+esp_err_t runtime_start_blink(gpio_num_t pin, uint64_t period_us);
+
+/**
+ * @brief Wake the publisher, for sources that push into a ring on their own, such as bluetooth notifications
+ */
+void runtime_notify_publisher();
+
+/**
+ * @brief Wake the publisher at `at_us` (esp_timer_get_time() time base), unless it's already due to wake up before
+ * then; a later request is dropped, so the publisher has to re-request it every time it wakes while still pending
+ *
+ * Used for deadlines shorter than a FreeRTOS tick, such as a batching window.
+ */
+void runtime_wake_publisher_at(int64_t at_us);
+
+/**
+ * @brief Block the publisher task until a sensor has delivered work, or `timeout` runs out
+ *
+ * @return whether the publisher was notified
+ */
+bool runtime_wait_for_work(TickType_t timeout);
+
+void runtime_get_stats(runtime_stats_t* stats);
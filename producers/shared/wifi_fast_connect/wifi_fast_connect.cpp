@@ -0,0 +1,136 @@
+#include "wifi_fast_connect.h"
+
+#include <string.h>
+
+#include "esp_timer.h"
+#include "nvs.h"
+
+#define CACHE_KEY "ap"
+#define CACHE_VERSION 1
+
+typedef struct {
+    uint8_t version;
+    uint8_t bssid[6];
+    uint8_t channel;
+    esp_netif_ip_info_t ip_info;
+    esp_netif_dns_info_t dns;
+} cache_t;
+
+static cache_t s_cache;
+static bool s_cache_valid = false;
+
+static bool s_directed = false;
+static bool s_got_ip_since_connect = false;
+static fast_connect_stats_t s_stats;
+
+static bool load(cache_t* cache) {
+    nvs_handle_t nvs;
+    if (nvs_open(FAST_CONNECT_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return false;
+    }
+
+    size_t len = sizeof(cache_t);
+    esp_err_t err = nvs_get_blob(nvs, CACHE_KEY, cache, &len);
+    nvs_close(nvs);
+
+    return err == ESP_OK && len == sizeof(cache_t) && cache->version == CACHE_VERSION && cache->channel != 0;
+}
+
+static void store(const cache_t* cache) {
+    nvs_handle_t nvs;
+    if (nvs_open(FAST_CONNECT_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        return;
+    }
+
+    if (cache != NULL) {
+        nvs_set_blob(nvs, CACHE_KEY, cache, sizeof(cache_t));
+    } else {
+        nvs_erase_key(nvs, CACHE_KEY);
+    }
+    nvs_commit(nvs);
+    nvs_close(nvs);
+}
+
+bool fast_connect_begin(esp_netif_t* netif) {
+    s_cache_valid = load(&s_cache);
+    if (!s_cache_valid) {
+        return false;
+    }
+
+    wifi_config_t config;
+    if (esp_wifi_get_config(WIFI_IF_STA, &config) != ESP_OK) {
+        return false;
+    }
+    config.sta.scan_method = WIFI_FAST_SCAN;
+    config.sta.bssid_set = true;
+    memcpy(config.sta.bssid, s_cache.bssid, sizeof(s_cache.bssid));
+    config.sta.channel = s_cache.channel;
+    if (esp_wifi_set_config(WIFI_IF_STA, &config) != ESP_OK) {
+        return false;
+    }
+
+    // the DHCP client has to be stopped before an address can be set, it may already be
+    esp_netif_dhcpc_stop(netif);
+    esp_netif_set_ip_info(netif, &s_cache.ip_info);
+    esp_netif_set_dns_info(netif, ESP_NETIF_DNS_MAIN, &s_cache.dns);
+
+    s_directed = true;
+    s_stats.directed = true;
+
+    return true;
+}
+
+void fast_connect_got_ip(esp_netif_t* netif, const ip_event_got_ip_t* event) {
+    s_got_ip_since_connect = true;
+    if (s_stats.got_ip_us == 0) {
+        s_stats.got_ip_us = esp_timer_get_time();
+    }
+
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        return;
+    }
+
+    cache_t cache = {};
+    cache.version = CACHE_VERSION;
+    memcpy(cache.bssid, ap.bssid, sizeof(cache.bssid));
+    cache.channel = ap.primary;
+    cache.ip_info = event->ip_info;
+    esp_netif_get_dns_info(netif, ESP_NETIF_DNS_MAIN, &cache.dns);
+
+    // only written when something changed, most boots come back to the same access point and address
+    if (s_cache_valid && memcmp(&cache, &s_cache, sizeof(cache_t)) == 0) {
+        return;
+    }
+    store(&cache);
+    s_cache = cache;
+    s_cache_valid = true;
+}
+
+bool fast_connect_disconnected(esp_netif_t* netif) {
+    bool failed = s_directed && !s_got_ip_since_connect;
+    s_got_ip_since_connect = false;
+    if (!failed) {
+        // a connection that worked through the cache is retried through it too
+        return false;
+    }
+
+    store(NULL);
+    s_cache_valid = false;
+    s_directed = false;
+    s_stats.directed = false;
+    s_stats.fell_back = true;
+
+    wifi_config_t config;
+    if (esp_wifi_get_config(WIFI_IF_STA, &config) == ESP_OK) {
+        config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        config.sta.bssid_set = false;
+        config.sta.channel = 0;
+        esp_wifi_set_config(WIFI_IF_STA, &config);
+    }
+    esp_netif_dhcpc_start(netif);
+
+    return true;
+}
+
+void fast_connect_get_stats(fast_connect_stats_t* stats) { *stats = s_stats; }
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+
+/*
+ * Skips the all-channel scan and DHCP on boot by connecting straight to the access point and address of the last
+ * successful connection, kept in NVS namespace FAST_CONNECT_NVS_NAMESPACE. If the directed connect fails, the cache is
+ * dropped and the station goes back to scanning and DHCP.
+ *
+ * The cached address is reused as a static IP without asking the DHCP server, which relies on the router keeping the
+ * device's lease, as home routers do for known MAC addresses.
+ *
+ * Everything here runs in app_main or the default event loop task, NVS has to be initialized first.
+ */
+
+#define FAST_CONNECT_NVS_NAMESPACE "fastconn"
+
+typedef struct {
+    bool directed;       // whether this boot connected (or is connecting) through the cache
+    bool fell_back;      // the directed connect failed and the station went back to scanning
+    int64_t got_ip_us;   // first IP address since boot, esp_timer_get_time() microseconds, 0 until then
+} fast_connect_stats_t;
+
+/**
+ * @brief Apply the cached access point and address, if there are any, on top of the station config already set on
+ * `netif`; call between esp_wifi_set_config and esp_wifi_start
+ *
+ * @return whether the cache was applied
+ */
+bool fast_connect_begin(esp_netif_t* netif);
+
+/**
+ * @brief Remember the access point and address of a connection, call on IP_EVENT_STA_GOT_IP
+ */
+void fast_connect_got_ip(esp_netif_t* netif, const ip_event_got_ip_t* event);
+
+/**
+ * @brief Call on WIFI_EVENT_STA_DISCONNECTED; if the directed connect didn't get as far as an address, forgets the
+ * cache and restores scanning and DHCP
+ *
+ * @return whether it fell back, in which case the caller should connect again right away without counting a retry
+ */
+bool fast_connect_disconnected(esp_netif_t* netif);
+
+void fast_connect_get_stats(fast_connect_stats_t* stats);
@@ -17,8 +17,12 @@
 #include "lwip/err.h"
 #include "lwip/sockets.h"
 #include "lwip/sys.h"
+#include "event_codec.h"
 #include "mqtt_client.h"
 #include "nvs_flash.h"
+#include "producer_event.h"
+#include "producer_runtime.h"
+#include "wifi_fast_connect.h"
 
 #define LED_BUILTIN GPIO_NUM_1
 
@@ -34,41 +38,52 @@ esp_netif_t* sta_netif = NULL;
 #define MAX_RETRY 3
 static int s_retry_num = 0;
 
-unsigned long last_blink = 0;
-bool on = false;
-
 esp_mqtt_client_handle_t mqtt_client;
 
-#define MQTT_EVENT_ID_LENGTH 128
-char mqtt_event_id[MQTT_EVENT_ID_LENGTH];
-
 #define MQTT_TOPIC_LENGTH 256
 char mqtt_topic[MQTT_TOPIC_LENGTH];
 
-#define MQTT_BODY_LENGTH 1024
-char mqtt_body[MQTT_BODY_LENGTH];
+uint8_t mqtt_body_binary[EVENT_FRAME_MAX_LENGTH];
+uint32_t event_seq = 0;
 
-unsigned long last_uptime_ping = 0;
+#define MQTT_BODY_LENGTH 256
+char mqtt_body_boot[MQTT_BODY_LENGTH];
+static bool boot_reported = false;
+
+// filled by the sensor task, drained by the publisher task
+static producer_event_ring_t sensor_events;
 
 // /configurations ------------------------------------------------
 
 #define BLINK true
 
-#define BLINK_PRIORITY 1
-#define SENSOR_PRIORITY 2
+#define BLINK_PERIOD_MS 500
+#define UPTIME_PERIOD_MS 1000
+
+#define PUBLISHER_PRIORITY 2
 
 // 0 - at most once (unreliable)
 // 1 - at least once (requires indempotency) (DEFAULT)
 // 2 - exactly once (slow)
 #define MQTT_QOS 1
 
+// false - text bodies on `DEVICE_ID/<event>`, e.g. "1234"
+// true - binary event_codec frames on `DEVICE_ID/bin/<event>`
+#define EVENT_FORMAT_BINARY false
+
+// connect to the access point and address of the last boot without scanning or DHCP, see wifi_fast_connect.h
+#define WIFI_FAST_CONNECT true
+
 // configurations -------------------------------------------------
 
 static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
         esp_wifi_connect();
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        if (s_retry_num < MAX_RETRY) {
+        if (fast_connect_disconnected(sta_netif)) {
+            // the cached access point is gone, scanning for it isn't a retry
+            esp_wifi_connect();
+        } else if (s_retry_num < MAX_RETRY) {
             esp_wifi_connect();
             s_retry_num++;
         } else {
@@ -76,6 +91,7 @@ static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_
         }
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*)event_data;
+        fast_connect_got_ip(sta_netif, event);
         s_retry_num = 0;
         xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
     }
@@ -87,7 +103,7 @@ static void wifi_init() {
     ESP_ERROR_CHECK(esp_netif_init());
 
     ESP_ERROR_CHECK(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
+    sta_netif = esp_netif_create_default_wifi_sta();
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -105,74 +121,87 @@ static void wifi_init() {
 
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    if (WIFI_FAST_CONNECT) {
+        fast_connect_begin(sta_netif);
+    }
     ESP_ERROR_CHECK(esp_wifi_start());
 
     connected = true;
 }
 
+/**
+ * @brief Create the client, it's started once there is an IP address
+ */
 static void mqtt_init() {
     esp_mqtt_client_config_t mqtt_cfg = {};
     memset((void*)&mqtt_cfg, 0, sizeof(esp_mqtt_client_config_t));
     mqtt_cfg.uri = MQTT_ADDRESS;
 
     mqtt_client = esp_mqtt_client_init(&mqtt_cfg);
-    esp_mqtt_client_start(mqtt_client);
 }
 
-void blink_loop() {
-    int64_t cur_millis = esp_timer_get_time() / 1000;
-    if (cur_millis - last_blink >= 500) {
-        last_blink = cur_millis;
-        if (on) {
-            gpio_set_level(LED_BUILTIN, 0);
-        } else {
-            gpio_set_level(LED_BUILTIN, 1);
-        }
-
-        on = !on;
-    }
-}
+/**
+ * @brief Perform the check of whatever event source the module uses, and if an event should be published, fills in
+ * `event` appropriately; called by the runtime every time the sensor's wake source fires
+ *
+ * @return whether the module should publish an event
+ */
+bool check_sensor(producer_event_t* event) {
+    int64_t cur_micros = esp_timer_get_time();
 
-void blink_loop_task(void* param) {
-    while (true) {
-        blink_loop();
+    event->timestamp_us = cur_micros;
+    event->kind = EVENT_TEXT;
+    snprintf(event->event_id, EVENT_ID_LENGTH, "uptime");
+    snprintf(event->body, EVENT_BODY_LENGTH, "%lld", (long long)(cur_micros / 1000));
 
-        vTaskDelay(pdMS_TO_TICKS(1));
-    }
+    return true;
 }
 
 /**
- * @brief Perform the check of whatever event source the module uses, and if an event should be published, sets the
- * `mqtt_event_id` and `mqtt_body` strings appropriately
- *
- * @return whether the module should publish an event
+ * @brief Publish how long it took from boot to the first event, once, on `DEVICE_ID/boot`, e.g.
+ * {"wifi":"cached","got_ip_ms":112,"first_publish_ms":131}
  */
-bool check_sensor() {
-    int64_t cur_millis = esp_timer_get_time() / 1000;
-    if (cur_millis - last_uptime_ping >= 1000) {
-        last_uptime_ping = cur_millis;
+void report_boot(int64_t first_publish_us) {
+    fast_connect_stats_t wifi;
+    fast_connect_get_stats(&wifi);
 
-        sprintf(mqtt_event_id, "uptime");
-        sprintf(mqtt_body, "%llu", cur_millis);
+    snprintf(mqtt_body_boot, MQTT_BODY_LENGTH, "{\"wifi\":\"%s\",\"got_ip_ms\":%lld,\"first_publish_ms\":%lld}",
+             wifi.directed ? "cached" : wifi.fell_back ? "fallback" : "scan", (long long)(wifi.got_ip_us / 1000),
+             (long long)(first_publish_us / 1000));
+    snprintf(mqtt_topic, MQTT_TOPIC_LENGTH, "%s/boot", DEVICE_ID);
+    esp_mqtt_client_publish(mqtt_client, mqtt_topic, mqtt_body_boot, 0, MQTT_QOS, 0);
+
+    boot_reported = true;
+}
 
-        return true;
+void publish_event(const producer_event_t* event) {
+    int msg_id;
+    if (EVENT_FORMAT_BINARY) {
+        snprintf(mqtt_topic, MQTT_TOPIC_LENGTH, "%s/%s/%s", DEVICE_ID, EVENT_BINARY_TOPIC_SEGMENT, event->event_id);
+        size_t len = event_encode(event, event_seq++, mqtt_body_binary, EVENT_FRAME_MAX_LENGTH);
+        msg_id = esp_mqtt_client_publish(mqtt_client, mqtt_topic, (const char*)mqtt_body_binary, len, MQTT_QOS, 0);
+    } else {
+        snprintf(mqtt_topic, MQTT_TOPIC_LENGTH, "%s/%s", DEVICE_ID, event->event_id);
+        msg_id = esp_mqtt_client_publish(mqtt_client, mqtt_topic, event->body, 0, MQTT_QOS, 0);
     }
 
-    return false;
+    if (!boot_reported && msg_id >= 0) {
+        report_boot(esp_timer_get_time());
+    }
 }
 
-void sensor_loop() {
-    if (check_sensor()) {
-        sprintf(mqtt_topic, "%s/%s", DEVICE_ID, mqtt_event_id);
-        esp_mqtt_client_publish(mqtt_client, mqtt_topic, mqtt_body, 0, MQTT_QOS, 0);
+void publisher_loop() {
+    producer_event_t event;
+    while (sensor_events.pop(&event)) {
+        publish_event(&event);
     }
 }
 
-void sensor_loop_task(void* param) {
+void publisher_loop_task(void* param) {
     while (true) {
-        sensor_loop();
+        runtime_wait_for_work(portMAX_DELAY);
 
-        vTaskDelay(pdMS_TO_TICKS(1));
+        publisher_loop();
     }
 }
 
@@ -201,13 +230,20 @@ void app_main(void) {
     wifi_init();
     mqtt_init();
 
-    // blink loop
+    // publisher loop, sensors wake it up as soon as they have something to publish
+    TaskHandle_t publisher_task;
+    xTaskCreate(publisher_loop_task, "publisher", 10240, NULL, PUBLISHER_PRIORITY, &publisher_task);
+    ESP_ERROR_CHECK(runtime_init(publisher_task));
+
+    // blink
     if (BLINK) {
-        xTaskCreate(blink_loop_task, "blink", 10240, NULL, BLINK_PRIORITY, NULL);
+        ESP_ERROR_CHECK(runtime_start_blink(LED_BUILTIN, BLINK_PERIOD_MS * 1000));
     }
 
-    // sensor loop
-    xTaskCreate(sensor_loop_task, "sensor", 10240, NULL, SENSOR_PRIORITY, NULL);
+    // sensors
+    ESP_ERROR_CHECK(runtime_add_timer_sensor("uptime", UPTIME_PERIOD_MS * 1000, check_sensor, &sensor_events));
 
-    vTaskDelay(1);
+    // a connect attempt before there is an IP address fails and costs a whole reconnect timeout
+    xEventGroupWaitBits(s_wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT, pdFALSE, pdFALSE, portMAX_DELAY);
+    esp_mqtt_client_start(mqtt_client);
 }
@@ -0,0 +1,100 @@
+/*
+ * Prints the events stored in a raw dump of a producer's event log partition, oldest first.
+ *
+ * Dump the partition with e.g.
+ *   parttool.py --port /dev/ttyUSB0 read_partition --partition-name evlog --output evlog.bin
+ *
+ * and print it with ./build/flash_log_dump evlog.bin, built along with the host simulation in producers/host_sim.
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "event_log.h"
+#include "flash_log.h"
+
+typedef struct {
+    uint8_t* data;
+    size_t size;
+} dump_t;
+
+static int dump_read(void* ctx, size_t offset, void* dst, size_t len) {
+    dump_t* dump = (dump_t*)ctx;
+    if (offset + len > dump->size) {
+        return -1;
+    }
+    memcpy(dst, dump->data + offset, len);
+    return 0;
+}
+
+// the dump is only ever read, mounting a dump without a log in it fails here instead of formatting it
+static int dump_write(void*, size_t, const void*, size_t) { return -1; }
+static int dump_erase_sector(void*, size_t) { return -1; }
+
+static const char* state_name(uint8_t state) {
+    switch (state) {
+        case FLASH_LOG_RECORD_COMMITTED:
+            return "pending";
+        case FLASH_LOG_RECORD_CONSUMED:
+            return "replayed";
+        default:
+            return "torn";
+    }
+}
+
+static bool print_record(void*, uint32_t sector_seq, size_t offset, uint8_t state, const uint8_t* payload,
+                         size_t len) {
+    printf("%8" PRIu32 " %5zu %-8s ", sector_seq, offset, state_name(state));
+
+    producer_event_t event;
+    char body[EVENT_BODY_LENGTH];
+    // the stage stamps are only of use on the boot that stored them, so they're left out
+    if (state != FLASH_LOG_RECORD_ERASED && event_log_decode(payload, len, 0, &event)) {
+        format_event_body(&event, body, sizeof(body));
+        printf("%14" PRId64 " %-16s %s\n", event.timestamp_us, event.event_id, body);
+    } else {
+        printf("(%zu bytes)\n", len);
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <partition dump>\n", argv[0]);
+        return 2;
+    }
+
+    FILE* f = fopen(argv[1], "rb");
+    if (f == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    dump_t dump = {(uint8_t*)malloc(size), (size_t)size};
+    if (dump.data == NULL || fread(dump.data, 1, size, f) != (size_t)size) {
+        fprintf(stderr, "failed to read %s\n", argv[1]);
+        return 1;
+    }
+    fclose(f);
+
+    flash_log_io_t io = {&dump, dump.size - dump.size % FLASH_LOG_SECTOR_SIZE, dump_read, dump_write,
+                         dump_erase_sector};
+    flash_log log;
+    if (log.mount(io) != FLASH_LOG_OK) {
+        fprintf(stderr, "no event log in %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("%u events pending replay\n\n", log.pending());
+    printf("  sector  offs state    timestamp (us) event            body\n");
+    int err = log.walk(print_record, NULL);
+
+    free(dump.data);
+    return err == FLASH_LOG_OK ? 0 : 1;
+}